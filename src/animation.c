@@ -0,0 +1,30 @@
+#include "animation.h"
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void animation_clip_init(animation_clip_t* const clip, const fixed_t time_step_s)
+{
+    // Rounded to the nearest step, so that durations which are a whole number of steps are exact despite the
+    // fixed-point step length being truncated
+    const float steps = clip->frame_duration_s / fixed_to_float(time_step_s) + 0.5F;
+    clip->steps_per_frame = steps >= 1.0F ? (uint32_t)steps : 1;
+}
+
+const SDL_Rect* animation_clip_frame(const animation_clip_t* const clip, const uint32_t age_steps)
+{
+    uint32_t frame = age_steps / clip->steps_per_frame;
+    if(clip->loops) {
+        frame %= clip->num_frames;
+    }
+    else if(frame >= clip->num_frames) {
+        frame = clip->num_frames - 1;
+    }
+    return &clip->frames[frame];
+}
+
+uint32_t animation_clip_length(const animation_clip_t* const clip)
+{
+    return clip->num_frames * clip->steps_per_frame;
+}
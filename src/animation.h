@@ -0,0 +1,39 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL_rect.h>
+
+#include "fixed.h"
+
+// ============================================================================
+// Animation clips
+// ============================================================================
+
+// A sequence of sprite frames shared by every entity of an archetype, each
+// shown for the same length of time. Looping clips repeat forever, and one-shot
+// clips hold their last frame once they have played through.
+//
+// Entities only record the simulation step they were spawned on. The frame to
+// draw is worked out from their age whenever it is needed, so nothing has to
+// be updated per entity as time passes.
+typedef struct {
+    const SDL_Rect* frames;
+    uint32_t num_frames;
+    float frame_duration_s;
+    bool loops;
+    // The frame duration in whole simulation steps, set by animation_clip_init()
+    uint32_t steps_per_frame;
+} animation_clip_t;
+
+// Converts the clip's frame duration into simulation steps of the given length, showing every frame for at least one
+void animation_clip_init(animation_clip_t* clip, fixed_t time_step_s);
+
+// Returns the frame to draw for an entity that was spawned the given number of steps ago
+const SDL_Rect* animation_clip_frame(const animation_clip_t* clip, uint32_t age_steps);
+// Returns how many steps the clip takes to play through once
+uint32_t animation_clip_length(const animation_clip_t* clip);
+
+#endif
@@ -0,0 +1,144 @@
+#include "asset_pack.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define ASSET_PACK_MAGIC "SHMP"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_PIXELS_ALIGNMENT 64
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void asset_pack_open(asset_pack_t* const pack, const char* const filename)
+{
+    const int fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        fprintf(stderr, "Failed to open asset pack: \"%s\"\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(asset_pack_header_t)) {
+        fprintf(stderr, "Asset pack is truncated: \"%s\"\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    const size_t size = (size_t)st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED) {
+        fprintf(stderr, "Failed to map asset pack: \"%s\"\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    const uint8_t* bytes = mapping;
+    const asset_pack_header_t* header = mapping;
+    if(memcmp(header->magic, ASSET_PACK_MAGIC, 4) != 0 || header->version != ASSET_PACK_VERSION) {
+        fprintf(stderr, "Not a version %d asset pack: \"%s\"\n", ASSET_PACK_VERSION, filename);
+        exit(EXIT_FAILURE);
+    }
+
+    // Check every table lies within the file before handing out pointers into it
+    const size_t tables_size = sizeof(asset_pack_header_t) + header->num_sheets * sizeof(asset_pack_sheet_t) + header->num_quads * sizeof(SDL_Rect);
+    const size_t pixels_size = (size_t)header->pitch * (size_t)header->height;
+    if(tables_size > header->pixels_offset || header->pixels_offset > size || pixels_size > size - header->pixels_offset) {
+        fprintf(stderr, "Asset pack is truncated: \"%s\"\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    pack->header = header;
+    pack->sheets = (const asset_pack_sheet_t*)(bytes + sizeof(asset_pack_header_t));
+    pack->quads = (const SDL_Rect*)(bytes + sizeof(asset_pack_header_t) + header->num_sheets * sizeof(asset_pack_sheet_t));
+    pack->pixels = bytes + header->pixels_offset;
+    pack->mapping = mapping;
+    pack->mapping_size = size;
+}
+
+void asset_pack_close(asset_pack_t* const pack)
+{
+    if(pack->mapping != NULL) {
+        munmap(pack->mapping, pack->mapping_size);
+    }
+    pack->header = NULL;
+    pack->sheets = NULL;
+    pack->quads = NULL;
+    pack->pixels = NULL;
+    pack->mapping = NULL;
+    pack->mapping_size = 0;
+}
+
+void asset_pack_copy_quads(const asset_pack_t* const pack, const size_t sheet, SDL_Rect* const quads, const size_t num_quads)
+{
+    if(sheet >= pack->header->num_sheets || pack->sheets[sheet].num_quads != num_quads || pack->sheets[sheet].first_quad + num_quads > pack->header->num_quads) {
+        fprintf(stderr, "Asset pack does not hold the %zu sprites of sheet: %zu\n", num_quads, sheet);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(quads, &pack->quads[pack->sheets[sheet].first_quad], num_quads * sizeof(SDL_Rect));
+}
+
+bool asset_pack_write(const char* const filename, const SDL_Surface* const atlas, const atlas_sheet_t* const sheets, const size_t num_sheets)
+{
+    FILE* file = fopen(filename, "wb");
+    if(file == NULL) {
+        fprintf(stderr, "Failed to open asset pack file: \"%s\"\n", filename);
+        return false;
+    }
+
+    asset_pack_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ASSET_PACK_MAGIC, 4);
+    header.version = ASSET_PACK_VERSION;
+    header.pixel_format = atlas->format->format;
+    header.width = atlas->w;
+    header.height = atlas->h;
+    header.pitch = atlas->w * atlas->format->BytesPerPixel;
+    header.num_sheets = (uint32_t)num_sheets;
+    header.num_quads = 0;
+    for(size_t i = 0; i < num_sheets; ++i) {
+        header.num_quads += (uint32_t)sheets[i].num_quads;
+    }
+    const size_t tables_size = sizeof(header) + num_sheets * sizeof(asset_pack_sheet_t) + header.num_quads * sizeof(SDL_Rect);
+    header.pixels_offset = (uint32_t)((tables_size + ASSET_PACK_PIXELS_ALIGNMENT - 1) / ASSET_PACK_PIXELS_ALIGNMENT * ASSET_PACK_PIXELS_ALIGNMENT);
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    uint32_t first_quad = 0;
+    for(size_t i = 0; i < num_sheets && written; ++i) {
+        asset_pack_sheet_t sheet;
+        memset(&sheet, 0, sizeof(sheet));
+        sheet.placement = sheets[i].placement;
+        sheet.first_quad = first_quad;
+        sheet.num_quads = (uint32_t)sheets[i].num_quads;
+        written = fwrite(&sheet, sizeof(sheet), 1, file) == 1;
+        first_quad += sheet.num_quads;
+    }
+    for(size_t i = 0; i < num_sheets && written; ++i) {
+        written = fwrite(sheets[i].quads, sizeof(SDL_Rect), sheets[i].num_quads, file) == sheets[i].num_quads;
+    }
+
+    // Pad up to the pixels, then write them a row at a time, dropping any padding the surface has at the end of each row
+    const uint8_t padding[ASSET_PACK_PIXELS_ALIGNMENT] = { 0 };
+    if(written && header.pixels_offset > tables_size) {
+        written = fwrite(padding, header.pixels_offset - tables_size, 1, file) == 1;
+    }
+    for(int32_t row = 0; row < atlas->h && written; ++row) {
+        written = fwrite((const uint8_t*)atlas->pixels + (size_t)row * (size_t)atlas->pitch, (size_t)header.pitch, 1, file) == 1;
+    }
+
+    if(fclose(file) != 0 || !written) {
+        fprintf(stderr, "Failed to write asset pack file: \"%s\"\n", filename);
+        return false;
+    }
+
+    return true;
+}
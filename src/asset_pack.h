@@ -0,0 +1,69 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_rect.h>
+#include <SDL_surface.h>
+
+#include "atlas.h"
+
+// ============================================================================
+// Pre-decoded asset packs
+// ============================================================================
+
+// An asset pack holds the packed sprite atlas, already decoded into the pixel
+// format its texture is created with, and the quad table of every sheet in
+// atlas coordinates. It is built from the PNGs in data/ by the pack_assets
+// tool, and memory-mapped at startup so that nothing needs to be decoded or
+// converted.
+//
+// The file is a header, followed by the sheet table, the quad table, and the
+// pixel rows, which start on a 64 byte boundary. Fields are stored in the
+// byte order of the machine that built the pack.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t pixel_format;
+    int32_t width;
+    int32_t height;
+    int32_t pitch;
+    uint32_t num_sheets;
+    uint32_t num_quads;
+    uint32_t pixels_offset;
+} asset_pack_header_t;
+
+// Where a sheet was placed within the atlas, and the range of the quad table that holds its sprites
+typedef struct {
+    SDL_Rect placement;
+    uint32_t first_quad;
+    uint32_t num_quads;
+} asset_pack_sheet_t;
+
+// The pack the game and its tools open, which is looked up in the working directory. Building them writes it to the
+// build directory, next to the executables.
+#define ASSET_PACK_FILENAME "shmupsy.pack"
+
+// A mapped asset pack. Every pointer is into the mapping, and stays valid until the pack is closed.
+typedef struct {
+    const asset_pack_header_t* header;
+    const asset_pack_sheet_t* sheets;
+    const SDL_Rect* quads;
+    const void* pixels;
+    void* mapping;
+    size_t mapping_size;
+} asset_pack_t;
+
+// Maps an asset pack into memory, exiting if it is missing or malformed
+void asset_pack_open(asset_pack_t* pack, const char* filename);
+void asset_pack_close(asset_pack_t* pack);
+
+// Copies a sheet's quads into the given table, exiting if the sheet does not hold exactly num_quads of them
+void asset_pack_copy_quads(const asset_pack_t* pack, size_t sheet, SDL_Rect* quads, size_t num_quads);
+
+// Writes an atlas built by atlas_build(), along with its sheets' quad tables, returning whether it succeeded
+bool asset_pack_write(const char* filename, const SDL_Surface* atlas, const atlas_sheet_t* sheets, size_t num_sheets);
+
+#endif
@@ -0,0 +1,110 @@
+#include "atlas.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL_error.h>
+#include <SDL_image.h>
+#include <SDL_pixels.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Transparent border left around every sheet, so that filtering at the edge of
+// a sprite never samples a neighbouring sheet
+#define ATLAS_PADDING 1
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+SDL_Surface* atlas_build(atlas_sheet_t* const sheets, const size_t num_sheets)
+{
+    SDL_Surface** surfaces = calloc(num_sheets, sizeof(SDL_Surface*));
+    size_t* order = calloc(num_sheets, sizeof(size_t));
+    if(surfaces == NULL || order == NULL) {
+        fprintf(stderr, "Failed to allocate an atlas of %zu sheets\n", num_sheets);
+        exit(EXIT_FAILURE);
+    }
+
+    // Load every sheet in a common format, and size the atlas to fit the widest of them
+    int32_t atlas_w = 1;
+    int32_t widest = 0;
+    for(size_t i = 0; i < num_sheets; ++i) {
+        SDL_Surface* loaded = IMG_Load(sheets[i].filename);
+        if(loaded == NULL) {
+            fprintf(stderr, "Failed to load image from: \"%s\": %s\n", sheets[i].filename, IMG_GetError());
+            exit(EXIT_FAILURE);
+        }
+        surfaces[i] = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(loaded);
+        if(surfaces[i] == NULL) {
+            fprintf(stderr, "Failed to convert image: \"%s\": %s\n", sheets[i].filename, SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
+        SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+
+        widest = surfaces[i]->w > widest ? surfaces[i]->w : widest;
+    }
+    while(atlas_w < widest + 2 * ATLAS_PADDING) {
+        atlas_w *= 2;
+    }
+
+    // Pack the sheets onto shelves, tallest first. The sort is stable so that the layout is deterministic.
+    for(size_t i = 0; i < num_sheets; ++i) {
+        size_t j = i;
+        for(; j > 0 && surfaces[order[j - 1]]->h < surfaces[i]->h; --j) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+    int32_t shelf_x = 0;
+    int32_t shelf_y = 0;
+    int32_t shelf_h = 0;
+    for(size_t i = 0; i < num_sheets; ++i) {
+        atlas_sheet_t* sheet = &sheets[order[i]];
+        const SDL_Surface* surface = surfaces[order[i]];
+        const int32_t w = surface->w + 2 * ATLAS_PADDING;
+        const int32_t h = surface->h + 2 * ATLAS_PADDING;
+        if(shelf_x + w > atlas_w) {
+            shelf_y += shelf_h;
+            shelf_x = 0;
+            shelf_h = 0;
+        }
+
+        sheet->placement.x = shelf_x + ATLAS_PADDING;
+        sheet->placement.y = shelf_y + ATLAS_PADDING;
+        sheet->placement.w = surface->w;
+        sheet->placement.h = surface->h;
+
+        shelf_x += w;
+        shelf_h = h > shelf_h ? h : shelf_h;
+    }
+    const int32_t atlas_h = shelf_y + shelf_h;
+
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, atlas_w, atlas_h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if(atlas == NULL) {
+        fprintf(stderr, "Failed to create a %dx%d atlas surface: %s\n", atlas_w, atlas_h, SDL_GetError());
+        exit(EXIT_FAILURE);
+    }
+    SDL_FillRect(atlas, NULL, 0);
+
+    // Copy each sheet into place, and move its quads along with it
+    for(size_t i = 0; i < num_sheets; ++i) {
+        SDL_Rect placement = sheets[i].placement;
+        SDL_BlitSurface(surfaces[i], NULL, atlas, &placement);
+        SDL_FreeSurface(surfaces[i]);
+
+        for(size_t j = 0; j < sheets[i].num_quads; ++j) {
+            sheets[i].quads[j].x += sheets[i].placement.x;
+            sheets[i].quads[j].y += sheets[i].placement.y;
+        }
+    }
+
+    free(order);
+    free(surfaces);
+
+    return atlas;
+}
@@ -0,0 +1,28 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <stddef.h>
+
+#include <SDL_rect.h>
+#include <SDL_surface.h>
+
+// ============================================================================
+// Texture atlas builder
+// ============================================================================
+
+// A sprite sheet to be packed into the atlas, along with the table of sprite
+// quads that index into it
+typedef struct {
+    const char* filename;
+    SDL_Rect* quads;
+    size_t num_quads;
+    // Where the sheet was placed within the atlas, set by atlas_build()
+    SDL_Rect placement;
+} atlas_sheet_t;
+
+// Loads and packs every sheet into a single surface, and remaps each sheet's
+// quad table from sheet coordinates into atlas coordinates. The caller owns the
+// returned surface.
+SDL_Surface* atlas_build(atlas_sheet_t* sheets, size_t num_sheets);
+
+#endif
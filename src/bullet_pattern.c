@@ -0,0 +1,166 @@
+#include "bullet_pattern.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Straight down the screen, since y increases downwards
+#define DOWN_ANGLE (BULLET_ANGLE_HALF_TURN / 2)
+
+#define CORDIC_ITERATIONS 31
+
+// Positions and velocities are widened by this many bits while they are rotated, so that each iteration's shift does not
+// lose the low bits of short vectors
+#define CORDIC_GUARD_BITS 16
+
+// The product of every iteration's scaling, 1 / sqrt(1 + 2^-2i), as a 2.30 fixed-point fraction
+#define CORDIC_GAIN 652032874
+
+// atan(2^-i) as a binary angle, for each iteration i
+static const uint32_t cordic_angles[CORDIC_ITERATIONS] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+    2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+    10430, 5215, 2608, 1304, 652, 326, 163, 81,
+    41, 20, 10, 5, 3, 1, 1
+};
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static uint32_t angle_from_degrees(float degrees);
+static void rotate(fixed_t length, uint32_t angle, fixed_t* x, fixed_t* y);
+static uint32_t direction(fixed_t x, fixed_t y);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void bullet_pattern_init(bullet_pattern_t* const pattern, const fixed_t time_step_s)
+{
+    // Rounded to the nearest step, as animation frame durations are
+    const float steps = pattern->interval_s / fixed_to_float(time_step_s) + 0.5F;
+    pattern->steps_per_volley = steps >= 1.0F ? (uint32_t)steps : 1;
+    pattern->velocity_per_step = fixed_mul(fixed_from_int(pattern->velocity_pps), time_step_s);
+
+    // A full circle spaces the bullets so that the last does not land on the first. Otherwise the outermost bullets are
+    // fired along the edges of the arc.
+    const uint32_t n = pattern->num_bullets;
+    pattern->spin = angle_from_degrees(pattern->spin_deg);
+    if(pattern->arc_deg >= 360.0F) {
+        pattern->first_offset = 0;
+        pattern->spacing = n > 0 ? (uint32_t)((2ULL * BULLET_ANGLE_HALF_TURN) / n) : 0;
+    }
+    else {
+        const uint32_t arc = angle_from_degrees(pattern->arc_deg);
+        pattern->first_offset = 0U - arc / 2;
+        pattern->spacing = n > 1 ? arc / (n - 1) : 0;
+    }
+}
+
+bool bullet_pattern_fires(const bullet_pattern_t* const pattern, const uint32_t age_steps)
+{
+    return (age_steps + 1) % pattern->steps_per_volley == 0;
+}
+
+void bullet_pattern_fire(const bullet_pattern_t* const pattern, const uint32_t age_steps, bullet_pool_t* const pool, const fixed_t x, const fixed_t y, const fixed_t target_x, const fixed_t target_y, const uint32_t step)
+{
+    if(pattern->num_bullets == 0) {
+        return;
+    }
+
+    // Binary angles wrap round a whole turn by themselves
+    uint32_t centre = DOWN_ANGLE;
+    if(pattern->kind == BULLET_PATTERN_SPIRAL) {
+        const uint32_t volley = (age_steps + 1) / pattern->steps_per_volley - 1;
+        centre = DOWN_ANGLE + volley * pattern->spin;
+    }
+    else if(pattern->kind == BULLET_PATTERN_AIMED && (target_x != x || target_y != y)) {
+        centre = direction(target_x - x, target_y - y);
+    }
+
+    const uint32_t n = pattern->num_bullets;
+    const uint32_t first_angle = centre + pattern->first_offset;
+    const size_t first = bullet_pool_push(pool, n);
+    for(uint32_t b = 0; b < n; ++b) {
+        const size_t i = first + b;
+        pool->x[i] = x;
+        pool->y[i] = y;
+        pool->prev_x[i] = x;
+        pool->prev_y[i] = y;
+        rotate(pattern->velocity_per_step, first_angle + pattern->spacing * b, &pool->vx[i], &pool->vy[i]);
+        pool->spawn_step[i] = step;
+    }
+}
+
+static uint32_t angle_from_degrees(const float degrees)
+{
+    // Only read from configuration, and wrapped round a whole turn, so negative angles turn the other way
+    const double turns = (double)degrees / 360.0 * (2.0 * BULLET_ANGLE_HALF_TURN);
+    return (uint32_t)(int64_t)(turns < 0.0 ? turns - 0.5 : turns + 0.5);
+}
+
+static void rotate(const fixed_t length, const uint32_t angle, fixed_t* const x, fixed_t* const y)
+{
+    // CORDIC in rotation mode, which turns (length, 0) to the angle in shifts and adds. It only converges within a quarter
+    // turn of zero, so angles facing left are turned by half a turn first, and the result turned back.
+    int32_t z = (int32_t)angle;
+    int64_t sign = 1;
+    if(z > (int32_t)(BULLET_ANGLE_HALF_TURN / 2) || z < -(int32_t)(BULLET_ANGLE_HALF_TURN / 2)) {
+        z = (int32_t)(angle + BULLET_ANGLE_HALF_TURN);
+        sign = -1;
+    }
+
+    // The length is scaled by the gain up front, so that it comes out unscaled
+    int64_t vx = ((int64_t)length * CORDIC_GAIN) >> (30 - CORDIC_GUARD_BITS);
+    int64_t vy = 0;
+    for(int i = 0; i < CORDIC_ITERATIONS; ++i) {
+        const int64_t dx = vy >> i;
+        const int64_t dy = vx >> i;
+        if(z >= 0) {
+            vx -= dx;
+            vy += dy;
+            z -= (int32_t)cordic_angles[i];
+        }
+        else {
+            vx += dx;
+            vy -= dy;
+            z += (int32_t)cordic_angles[i];
+        }
+    }
+
+    // Rounded to the nearest fixed-point value
+    const int64_t half = (int64_t)1 << (CORDIC_GUARD_BITS - 1);
+    *x = (fixed_t)(sign * ((vx + half) >> CORDIC_GUARD_BITS));
+    *y = (fixed_t)(sign * ((vy + half) >> CORDIC_GUARD_BITS));
+}
+
+static uint32_t direction(const fixed_t x, const fixed_t y)
+{
+    // CORDIC in vectoring mode, which turns the vector onto the positive x axis, adding up how far it was turned. Vectors
+    // facing left are turned by half a turn first, so that it converges.
+    int64_t vx = (int64_t)x * ((int64_t)1 << CORDIC_GUARD_BITS);
+    int64_t vy = (int64_t)y * ((int64_t)1 << CORDIC_GUARD_BITS);
+    uint32_t angle = 0;
+    if(vx < 0) {
+        vx = -vx;
+        vy = -vy;
+        angle = BULLET_ANGLE_HALF_TURN;
+    }
+
+    for(int i = 0; i < CORDIC_ITERATIONS; ++i) {
+        const int64_t dx = vy >> i;
+        const int64_t dy = vx >> i;
+        if(vy > 0) {
+            vx += dx;
+            vy -= dy;
+            angle += cordic_angles[i];
+        }
+        else {
+            vx -= dx;
+            vy += dy;
+            angle -= cordic_angles[i];
+        }
+    }
+    return angle;
+}
@@ -0,0 +1,65 @@
+#ifndef BULLET_PATTERN_H
+#define BULLET_PATTERN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bullet_pool.h"
+#include "fixed.h"
+
+// ============================================================================
+// Bullet patterns
+// ============================================================================
+
+// Directions are binary angles, clockwise from the positive x axis, where a
+// whole turn is 2^32 and wraps round by itself
+#define BULLET_ANGLE_HALF_TURN ((uint32_t)1 << 31)
+
+typedef enum {
+    // Volleys are centred straight down the screen
+    BULLET_PATTERN_RADIAL,
+    // As radial, but each volley is turned further than the last
+    BULLET_PATTERN_SPIRAL,
+    // Volleys are centred on the target
+    BULLET_PATTERN_AIMED,
+    BULLET_PATTERNS_TOTAL
+} bullet_pattern_kind_t;
+
+// The volleys of bullets fired by every emitter of an archetype, at a regular
+// interval. Each volley spreads its bullets evenly across an arc, and an arc of
+// a full circle or more spaces them evenly all the way round.
+//
+// As with animation clips, emitters only record the step they were spawned on,
+// and when and where they fire is worked out from their age. Arcs and spins are
+// converted to binary angles as the pattern is initialised, and directions are
+// worked out from them with CORDIC, in shifts and adds on integers, so volleys
+// are fired identically on every machine.
+typedef struct {
+    bullet_pattern_kind_t kind;
+    uint32_t num_bullets;
+    float arc_deg;
+    // How far each volley of a spiral is turned from the one before
+    float spin_deg;
+    float interval_s;
+    int32_t velocity_pps;
+    // The interval in whole simulation steps, and the bullets' velocity per step, set by bullet_pattern_init()
+    uint32_t steps_per_volley;
+    fixed_t velocity_per_step;
+    // The spin, the first bullet's angle from the volley's centre and the angle between bullets, as binary angles, also
+    // set by bullet_pattern_init()
+    uint32_t spin;
+    uint32_t first_offset;
+    uint32_t spacing;
+} bullet_pattern_t;
+
+// Converts the pattern's interval and velocity into simulation steps of the given length, firing at most once per step
+void bullet_pattern_init(bullet_pattern_t* pattern, fixed_t time_step_s);
+
+// Returns whether an emitter that was spawned the given number of steps ago fires on this step. Emitters first fire one
+// interval after they are spawned.
+bool bullet_pattern_fires(const bullet_pattern_t* pattern, uint32_t age_steps);
+// Spawns the volley an emitter of the given age fires from (x, y) on the given step, aimed at (target_x, target_y) if
+// the pattern is aimed
+void bullet_pattern_fire(const bullet_pattern_t* pattern, uint32_t age_steps, bullet_pool_t* pool, fixed_t x, fixed_t y, fixed_t target_x, fixed_t target_y, uint32_t step);
+
+#endif
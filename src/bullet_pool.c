@@ -0,0 +1,396 @@
+#include "bullet_pool.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Every hot array is aligned to the widest vector register in use
+#define BULLET_POOL_ALIGNMENT 32
+
+// The number of arrays of fixed-point values in the arena
+#define BULLET_POOL_HOT_ARRAYS 6
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void reserve(bullet_pool_t* pool, size_t capacity);
+static size_t find_first_outside(const bullet_pool_t* pool, size_t start, fixed_t min_x, fixed_t min_y, fixed_t max_x, fixed_t max_y);
+static bool is_path_near(int32_t start, int32_t end, int32_t min, int32_t max);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void bullet_pool_init(bullet_pool_t* const pool, const size_t capacity)
+{
+    pool->x = NULL;
+    pool->y = NULL;
+    pool->prev_x = NULL;
+    pool->prev_y = NULL;
+    pool->vx = NULL;
+    pool->vy = NULL;
+    pool->spawn_step = NULL;
+    pool->count = 0;
+    pool->capacity = 0;
+    pool->high_water = 0;
+    pool->storage_size = 0;
+    pool->storage = NULL;
+
+    reserve(pool, capacity > 0 ? capacity : BULLET_POOL_LANES);
+}
+
+void bullet_pool_destroy(bullet_pool_t* const pool)
+{
+    free(pool->storage);
+    pool->storage = NULL;
+    pool->storage_size = 0;
+    pool->x = NULL;
+    pool->y = NULL;
+    pool->prev_x = NULL;
+    pool->prev_y = NULL;
+    pool->vx = NULL;
+    pool->vy = NULL;
+    pool->spawn_step = NULL;
+    pool->count = 0;
+    pool->capacity = 0;
+}
+
+size_t bullet_pool_push(bullet_pool_t* const pool, const size_t num)
+{
+    if(num > BULLET_POOL_MAX_CAPACITY - pool->count) {
+        fprintf(stderr, "Bullet pool is full at capacity: %zu\n", pool->capacity);
+        exit(EXIT_FAILURE);
+    }
+    if(pool->count + num > pool->capacity) {
+        // A whole volley is made room for at once, rather than doubling once per bullet
+        size_t capacity = pool->capacity;
+        while(capacity < pool->count + num) {
+            capacity = capacity * 2 < BULLET_POOL_MAX_CAPACITY ? capacity * 2 : BULLET_POOL_MAX_CAPACITY;
+        }
+        reserve(pool, capacity);
+    }
+
+    const size_t idx = pool->count;
+    pool->count += num;
+    pool->high_water = pool->count > pool->high_water ? pool->count : pool->high_water;
+    return idx;
+}
+
+void bullet_pool_remove(bullet_pool_t* const pool, const size_t idx)
+{
+    const size_t last = pool->count - 1;
+    pool->x[idx] = pool->x[last];
+    pool->y[idx] = pool->y[last];
+    pool->prev_x[idx] = pool->prev_x[last];
+    pool->prev_y[idx] = pool->prev_y[last];
+    pool->vx[idx] = pool->vx[last];
+    pool->vy[idx] = pool->vy[last];
+    pool->spawn_step[idx] = pool->spawn_step[last];
+    pool->count--;
+}
+
+void bullet_pool_integrate(bullet_pool_t* const pool)
+{
+    bullet_pool_integrate_range(pool, 0, pool->count);
+}
+
+void bullet_pool_integrate_range(bullet_pool_t* const pool, const size_t begin, const size_t end)
+{
+    fixed_t* x = pool->x;
+    fixed_t* y = pool->y;
+    fixed_t* prev_x = pool->prev_x;
+    fixed_t* prev_y = pool->prev_y;
+    const fixed_t* vx = pool->vx;
+    const fixed_t* vy = pool->vy;
+    const size_t count = end;
+    size_t i = begin;
+
+#if defined(__AVX2__)
+    for(; i + 8 <= count; i += 8) {
+        const __m256i px = _mm256_load_si256((const __m256i*)&x[i]);
+        const __m256i py = _mm256_load_si256((const __m256i*)&y[i]);
+        _mm256_store_si256((__m256i*)&prev_x[i], px);
+        _mm256_store_si256((__m256i*)&prev_y[i], py);
+        _mm256_store_si256((__m256i*)&x[i], _mm256_add_epi32(px, _mm256_load_si256((const __m256i*)&vx[i])));
+        _mm256_store_si256((__m256i*)&y[i], _mm256_add_epi32(py, _mm256_load_si256((const __m256i*)&vy[i])));
+    }
+#elif defined(__SSE2__)
+    for(; i + 4 <= count; i += 4) {
+        const __m128i px = _mm_load_si128((const __m128i*)&x[i]);
+        const __m128i py = _mm_load_si128((const __m128i*)&y[i]);
+        _mm_store_si128((__m128i*)&prev_x[i], px);
+        _mm_store_si128((__m128i*)&prev_y[i], py);
+        _mm_store_si128((__m128i*)&x[i], _mm_add_epi32(px, _mm_load_si128((const __m128i*)&vx[i])));
+        _mm_store_si128((__m128i*)&y[i], _mm_add_epi32(py, _mm_load_si128((const __m128i*)&vy[i])));
+    }
+#endif
+    for(; i < count; ++i) {
+        prev_x[i] = x[i];
+        prev_y[i] = y[i];
+        x[i] += vx[i];
+        y[i] += vy[i];
+    }
+}
+
+void bullet_pool_cull_outside(bullet_pool_t* const pool, const fixed_t min_x, const fixed_t min_y, const fixed_t max_x, const fixed_t max_y)
+{
+    // Removal swaps the last bullet into the vacated slot, so the search resumes from that same slot
+    size_t i = 0;
+    while((i = find_first_outside(pool, i, min_x, min_y, max_x, max_y)) < pool->count) {
+        bullet_pool_remove(pool, i);
+    }
+}
+
+void bullet_pool_integrate_cull(bullet_pool_t* const pool, const fixed_t min_x, const fixed_t min_y, const fixed_t max_x, const fixed_t max_y)
+{
+    fixed_t* x = pool->x;
+    fixed_t* y = pool->y;
+    fixed_t* prev_x = pool->prev_x;
+    fixed_t* prev_y = pool->prev_y;
+    const fixed_t* vx = pool->vx;
+    const fixed_t* vy = pool->vy;
+#if defined(__AVX2__)
+    const __m256i bound_min_x = _mm256_set1_epi32(min_x);
+    const __m256i bound_min_y = _mm256_set1_epi32(min_y);
+    const __m256i bound_max_x = _mm256_set1_epi32(max_x);
+    const __m256i bound_max_y = _mm256_set1_epi32(max_y);
+#elif defined(__SSE2__)
+    const __m128i bound_min_x = _mm_set1_epi32(min_x);
+    const __m128i bound_min_y = _mm_set1_epi32(min_y);
+    const __m128i bound_max_x = _mm_set1_epi32(max_x);
+    const __m128i bound_max_y = _mm_set1_epi32(max_y);
+#endif
+
+    // As in entity_pool_integrate_cull_y(), a bullet swapped in from the end has not been integrated yet, and the
+    // vectors are loaded unaligned
+    size_t i = 0;
+    while(i < pool->count) {
+        size_t run = 0;
+#if defined(__AVX2__)
+        if(i + 8 <= pool->count) {
+            const __m256i px = _mm256_loadu_si256((const __m256i*)&x[i]);
+            const __m256i py = _mm256_loadu_si256((const __m256i*)&y[i]);
+            const __m256i next_x = _mm256_add_epi32(px, _mm256_loadu_si256((const __m256i*)&vx[i]));
+            const __m256i next_y = _mm256_add_epi32(py, _mm256_loadu_si256((const __m256i*)&vy[i]));
+            __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(bound_min_x, next_x), _mm256_cmpgt_epi32(next_x, bound_max_x));
+            outside = _mm256_or_si256(outside, _mm256_or_si256(_mm256_cmpgt_epi32(bound_min_y, next_y), _mm256_cmpgt_epi32(next_y, bound_max_y)));
+            const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(outside));
+            if(mask == 0) {
+                _mm256_storeu_si256((__m256i*)&prev_x[i], px);
+                _mm256_storeu_si256((__m256i*)&prev_y[i], py);
+                _mm256_storeu_si256((__m256i*)&x[i], next_x);
+                _mm256_storeu_si256((__m256i*)&y[i], next_y);
+                i += 8;
+                continue;
+            }
+            run = (size_t)__builtin_ctz((unsigned)mask);
+        }
+#elif defined(__SSE2__)
+        if(i + 4 <= pool->count) {
+            const __m128i px = _mm_loadu_si128((const __m128i*)&x[i]);
+            const __m128i py = _mm_loadu_si128((const __m128i*)&y[i]);
+            const __m128i next_x = _mm_add_epi32(px, _mm_loadu_si128((const __m128i*)&vx[i]));
+            const __m128i next_y = _mm_add_epi32(py, _mm_loadu_si128((const __m128i*)&vy[i]));
+            __m128i outside = _mm_or_si128(_mm_cmplt_epi32(next_x, bound_min_x), _mm_cmpgt_epi32(next_x, bound_max_x));
+            outside = _mm_or_si128(outside, _mm_or_si128(_mm_cmplt_epi32(next_y, bound_min_y), _mm_cmpgt_epi32(next_y, bound_max_y)));
+            const int mask = _mm_movemask_ps(_mm_castsi128_ps(outside));
+            if(mask == 0) {
+                _mm_storeu_si128((__m128i*)&prev_x[i], px);
+                _mm_storeu_si128((__m128i*)&prev_y[i], py);
+                _mm_storeu_si128((__m128i*)&x[i], next_x);
+                _mm_storeu_si128((__m128i*)&y[i], next_y);
+                i += 4;
+                continue;
+            }
+            run = (size_t)__builtin_ctz((unsigned)mask);
+        }
+#endif
+        for(const size_t end = i + run; i < end; ++i) {
+            prev_x[i] = x[i];
+            prev_y[i] = y[i];
+            x[i] += vx[i];
+            y[i] += vy[i];
+        }
+        prev_x[i] = x[i];
+        prev_y[i] = y[i];
+        x[i] += vx[i];
+        y[i] += vy[i];
+        if(x[i] < min_x || x[i] > max_x || y[i] < min_y || y[i] > max_y) {
+            bullet_pool_remove(pool, i);
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+size_t bullet_pool_find_first_near(const bullet_pool_t* const pool, const size_t start, const SDL_Rect* const quad, const fixed_t dx, const fixed_t dy)
+{
+    const fixed_t* x = pool->x;
+    const fixed_t* y = pool->y;
+    const fixed_t* prev_x = pool->prev_x;
+    const fixed_t* prev_y = pool->prev_y;
+    const size_t count = pool->count;
+    const int32_t min_x = quad->x;
+    const int32_t min_y = quad->y;
+    const int32_t max_x = quad->x + quad->w;
+    const int32_t max_y = quad->y + quad->h;
+    size_t i = start;
+
+    // A path is ruled out when both of its ends lie beyond the same edge of the quad. Only shifts and comparisons are
+    // needed, so eight lanes are tested at a time with AVX2, or four with SSE2, before the scalar tail.
+#if defined(__AVX2__)
+    const __m256i delta_x = _mm256_set1_epi32(dx);
+    const __m256i delta_y = _mm256_set1_epi32(dy);
+    const __m256i bound_min_x = _mm256_set1_epi32(min_x);
+    const __m256i bound_min_y = _mm256_set1_epi32(min_y);
+    const __m256i bound_max_x = _mm256_set1_epi32(max_x);
+    const __m256i bound_max_y = _mm256_set1_epi32(max_y);
+    for(; i + 8 <= count; i += 8) {
+        const __m256i start_x = _mm256_srai_epi32(_mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&prev_x[i]), delta_x), FIXED_SHIFT);
+        const __m256i start_y = _mm256_srai_epi32(_mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&prev_y[i]), delta_y), FIXED_SHIFT);
+        const __m256i end_x = _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)&x[i]), FIXED_SHIFT);
+        const __m256i end_y = _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)&y[i]), FIXED_SHIFT);
+        __m256i outside = _mm256_and_si256(_mm256_cmpgt_epi32(bound_min_x, start_x), _mm256_cmpgt_epi32(bound_min_x, end_x));
+        outside = _mm256_or_si256(outside, _mm256_and_si256(_mm256_cmpgt_epi32(start_x, bound_max_x), _mm256_cmpgt_epi32(end_x, bound_max_x)));
+        outside = _mm256_or_si256(outside, _mm256_and_si256(_mm256_cmpgt_epi32(bound_min_y, start_y), _mm256_cmpgt_epi32(bound_min_y, end_y)));
+        outside = _mm256_or_si256(outside, _mm256_and_si256(_mm256_cmpgt_epi32(start_y, bound_max_y), _mm256_cmpgt_epi32(end_y, bound_max_y)));
+        const int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF;
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i delta_x = _mm_set1_epi32(dx);
+    const __m128i delta_y = _mm_set1_epi32(dy);
+    const __m128i bound_min_x = _mm_set1_epi32(min_x);
+    const __m128i bound_min_y = _mm_set1_epi32(min_y);
+    const __m128i bound_max_x = _mm_set1_epi32(max_x);
+    const __m128i bound_max_y = _mm_set1_epi32(max_y);
+    for(; i + 4 <= count; i += 4) {
+        const __m128i start_x = _mm_srai_epi32(_mm_add_epi32(_mm_loadu_si128((const __m128i*)&prev_x[i]), delta_x), FIXED_SHIFT);
+        const __m128i start_y = _mm_srai_epi32(_mm_add_epi32(_mm_loadu_si128((const __m128i*)&prev_y[i]), delta_y), FIXED_SHIFT);
+        const __m128i end_x = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)&x[i]), FIXED_SHIFT);
+        const __m128i end_y = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)&y[i]), FIXED_SHIFT);
+        __m128i outside = _mm_and_si128(_mm_cmplt_epi32(start_x, bound_min_x), _mm_cmplt_epi32(end_x, bound_min_x));
+        outside = _mm_or_si128(outside, _mm_and_si128(_mm_cmpgt_epi32(start_x, bound_max_x), _mm_cmpgt_epi32(end_x, bound_max_x)));
+        outside = _mm_or_si128(outside, _mm_and_si128(_mm_cmplt_epi32(start_y, bound_min_y), _mm_cmplt_epi32(end_y, bound_min_y)));
+        outside = _mm_or_si128(outside, _mm_and_si128(_mm_cmpgt_epi32(start_y, bound_max_y), _mm_cmpgt_epi32(end_y, bound_max_y)));
+        const int mask = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    for(; i < count; ++i) {
+        if(is_path_near(fixed_to_int(prev_x[i] + dx), fixed_to_int(x[i]), min_x, max_x) && is_path_near(fixed_to_int(prev_y[i] + dy), fixed_to_int(y[i]), min_y, max_y)) {
+            return i;
+        }
+    }
+    return count;
+}
+
+static void reserve(bullet_pool_t* const pool, const size_t capacity)
+{
+    const size_t lane_capacity = (capacity + BULLET_POOL_LANES - 1) / BULLET_POOL_LANES * BULLET_POOL_LANES;
+    const size_t hot_size = lane_capacity * sizeof(fixed_t);
+    const size_t spawn_step_size = lane_capacity * sizeof(uint32_t);
+    size_t storage_size = BULLET_POOL_HOT_ARRAYS * hot_size + spawn_step_size;
+    storage_size = (storage_size + BULLET_POOL_ALIGNMENT - 1) / BULLET_POOL_ALIGNMENT * BULLET_POOL_ALIGNMENT;
+
+    uint8_t* storage = aligned_alloc(BULLET_POOL_ALIGNMENT, storage_size);
+    if(storage == NULL) {
+        fprintf(stderr, "Failed to allocate a bullet pool of capacity: %zu\n", lane_capacity);
+        exit(EXIT_FAILURE);
+    }
+    memset(storage, 0, storage_size);
+
+    fixed_t* arrays[BULLET_POOL_HOT_ARRAYS];
+    for(size_t a = 0; a < BULLET_POOL_HOT_ARRAYS; ++a) {
+        arrays[a] = (fixed_t*)(storage + a * hot_size);
+    }
+    uint32_t* spawn_step = (uint32_t*)(storage + BULLET_POOL_HOT_ARRAYS * hot_size);
+
+    // Carry over the live bullets
+    if(pool->storage != NULL) {
+        const fixed_t* old_arrays[BULLET_POOL_HOT_ARRAYS] = { pool->x, pool->y, pool->prev_x, pool->prev_y, pool->vx, pool->vy };
+        for(size_t a = 0; a < BULLET_POOL_HOT_ARRAYS; ++a) {
+            memcpy(arrays[a], old_arrays[a], pool->count * sizeof(fixed_t));
+        }
+        memcpy(spawn_step, pool->spawn_step, pool->count * sizeof(uint32_t));
+        free(pool->storage);
+    }
+
+    pool->x = arrays[0];
+    pool->y = arrays[1];
+    pool->prev_x = arrays[2];
+    pool->prev_y = arrays[3];
+    pool->vx = arrays[4];
+    pool->vy = arrays[5];
+    pool->spawn_step = spawn_step;
+    pool->capacity = lane_capacity;
+    pool->storage_size = storage_size;
+    pool->storage = storage;
+}
+
+static size_t find_first_outside(const bullet_pool_t* const pool, const size_t start, const fixed_t min_x, const fixed_t min_y, const fixed_t max_x, const fixed_t max_y)
+{
+    const fixed_t* x = pool->x;
+    const fixed_t* y = pool->y;
+    const size_t count = pool->count;
+    size_t i = start;
+#if defined(__AVX2__)
+    const __m256i bound_min_x = _mm256_set1_epi32(min_x);
+    const __m256i bound_min_y = _mm256_set1_epi32(min_y);
+    const __m256i bound_max_x = _mm256_set1_epi32(max_x);
+    const __m256i bound_max_y = _mm256_set1_epi32(max_y);
+    for(; i + 8 <= count; i += 8) {
+        const __m256i px = _mm256_loadu_si256((const __m256i*)&x[i]);
+        const __m256i py = _mm256_loadu_si256((const __m256i*)&y[i]);
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(bound_min_x, px), _mm256_cmpgt_epi32(px, bound_max_x));
+        outside = _mm256_or_si256(outside, _mm256_or_si256(_mm256_cmpgt_epi32(bound_min_y, py), _mm256_cmpgt_epi32(py, bound_max_y)));
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(outside));
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i bound_min_x = _mm_set1_epi32(min_x);
+    const __m128i bound_min_y = _mm_set1_epi32(min_y);
+    const __m128i bound_max_x = _mm_set1_epi32(max_x);
+    const __m128i bound_max_y = _mm_set1_epi32(max_y);
+    for(; i + 4 <= count; i += 4) {
+        const __m128i px = _mm_loadu_si128((const __m128i*)&x[i]);
+        const __m128i py = _mm_loadu_si128((const __m128i*)&y[i]);
+        __m128i outside = _mm_or_si128(_mm_cmplt_epi32(px, bound_min_x), _mm_cmpgt_epi32(px, bound_max_x));
+        outside = _mm_or_si128(outside, _mm_or_si128(_mm_cmplt_epi32(py, bound_min_y), _mm_cmpgt_epi32(py, bound_max_y)));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(outside));
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    for(; i < count; ++i) {
+        if(x[i] < min_x || x[i] > max_x || y[i] < min_y || y[i] > max_y) {
+            return i;
+        }
+    }
+    return count;
+}
+
+static bool is_path_near(const int32_t start, const int32_t end, const int32_t min, const int32_t max)
+{
+    return !(start < min && end < min) && !(start > max && end > max);
+}
@@ -0,0 +1,73 @@
+#ifndef BULLET_POOL_H
+#define BULLET_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_rect.h>
+
+#include "fixed.h"
+
+// ============================================================================
+// Structure-of-arrays bullet storage
+// ============================================================================
+
+// Capacities are rounded up to a whole number of SIMD lanes, as for entity pools
+#define BULLET_POOL_LANES 8
+
+// Pools grow by doubling, up to this many bullets
+#define BULLET_POOL_MAX_CAPACITY ((size_t)1 << 24)
+
+// A pool of enemy bullets, which are far more numerous than any other entity.
+// They all look alike and nothing refers to them, so unlike entity pools there
+// are no handles and no per-bullet render data, but they move along both axes.
+// Positions are in fixed-point pixels, and velocities in fixed-point pixels per
+// integration step. prev_x and prev_y hold each bullet's position before the
+// last integration step.
+//
+// Every array lives in one arena, which grows by doubling as entity pools do,
+// so pointers into it must not be held across a push.
+typedef struct {
+    fixed_t* x;
+    fixed_t* y;
+    fixed_t* prev_x;
+    fixed_t* prev_y;
+    fixed_t* vx;
+    fixed_t* vy;
+    uint32_t* spawn_step;
+    size_t count;
+    size_t capacity;
+    // The most bullets the pool has held at once
+    size_t high_water;
+    size_t storage_size;
+    void* storage;
+} bullet_pool_t;
+
+void bullet_pool_init(bullet_pool_t* pool, size_t capacity);
+void bullet_pool_destroy(bullet_pool_t* pool);
+
+// Appends the given number of uninitialised bullets and returns the index of the first, growing the pool once if they
+// do not fit
+size_t bullet_pool_push(bullet_pool_t* pool, size_t num);
+// Removes the bullet at the given index by swapping the last bullet into its place
+void bullet_pool_remove(bullet_pool_t* pool, size_t idx);
+
+// Advances every bullet's position by its velocity, saving the previous position
+void bullet_pool_integrate(bullet_pool_t* pool);
+// As bullet_pool_integrate(), for the bullets in [begin, end) only. Disjoint ranges may be integrated concurrently, and
+// begin must be a multiple of BULLET_POOL_LANES.
+void bullet_pool_integrate_range(bullet_pool_t* pool, size_t begin, size_t end);
+// Removes every bullet whose position lies outside the given bounds, which are inclusive
+void bullet_pool_cull_outside(bullet_pool_t* pool, fixed_t min_x, fixed_t min_y, fixed_t max_x, fixed_t max_y);
+// Integrates and culls every bullet in a single sweep, with the same result as bullet_pool_integrate() followed by
+// bullet_pool_cull_outside(), but loading each bullet only once. As for entity pools, the sweep cannot be split between
+// threads.
+void bullet_pool_integrate_cull(bullet_pool_t* pool, fixed_t min_x, fixed_t min_y, fixed_t max_x, fixed_t max_y);
+
+// Returns the index of the first bullet, from start onwards, whose path over the last step may have met the quad, or
+// the pool's count if there is none. The path is taken relative to the quad, which moved by (dx, dy) over the same
+// step, and is rounded down to whole pixels. A bullet may have met the quad when the bounding box of its path overlaps
+// it, inclusive of the quad's far edges, so the caller makes the exact test.
+size_t bullet_pool_find_first_near(const bullet_pool_t* pool, size_t start, const SDL_Rect* quad, fixed_t dx, fixed_t dy);
+
+#endif
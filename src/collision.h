@@ -0,0 +1,78 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL_rect.h>
+
+// ============================================================================
+// Narrow-phase collision tests
+// ============================================================================
+
+// The exact tests the simulation runs on whichever pairs its broadphase leaves, in whole pixels. Quads are inclusive
+// of their far edges.
+
+static inline bool collision_is_contained(const SDL_Point* const p, const SDL_Rect* const r)
+{
+    const bool result = p->x >= r->x && p->x <= (r->x + r->w) && p->y >= r->y && p->y <= (r->y + r->h);
+    return result;
+}
+
+// Tests whether any corner of a lies within b
+static inline bool collision_is_collided(const SDL_Rect* const a, const SDL_Rect* const b)
+{
+    const SDL_Point a_top_l = {
+        .x = a->x,
+        .y = a->y
+    };
+    const SDL_Point a_bottom_l = {
+        .x = a->x,
+        .y = a->y + a->h
+    };
+    const SDL_Point a_top_r = {
+        .x = a->x + a->w,
+        .y = a->y
+    };
+    const SDL_Point a_bottom_r = {
+        .x = a->x + a->w,
+        .y = a->y + a->h
+    };
+
+    const bool collision_detected = collision_is_contained(&a_top_l, b) || collision_is_contained(&a_bottom_l, b) || collision_is_contained(&a_top_r, b) || collision_is_contained(&a_bottom_r, b);
+
+    return collision_detected;
+}
+
+static inline bool collision_is_segment_intersecting(const SDL_Point* const a, const SDL_Point* const b, const SDL_Rect* const r, float* const t)
+{
+    // Clip the segment against the quad's slab on each axis, inclusive of its far edges as in collision_is_contained().
+    // t is set to how far along the segment it first enters the quad, from 0 at a to 1 at b.
+    const int32_t origin[2] = { a->x, a->y };
+    const int32_t delta[2] = { b->x - a->x, b->y - a->y };
+    const int32_t min[2] = { r->x, r->y };
+    const int32_t max[2] = { r->x + r->w, r->y + r->h };
+    float t_enter = 0.0F;
+    float t_exit = 1.0F;
+    for(int axis = 0; axis < 2; ++axis) {
+        if(delta[axis] == 0) {
+            if(origin[axis] < min[axis] || origin[axis] > max[axis]) {
+                return false;
+            }
+            continue;
+        }
+
+        const float t0 = (float)(min[axis] - origin[axis]) / (float)delta[axis];
+        const float t1 = (float)(max[axis] - origin[axis]) / (float)delta[axis];
+        t_enter = t0 < t1 ? (t0 > t_enter ? t0 : t_enter) : (t1 > t_enter ? t1 : t_enter);
+        t_exit = t0 < t1 ? (t1 < t_exit ? t1 : t_exit) : (t0 < t_exit ? t0 : t_exit);
+        if(t_enter > t_exit) {
+            return false;
+        }
+    }
+
+    *t = t_enter;
+    return true;
+}
+
+#endif
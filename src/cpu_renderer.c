@@ -0,0 +1,287 @@
+#include "cpu_renderer.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// The number of framebuffer rows filled as one unit of work
+#define CPU_RENDERER_BAND_HEIGHT 32
+#define CPU_RENDERER_CLEAR_COLOUR 0xFF000000U
+#define CPU_RENDERER_ALPHA_MASK 0xFF000000U
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void reserve_sprites(cpu_renderer_t* renderer, size_t capacity);
+static bool resolve_sprite(const cpu_renderer_t* renderer, const render_sprite_t* sprite, float alpha, cpu_sprite_t* resolved);
+static void draw_bands_job(void* data, size_t begin, size_t end);
+static void blend_span(uint32_t* dst, const uint32_t* src_row, uint32_t u, uint32_t du, int32_t count);
+static uint32_t blend_pixel(uint32_t src, uint32_t dst);
+// Divides a product of two bytes by 255, rounding down, either for one value or for each 16-bit lane
+static uint32_t div_255(uint32_t x);
+#if defined(__AVX2__)
+static __m256i div_255_x8(__m256i x);
+#elif defined(__SSE2__)
+static __m128i div_255_x4(__m128i x);
+#endif
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void cpu_renderer_init(cpu_renderer_t* const renderer, const int32_t width, const int32_t height, const void* const atlas, const int32_t atlas_w, const int32_t atlas_h, const int32_t atlas_pitch, worker_pool_t* const workers)
+{
+    renderer->width = width;
+    renderer->height = height;
+    renderer->atlas = atlas;
+    renderer->atlas_w = atlas_w;
+    renderer->atlas_h = atlas_h;
+    renderer->atlas_pitch = atlas_pitch / (int32_t)sizeof(uint32_t);
+    renderer->workers = workers;
+    renderer->sprites = NULL;
+    renderer->sprite_count = 0;
+    renderer->sprite_capacity = 0;
+    renderer->pixels = NULL;
+    renderer->pitch = 0;
+}
+
+void cpu_renderer_destroy(cpu_renderer_t* const renderer)
+{
+    free(renderer->sprites);
+    renderer->sprites = NULL;
+    renderer->sprite_count = 0;
+    renderer->sprite_capacity = 0;
+    renderer->atlas = NULL;
+    renderer->workers = NULL;
+}
+
+void cpu_renderer_draw(cpu_renderer_t* const renderer, void* const pixels, const int32_t pitch, const render_snapshot_t* const snapshot, const float alpha)
+{
+    // Resolve every sprite up front, so that the bands only have to test and fill
+    if(snapshot->count > renderer->sprite_capacity) {
+        reserve_sprites(renderer, snapshot->count);
+    }
+    renderer->sprite_count = 0;
+    for(size_t i = 0; i < snapshot->count; ++i) {
+        if(resolve_sprite(renderer, &snapshot->sprites[i], alpha, &renderer->sprites[renderer->sprite_count])) {
+            ++renderer->sprite_count;
+        }
+    }
+
+    renderer->pixels = pixels;
+    renderer->pitch = pitch / (int32_t)sizeof(uint32_t);
+    const size_t num_bands = (size_t)((renderer->height + CPU_RENDERER_BAND_HEIGHT - 1) / CPU_RENDERER_BAND_HEIGHT);
+    worker_pool_run(renderer->workers, draw_bands_job, renderer, num_bands, 1);
+    renderer->pixels = NULL;
+}
+
+static void reserve_sprites(cpu_renderer_t* const renderer, const size_t capacity)
+{
+    cpu_sprite_t* sprites = realloc(renderer->sprites, capacity * sizeof(cpu_sprite_t));
+    if(sprites == NULL) {
+        fprintf(stderr, "Failed to allocate %zu CPU renderer sprites\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+    renderer->sprites = sprites;
+    renderer->sprite_capacity = capacity;
+}
+
+static bool resolve_sprite(const cpu_renderer_t* const renderer, const render_sprite_t* const sprite, const float alpha, cpu_sprite_t* const resolved)
+{
+    // Interpolated exactly as the SDL path does
+    const SDL_Rect* src = &sprite->sprite_quad;
+    const double x = (double)(sprite->prev_x + (sprite->render_quad.x - sprite->prev_x) * alpha);
+    const double y = (double)(sprite->prev_y + (sprite->render_quad.y - sprite->prev_y) * alpha);
+    const double w = (double)sprite->render_quad.w;
+    const double h = (double)sprite->render_quad.h;
+    if(src->w <= 0 || src->h <= 0 || w <= 0.0 || h <= 0.0) {
+        return false;
+    }
+
+    // A pixel is covered when its centre lies within the quad
+    int32_t x0 = (int32_t)ceil(x - 0.5);
+    int32_t y0 = (int32_t)ceil(y - 0.5);
+    int32_t x1 = (int32_t)ceil(x + w - 0.5);
+    int32_t y1 = (int32_t)ceil(y + h - 0.5);
+    x0 = x0 > 0 ? x0 : 0;
+    y0 = y0 > 0 ? y0 : 0;
+    x1 = x1 < renderer->width ? x1 : renderer->width;
+    y1 = y1 < renderer->height ? y1 : renderer->height;
+    if(x0 >= x1 || y0 >= y1) {
+        return false;
+    }
+
+    // Both the start and the step are rounded down, so that sampling never runs past the far edge of the source quad
+    const double scale_x = (double)src->w / w;
+    const double scale_y = (double)src->h / h;
+    resolved->x0 = x0;
+    resolved->y0 = y0;
+    resolved->x1 = x1;
+    resolved->y1 = y1;
+    resolved->u0 = (uint32_t)floor(((double)src->x + ((double)x0 + 0.5 - x) * scale_x) * 65536.0);
+    resolved->du = (uint32_t)floor(scale_x * 65536.0);
+    resolved->v0 = (uint32_t)floor(((double)src->y + ((double)y0 + 0.5 - y) * scale_y) * 65536.0);
+    resolved->dv = (uint32_t)floor(scale_y * 65536.0);
+    return true;
+}
+
+static void draw_bands_job(void* const data, const size_t begin, const size_t end)
+{
+    const cpu_renderer_t* renderer = data;
+    for(size_t band = begin; band < end; ++band) {
+        const int32_t band_y0 = (int32_t)band * CPU_RENDERER_BAND_HEIGHT;
+        const int32_t band_y1 = band_y0 + CPU_RENDERER_BAND_HEIGHT < renderer->height ? band_y0 + CPU_RENDERER_BAND_HEIGHT : renderer->height;
+
+        for(int32_t y = band_y0; y < band_y1; ++y) {
+            uint32_t* row = &renderer->pixels[(size_t)y * (size_t)renderer->pitch];
+            for(int32_t x = 0; x < renderer->width; ++x) {
+                row[x] = CPU_RENDERER_CLEAR_COLOUR;
+            }
+        }
+
+        for(size_t i = 0; i < renderer->sprite_count; ++i) {
+            const cpu_sprite_t* sprite = &renderer->sprites[i];
+            if(sprite->y1 <= band_y0 || sprite->y0 >= band_y1) {
+                continue;
+            }
+
+            const int32_t y0 = sprite->y0 > band_y0 ? sprite->y0 : band_y0;
+            const int32_t y1 = sprite->y1 < band_y1 ? sprite->y1 : band_y1;
+            for(int32_t y = y0; y < y1; ++y) {
+                const uint32_t v = (sprite->v0 + (uint32_t)(y - sprite->y0) * sprite->dv) >> 16;
+                const uint32_t* src_row = &renderer->atlas[(size_t)v * (size_t)renderer->atlas_pitch];
+                uint32_t* dst = &renderer->pixels[(size_t)y * (size_t)renderer->pitch + (size_t)sprite->x0];
+                blend_span(dst, src_row, sprite->u0, sprite->du, sprite->x1 - sprite->x0);
+            }
+        }
+    }
+}
+
+static void blend_span(uint32_t* const dst, const uint32_t* const src_row, const uint32_t u, const uint32_t du, const int32_t count)
+{
+    // Each channel is s * a / 255 + d * (255 - a) / 255, with each term rounded down by computing
+    // (x + 1) * 257 / 65536, as in SDL_Blit_ARGB8888_ARGB8888_Blend_Scale. The source alpha channel is forced to
+    // opaque first, so that the same sum gives SDL's blended alpha a + d * (255 - a) / 255.
+    int32_t i = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(255);
+    const __m256i alpha_mask = _mm256_set1_epi32((int)CPU_RENDERER_ALPHA_MASK);
+    const __m256i step = _mm256_set1_epi32((int)(du * 8));
+    __m256i us = _mm256_add_epi32(_mm256_set1_epi32((int)u), _mm256_mullo_epi32(_mm256_set1_epi32((int)du), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    for(; i + 8 <= count; i += 8) {
+        const __m256i s = _mm256_i32gather_epi32((const int*)src_row, _mm256_srli_epi32(us, 16), 4);
+        us = _mm256_add_epi32(us, step);
+
+        const __m256i a = _mm256_and_si256(s, alpha_mask);
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, zero)) == -1) {
+            continue;
+        }
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, alpha_mask)) == -1) {
+            _mm256_storeu_si256((__m256i*)&dst[i], s);
+            continue;
+        }
+
+        const __m256i d = _mm256_loadu_si256((const __m256i*)&dst[i]);
+        const __m256i s_opaque = _mm256_or_si256(s, alpha_mask);
+        const __m256i s_lo = _mm256_unpacklo_epi8(s_opaque, zero);
+        const __m256i s_hi = _mm256_unpackhi_epi8(s_opaque, zero);
+        const __m256i d_lo = _mm256_unpacklo_epi8(d, zero);
+        const __m256i d_hi = _mm256_unpackhi_epi8(d, zero);
+        const __m256i a_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(_mm256_unpacklo_epi8(s, zero), 0xFF), 0xFF);
+        const __m256i a_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(_mm256_unpackhi_epi8(s, zero), 0xFF), 0xFF);
+        const __m256i lo = _mm256_add_epi16(div_255_x8(_mm256_mullo_epi16(s_lo, a_lo)), div_255_x8(_mm256_mullo_epi16(d_lo, _mm256_sub_epi16(full, a_lo))));
+        const __m256i hi = _mm256_add_epi16(div_255_x8(_mm256_mullo_epi16(s_hi, a_hi)), div_255_x8(_mm256_mullo_epi16(d_hi, _mm256_sub_epi16(full, a_hi))));
+        _mm256_storeu_si256((__m256i*)&dst[i], _mm256_packus_epi16(lo, hi));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i alpha_mask = _mm_set1_epi32((int)CPU_RENDERER_ALPHA_MASK);
+    uint32_t u_i = u;
+    for(; i + 4 <= count; i += 4) {
+        // SSE2 has no gather, so the four texels are fetched individually
+        const __m128i s = _mm_setr_epi32((int)src_row[u_i >> 16], (int)src_row[(u_i + du) >> 16], (int)src_row[(u_i + 2 * du) >> 16], (int)src_row[(u_i + 3 * du) >> 16]);
+        u_i += 4 * du;
+
+        const __m128i a = _mm_and_si128(s, alpha_mask);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xFFFF) {
+            continue;
+        }
+        if(_mm_movemask_epi8(_mm_cmpeq_epi32(a, alpha_mask)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i*)&dst[i], s);
+            continue;
+        }
+
+        const __m128i d = _mm_loadu_si128((const __m128i*)&dst[i]);
+        const __m128i s_opaque = _mm_or_si128(s, alpha_mask);
+        const __m128i s_lo = _mm_unpacklo_epi8(s_opaque, zero);
+        const __m128i s_hi = _mm_unpackhi_epi8(s_opaque, zero);
+        const __m128i d_lo = _mm_unpacklo_epi8(d, zero);
+        const __m128i d_hi = _mm_unpackhi_epi8(d, zero);
+        const __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(_mm_unpacklo_epi8(s, zero), 0xFF), 0xFF);
+        const __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(_mm_unpackhi_epi8(s, zero), 0xFF), 0xFF);
+        const __m128i lo = _mm_add_epi16(div_255_x4(_mm_mullo_epi16(s_lo, a_lo)), div_255_x4(_mm_mullo_epi16(d_lo, _mm_sub_epi16(full, a_lo))));
+        const __m128i hi = _mm_add_epi16(div_255_x4(_mm_mullo_epi16(s_hi, a_hi)), div_255_x4(_mm_mullo_epi16(d_hi, _mm_sub_epi16(full, a_hi))));
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for(; i < count; ++i) {
+        const uint32_t s = src_row[(u + (uint32_t)i * du) >> 16];
+        dst[i] = blend_pixel(s, dst[i]);
+    }
+}
+
+static uint32_t blend_pixel(const uint32_t src, const uint32_t dst)
+{
+    const uint32_t a = src >> 24;
+    if(a == 0) {
+        return dst;
+    }
+    if(a == 255) {
+        return src;
+    }
+
+    const uint32_t src_opaque = src | CPU_RENDERER_ALPHA_MASK;
+    uint32_t result = 0;
+    for(uint32_t shift = 0; shift < 32; shift += 8) {
+        const uint32_t channel = div_255(((src_opaque >> shift) & 0xFF) * a) + div_255(((dst >> shift) & 0xFF) * (255 - a));
+        result |= channel << shift;
+    }
+    return result;
+}
+
+static uint32_t div_255(uint32_t x)
+{
+    x += 1;
+    x += x >> 8;
+    return x >> 8;
+}
+
+#if defined(__AVX2__)
+static __m256i div_255_x8(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(1));
+    x = _mm256_add_epi16(x, _mm256_srli_epi16(x, 8));
+    return _mm256_srli_epi16(x, 8);
+}
+#elif defined(__SSE2__)
+static __m128i div_255_x4(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(1));
+    x = _mm_add_epi16(x, _mm_srli_epi16(x, 8));
+    return _mm_srli_epi16(x, 8);
+}
+#endif
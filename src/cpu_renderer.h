@@ -0,0 +1,69 @@
+#ifndef CPU_RENDERER_H
+#define CPU_RENDERER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "render_snapshot.h"
+#include "worker_pool.h"
+
+// ============================================================================
+// CPU sprite renderer
+// ============================================================================
+
+// Draws render snapshots into an ARGB8888 framebuffer without a GPU, for hosts
+// where SDL would otherwise fall back to its generic software path. Sprites
+// are scaled with nearest-neighbour sampling at pixel centres and alpha
+// blended as s * a / 255 + d * (255 - a) / 255 in each channel, with each term
+// rounded down, as SDL's generic scaled blitters do. SDL blends sprites drawn
+// at their own size with other blitters, which divide by 256, so only a
+// partially transparent pixel of an unscaled sprite can differ from SDL's, by
+// one in a channel. The game scales every sprite it draws.
+
+// A sprite resolved to the framebuffer pixels it covers. Source coordinates are
+// in 16.16 fixed-point atlas texels, sampled at the centre of the first pixel
+// and stepped once per pixel.
+typedef struct {
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+    uint32_t u0;
+    uint32_t du;
+    uint32_t v0;
+    uint32_t dv;
+} cpu_sprite_t;
+
+// A renderer for one framebuffer size. The framebuffer is split into bands of
+// whole rows, which are filled independently across a worker pool. Each band
+// draws every sprite that overlaps it in snapshot order, so layering is
+// preserved.
+typedef struct {
+    int32_t width;
+    int32_t height;
+    const uint32_t* atlas;
+    int32_t atlas_w;
+    int32_t atlas_h;
+    int32_t atlas_pitch;
+    worker_pool_t* workers;
+
+    // The sprites of the snapshot being drawn, resolved to pixel bounds and sampling steps
+    cpu_sprite_t* sprites;
+    size_t sprite_count;
+    size_t sprite_capacity;
+
+    // The framebuffer being drawn into
+    uint32_t* pixels;
+    int32_t pitch;
+} cpu_renderer_t;
+
+// Creates a renderer for a framebuffer of the given size, sampling from an ARGB8888 atlas with the given pitch in bytes.
+// The atlas must outlive the renderer.
+void cpu_renderer_init(cpu_renderer_t* renderer, int32_t width, int32_t height, const void* atlas, int32_t atlas_w, int32_t atlas_h, int32_t atlas_pitch, worker_pool_t* workers);
+void cpu_renderer_destroy(cpu_renderer_t* renderer);
+
+// Clears the framebuffer to opaque black, then draws every sprite in the snapshot, interpolated by alpha between its
+// previous and current positions. The pitch is in bytes.
+void cpu_renderer_draw(cpu_renderer_t* renderer, void* pixels, int32_t pitch, const render_snapshot_t* snapshot, float alpha);
+
+#endif
@@ -0,0 +1,350 @@
+#include "entity_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Every hot array is aligned to the widest vector register in use
+#define ENTITY_POOL_ALIGNMENT 32
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void reserve(entity_pool_t* pool, size_t capacity);
+static size_t find_first_y_outside(const fixed_t* y, size_t start, size_t count, fixed_t min_y, fixed_t max_y);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void entity_pool_init(entity_pool_t* const pool, const size_t capacity)
+{
+    pool->x = NULL;
+    pool->y = NULL;
+    pool->prev_y = NULL;
+    pool->vy = NULL;
+    pool->cold = NULL;
+    pool->slot_of = NULL;
+    pool->slots = NULL;
+    pool->free_slot = 0;
+    pool->count = 0;
+    pool->capacity = 0;
+    pool->high_water = 0;
+    pool->storage_size = 0;
+    pool->storage = NULL;
+
+    reserve(pool, capacity > 0 ? capacity : ENTITY_POOL_LANES);
+}
+
+void entity_pool_destroy(entity_pool_t* const pool)
+{
+    free(pool->storage);
+    pool->storage = NULL;
+    pool->storage_size = 0;
+    pool->x = NULL;
+    pool->y = NULL;
+    pool->prev_y = NULL;
+    pool->vy = NULL;
+    pool->cold = NULL;
+    pool->slot_of = NULL;
+    pool->slots = NULL;
+    pool->count = 0;
+    pool->capacity = 0;
+}
+
+size_t entity_pool_push(entity_pool_t* const pool)
+{
+    if(pool->count == pool->capacity) {
+        if(pool->capacity == ENTITY_POOL_MAX_CAPACITY) {
+            fprintf(stderr, "Entity pool is full at capacity: %zu\n", pool->capacity);
+            exit(EXIT_FAILURE);
+        }
+        reserve(pool, pool->capacity * 2 < ENTITY_POOL_MAX_CAPACITY ? pool->capacity * 2 : ENTITY_POOL_MAX_CAPACITY);
+    }
+
+    // Every slot beyond the live entities' is on the free list, so there is always one to take
+    const size_t idx = pool->count++;
+    const uint32_t slot = pool->free_slot;
+    pool->free_slot = pool->slots[slot].idx;
+    pool->slots[slot].idx = (uint32_t)idx;
+    pool->slot_of[idx] = slot;
+
+    pool->high_water = pool->count > pool->high_water ? pool->count : pool->high_water;
+    return idx;
+}
+
+void entity_pool_remove(entity_pool_t* const pool, const size_t idx)
+{
+    const size_t last = pool->count - 1;
+    const uint32_t removed_slot = pool->slot_of[idx];
+    pool->x[idx] = pool->x[last];
+    pool->y[idx] = pool->y[last];
+    pool->prev_y[idx] = pool->prev_y[last];
+    pool->vy[idx] = pool->vy[last];
+    pool->cold[idx] = pool->cold[last];
+    pool->slot_of[idx] = pool->slot_of[last];
+    pool->slots[pool->slot_of[idx]].idx = (uint32_t)idx;
+    pool->count--;
+
+    // Retire the removed entity's handles, and free its slot for reuse
+    pool->slots[removed_slot].generation++;
+    pool->slots[removed_slot].idx = pool->free_slot;
+    pool->free_slot = removed_slot;
+}
+
+entity_handle_t entity_pool_handle(const entity_pool_t* const pool, const size_t idx)
+{
+    const uint32_t slot = pool->slot_of[idx];
+    const entity_handle_t handle = {
+        .slot = slot,
+        .generation = pool->slots[slot].generation
+    };
+    return handle;
+}
+
+size_t entity_pool_resolve(const entity_pool_t* const pool, const entity_handle_t handle)
+{
+    if(handle.slot >= pool->capacity || pool->slots[handle.slot].generation != handle.generation) {
+        return pool->count;
+    }
+    return pool->slots[handle.slot].idx;
+}
+
+SDL_Rect entity_pool_render_quad(const entity_pool_t* const pool, const size_t idx)
+{
+    const entity_cold_t* cold = &pool->cold[idx];
+    const SDL_Rect render_quad = {
+        .x = fixed_to_int(pool->x[idx]) - cold->render_w / 2,
+        .y = fixed_to_int(pool->y[idx]) - cold->render_h / 2,
+        .w = cold->render_w,
+        .h = cold->render_h
+    };
+    return render_quad;
+}
+
+SDL_Rect entity_pool_swept_quad(const entity_pool_t* const pool, const size_t idx)
+{
+    const entity_cold_t* cold = &pool->cold[idx];
+    const int32_t y = fixed_to_int(pool->y[idx]);
+    const int32_t prev_y = fixed_to_int(pool->prev_y[idx]);
+    const int32_t min_y = y < prev_y ? y : prev_y;
+    const int32_t max_y = y < prev_y ? prev_y : y;
+    const SDL_Rect swept_quad = {
+        .x = fixed_to_int(pool->x[idx]) - cold->render_w / 2,
+        .y = min_y - cold->render_h / 2,
+        .w = cold->render_w,
+        .h = cold->render_h + max_y - min_y
+    };
+    return swept_quad;
+}
+
+void entity_pool_integrate_y(entity_pool_t* const pool)
+{
+    entity_pool_integrate_y_range(pool, 0, pool->count);
+}
+
+void entity_pool_integrate_y_range(entity_pool_t* const pool, const size_t begin, const size_t end)
+{
+    fixed_t* y = pool->y;
+    fixed_t* prev_y = pool->prev_y;
+    const fixed_t* vy = pool->vy;
+    const size_t count = end;
+    size_t i = begin;
+
+    // Velocities are already scaled to a single step, so integration is a plain integer add on every path
+#if defined(__AVX2__)
+    for(; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_load_si256((const __m256i*)&vy[i]);
+        const __m256i p = _mm256_load_si256((const __m256i*)&y[i]);
+        _mm256_store_si256((__m256i*)&prev_y[i], p);
+        _mm256_store_si256((__m256i*)&y[i], _mm256_add_epi32(p, v));
+    }
+#elif defined(__SSE2__)
+    for(; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_load_si128((const __m128i*)&vy[i]);
+        const __m128i p = _mm_load_si128((const __m128i*)&y[i]);
+        _mm_store_si128((__m128i*)&prev_y[i], p);
+        _mm_store_si128((__m128i*)&y[i], _mm_add_epi32(p, v));
+    }
+#endif
+    for(; i < count; ++i) {
+        prev_y[i] = y[i];
+        y[i] += vy[i];
+    }
+}
+
+void entity_pool_cull_y_outside(entity_pool_t* const pool, const fixed_t min_y, const fixed_t max_y)
+{
+    // Removal swaps the last entity into the vacated slot, so the search resumes from that same slot
+    size_t i = 0;
+    while((i = find_first_y_outside(pool->y, i, pool->count, min_y, max_y)) < pool->count) {
+        entity_pool_remove(pool, i);
+    }
+}
+
+void entity_pool_integrate_cull_y(entity_pool_t* const pool, const fixed_t min_y, const fixed_t max_y)
+{
+    fixed_t* y = pool->y;
+    fixed_t* prev_y = pool->prev_y;
+    const fixed_t* vy = pool->vy;
+#if defined(__AVX2__)
+    const __m256i bound_min = _mm256_set1_epi32(min_y);
+    const __m256i bound_max = _mm256_set1_epi32(max_y);
+#elif defined(__SSE2__)
+    const __m128i bound_min = _mm_set1_epi32(min_y);
+    const __m128i bound_max = _mm_set1_epi32(max_y);
+#endif
+
+    // An entity swapped in from the end of the pool has not been integrated yet, so each one is still integrated and
+    // tested exactly once, in the same order as by separate passes. Culling shifts later entities off the vector
+    // alignment, so the vectors are loaded unaligned.
+    size_t i = 0;
+    while(i < pool->count) {
+        size_t run = 0;
+#if defined(__AVX2__)
+        if(i + 8 <= pool->count) {
+            const __m256i p = _mm256_loadu_si256((const __m256i*)&y[i]);
+            const __m256i next = _mm256_add_epi32(p, _mm256_loadu_si256((const __m256i*)&vy[i]));
+            const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(bound_min, next), _mm256_cmpgt_epi32(next, bound_max));
+            const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(outside));
+            if(mask == 0) {
+                _mm256_storeu_si256((__m256i*)&prev_y[i], p);
+                _mm256_storeu_si256((__m256i*)&y[i], next);
+                i += 8;
+                continue;
+            }
+            run = (size_t)__builtin_ctz((unsigned)mask);
+        }
+#elif defined(__SSE2__)
+        if(i + 4 <= pool->count) {
+            const __m128i p = _mm_loadu_si128((const __m128i*)&y[i]);
+            const __m128i next = _mm_add_epi32(p, _mm_loadu_si128((const __m128i*)&vy[i]));
+            const __m128i outside = _mm_or_si128(_mm_cmplt_epi32(next, bound_min), _mm_cmpgt_epi32(next, bound_max));
+            const int mask = _mm_movemask_ps(_mm_castsi128_ps(outside));
+            if(mask == 0) {
+                _mm_storeu_si128((__m128i*)&prev_y[i], p);
+                _mm_storeu_si128((__m128i*)&y[i], next);
+                i += 4;
+                continue;
+            }
+            run = (size_t)__builtin_ctz((unsigned)mask);
+        }
+#endif
+        // The entities before the first culled one stay, and the vector loop resumes after the culled one is removed
+        for(const size_t end = i + run; i < end; ++i) {
+            prev_y[i] = y[i];
+            y[i] += vy[i];
+        }
+        prev_y[i] = y[i];
+        y[i] += vy[i];
+        if(y[i] < min_y || y[i] > max_y) {
+            entity_pool_remove(pool, i);
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+static void reserve(entity_pool_t* const pool, const size_t capacity)
+{
+    const size_t lane_capacity = (capacity + ENTITY_POOL_LANES - 1) / ENTITY_POOL_LANES * ENTITY_POOL_LANES;
+    const size_t hot_size = lane_capacity * sizeof(fixed_t);
+    const size_t cold_size = lane_capacity * sizeof(entity_cold_t);
+    const size_t slot_of_size = lane_capacity * sizeof(uint32_t);
+    const size_t slots_size = lane_capacity * sizeof(entity_slot_t);
+    size_t storage_size = 4 * hot_size + cold_size + slot_of_size + slots_size;
+    storage_size = (storage_size + ENTITY_POOL_ALIGNMENT - 1) / ENTITY_POOL_ALIGNMENT * ENTITY_POOL_ALIGNMENT;
+
+    uint8_t* storage = aligned_alloc(ENTITY_POOL_ALIGNMENT, storage_size);
+    if(storage == NULL) {
+        fprintf(stderr, "Failed to allocate an entity pool of capacity: %zu\n", lane_capacity);
+        exit(EXIT_FAILURE);
+    }
+    memset(storage, 0, storage_size);
+
+    fixed_t* x = (fixed_t*)storage;
+    fixed_t* y = (fixed_t*)(storage + hot_size);
+    fixed_t* prev_y = (fixed_t*)(storage + 2 * hot_size);
+    fixed_t* vy = (fixed_t*)(storage + 3 * hot_size);
+    entity_cold_t* cold = (entity_cold_t*)(storage + 4 * hot_size);
+    uint32_t* slot_of = (uint32_t*)(storage + 4 * hot_size + cold_size);
+    entity_slot_t* slots = (entity_slot_t*)(storage + 4 * hot_size + cold_size + slot_of_size);
+
+    // Carry over the live entities, and every existing slot so that outstanding handles still resolve
+    if(pool->storage != NULL) {
+        memcpy(x, pool->x, pool->count * sizeof(fixed_t));
+        memcpy(y, pool->y, pool->count * sizeof(fixed_t));
+        memcpy(prev_y, pool->prev_y, pool->count * sizeof(fixed_t));
+        memcpy(vy, pool->vy, pool->count * sizeof(fixed_t));
+        memcpy(cold, pool->cold, pool->count * sizeof(entity_cold_t));
+        memcpy(slot_of, pool->slot_of, pool->count * sizeof(uint32_t));
+        memcpy(slots, pool->slots, pool->capacity * sizeof(entity_slot_t));
+        free(pool->storage);
+    }
+
+    // Chain the new slots onto the front of the free list
+    for(size_t slot = pool->capacity; slot < lane_capacity; ++slot) {
+        slots[slot].idx = slot + 1 < lane_capacity ? (uint32_t)(slot + 1) : pool->free_slot;
+        slots[slot].generation = 1;
+    }
+    if(lane_capacity > pool->capacity) {
+        pool->free_slot = (uint32_t)pool->capacity;
+    }
+
+    pool->x = x;
+    pool->y = y;
+    pool->prev_y = prev_y;
+    pool->vy = vy;
+    pool->cold = cold;
+    pool->slot_of = slot_of;
+    pool->slots = slots;
+    pool->capacity = lane_capacity;
+    pool->storage_size = storage_size;
+    pool->storage = storage;
+}
+
+static size_t find_first_y_outside(const fixed_t* const y, const size_t start, const size_t count, const fixed_t min_y, const fixed_t max_y)
+{
+    size_t i = start;
+#if defined(__AVX2__)
+    const __m256i bound_min = _mm256_set1_epi32(min_y);
+    const __m256i bound_max = _mm256_set1_epi32(max_y);
+    for(; i + 8 <= count; i += 8) {
+        const __m256i p = _mm256_loadu_si256((const __m256i*)&y[i]);
+        const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(bound_min, p), _mm256_cmpgt_epi32(p, bound_max));
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(outside));
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i bound_min = _mm_set1_epi32(min_y);
+    const __m128i bound_max = _mm_set1_epi32(max_y);
+    for(; i + 4 <= count; i += 4) {
+        const __m128i p = _mm_loadu_si128((const __m128i*)&y[i]);
+        const __m128i outside = _mm_or_si128(_mm_cmplt_epi32(p, bound_min), _mm_cmpgt_epi32(p, bound_max));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(outside));
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    for(; i < count; ++i) {
+        if(y[i] < min_y || y[i] > max_y) {
+            return i;
+        }
+    }
+    return count;
+}
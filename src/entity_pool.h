@@ -0,0 +1,111 @@
+#ifndef ENTITY_POOL_H
+#define ENTITY_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_rect.h>
+
+#include "animation.h"
+#include "bullet_pattern.h"
+#include "fixed.h"
+
+// ============================================================================
+// Structure-of-arrays entity storage
+// ============================================================================
+
+// Capacities are rounded up to a whole number of SIMD lanes, so that the kernels never need a scalar tail for
+// ranges that start on a multiple of ENTITY_POOL_LANES
+#define ENTITY_POOL_LANES 8
+
+// Pools grow by doubling, up to this many entities
+#define ENTITY_POOL_MAX_CAPACITY ((size_t)1 << 24)
+
+// A stable reference to an entity, which stays valid as other entities are
+// removed and the pool grows. Once the entity itself is removed, the handle no
+// longer resolves, even after its slot is reused. Generations start at one, so
+// a zero-initialised handle never resolves.
+typedef struct {
+    uint32_t slot;
+    uint32_t generation;
+} entity_handle_t;
+
+// A handle slot: while its entity is live, the entity's index, and while free, the next free slot
+typedef struct {
+    uint32_t idx;
+    uint32_t generation;
+} entity_slot_t;
+
+// Cold per-entity data, only touched when spawning, firing, expiring and rendering
+typedef struct {
+    const animation_clip_t* clip;
+    // The bullets the entity fires, or NULL if it does not fire any
+    const bullet_pattern_t* bullet_pattern;
+    uint32_t spawn_step;
+    int32_t sprite_scaling;
+    int32_t render_w;
+    int32_t render_h;
+} entity_cold_t;
+
+// A pool of homogeneous entities. The hot x/y/vy arrays, which are streamed
+// through every frame by the position and cull kernels, are kept apart from the
+// cold render and animation data. prev_y holds each entity's y position before
+// the last integration step, so that rendering can interpolate between the two.
+// Positions are in fixed-point pixels, and velocities in fixed-point pixels per
+// integration step.
+//
+// Every array lives in one arena, which is reallocated at twice the capacity
+// when a push finds the pool full, so spawning never allocates on its own and
+// memory follows the largest number of entities the pool has had to hold.
+// Growth moves the arrays, so pointers into them must not be held across a
+// push. slot_of gives each entity's handle slot, and slots maps each handle
+// slot back to its entity's current index.
+typedef struct {
+    fixed_t* x;
+    fixed_t* y;
+    fixed_t* prev_y;
+    fixed_t* vy;
+    entity_cold_t* cold;
+    uint32_t* slot_of;
+    entity_slot_t* slots;
+    uint32_t free_slot;
+    size_t count;
+    size_t capacity;
+    // The most entities the pool has held at once
+    size_t high_water;
+    size_t storage_size;
+    void* storage;
+} entity_pool_t;
+
+void entity_pool_init(entity_pool_t* pool, size_t capacity);
+void entity_pool_destroy(entity_pool_t* pool);
+
+// Appends an uninitialised entity and returns its index, growing the pool if it is full
+size_t entity_pool_push(entity_pool_t* pool);
+// Removes the entity at the given index by swapping the last entity into its place
+void entity_pool_remove(entity_pool_t* pool, size_t idx);
+
+// Returns a stable handle to the entity at the given index
+entity_handle_t entity_pool_handle(const entity_pool_t* pool, size_t idx);
+// Returns the current index of the entity the handle refers to, or the pool's count if it has been removed
+size_t entity_pool_resolve(const entity_pool_t* pool, entity_handle_t handle);
+
+// Returns the on-screen quad of the entity at the given index, centred on its position rounded down to a whole pixel
+SDL_Rect entity_pool_render_quad(const entity_pool_t* pool, size_t idx);
+// Returns the quad the entity at the given index swept through over the last integration step, covering its on-screen
+// quads at both its previous and current positions
+SDL_Rect entity_pool_swept_quad(const entity_pool_t* pool, size_t idx);
+
+// Advances every entity's y position by its y velocity, saving the previous position
+void entity_pool_integrate_y(entity_pool_t* pool);
+// As entity_pool_integrate_y(), for the entities in [begin, end) only. Disjoint ranges may be integrated concurrently,
+// and begin must be a multiple of ENTITY_POOL_LANES.
+void entity_pool_integrate_y_range(entity_pool_t* pool, size_t begin, size_t end);
+// Removes every entity whose y position is less than min_y or greater than max_y
+void entity_pool_cull_y_outside(entity_pool_t* pool, fixed_t min_y, fixed_t max_y);
+// Integrates and culls every entity in a single sweep, with the same result as entity_pool_integrate_y() followed by
+// entity_pool_cull_y_outside(). Each entity is only loaded once, but the sweep cannot be split between threads, since
+// culled entities are replaced by ones swapped in from the end of the pool.
+void entity_pool_integrate_cull_y(entity_pool_t* pool, fixed_t min_y, fixed_t max_y);
+
+#endif
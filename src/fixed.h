@@ -0,0 +1,44 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdint.h>
+
+// ============================================================================
+// 16.16 fixed-point arithmetic
+// ============================================================================
+
+// The simulation is done entirely in fixed-point, so that it produces the same
+// results on every run, compiler and machine. Floats are only converted to
+// fixed-point when reading configuration, and back when rendering.
+typedef int32_t fixed_t;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE ((fixed_t)1 << FIXED_SHIFT)
+
+static inline fixed_t fixed_from_int(const int32_t i)
+{
+    return (fixed_t)((uint32_t)i << FIXED_SHIFT);
+}
+
+// Rounds towards negative infinity, so that a position's whole pixel does not jump as it crosses zero
+static inline int32_t fixed_to_int(const fixed_t f)
+{
+    return f >> FIXED_SHIFT;
+}
+
+static inline fixed_t fixed_from_float(const float f)
+{
+    return (fixed_t)(f * (float)FIXED_ONE);
+}
+
+static inline float fixed_to_float(const fixed_t f)
+{
+    return (float)f / (float)FIXED_ONE;
+}
+
+static inline fixed_t fixed_mul(const fixed_t a, const fixed_t b)
+{
+    return (fixed_t)(((int64_t)a * b) >> FIXED_SHIFT);
+}
+
+#endif
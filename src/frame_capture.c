@@ -0,0 +1,178 @@
+#include "frame_capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL_error.h>
+#include <SDL_image.h>
+#include <SDL_pixels.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define MAX_PATH_LENGTH 4096
+
+const char* frame_capture_format_names[FRAME_CAPTURE_FORMATS_TOTAL] = {
+    [FRAME_CAPTURE_FORMAT_RAW] = "raw",
+    [FRAME_CAPTURE_FORMAT_PNG] = "png"
+};
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static int run_writer(void* data);
+static bool write_frame(const frame_capture_t* capture, const frame_capture_slot_t* slot);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void frame_capture_init(frame_capture_t* const capture, const char* const directory, const frame_capture_format_t format, const int32_t width, const int32_t height, const size_t num_slots)
+{
+    capture->directory = directory;
+    capture->format = format;
+    capture->width = width;
+    capture->height = height;
+    capture->num_slots = num_slots > 0 ? num_slots : 1;
+    capture->head = 0;
+    capture->tail = 0;
+    capture->count = 0;
+    capture->quit = false;
+    capture->num_written = 0;
+    capture->num_dropped = 0;
+    capture->num_failed = 0;
+
+    capture->slots = calloc(capture->num_slots, sizeof(frame_capture_slot_t));
+    capture->mutex = SDL_CreateMutex();
+    capture->frame_ready = SDL_CreateCond();
+    capture->slot_free = SDL_CreateCond();
+    if(capture->slots == NULL || capture->mutex == NULL || capture->frame_ready == NULL || capture->slot_free == NULL) {
+        fprintf(stderr, "Failed to create a frame capture ring of %zu frames: %s\n", capture->num_slots, SDL_GetError());
+        exit(EXIT_FAILURE);
+    }
+
+    // Every buffer is allocated now, so that capturing a frame never allocates
+    for(size_t i = 0; i < capture->num_slots; ++i) {
+        capture->slots[i].surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+        if(capture->slots[i].surface == NULL) {
+            fprintf(stderr, "Failed to allocate a %dx%d frame capture buffer: %s\n", width, height, SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    capture->thread = SDL_CreateThread(run_writer, "capture", capture);
+    if(capture->thread == NULL) {
+        fprintf(stderr, "SDL frame capture thread could not be created: %s\n", SDL_GetError());
+        exit(EXIT_FAILURE);
+    }
+}
+
+void frame_capture_destroy(frame_capture_t* const capture)
+{
+    SDL_LockMutex(capture->mutex);
+    capture->quit = true;
+    SDL_CondSignal(capture->frame_ready);
+    SDL_UnlockMutex(capture->mutex);
+    SDL_WaitThread(capture->thread, NULL);
+    capture->thread = NULL;
+
+    for(size_t i = 0; i < capture->num_slots; ++i) {
+        SDL_FreeSurface(capture->slots[i].surface);
+    }
+    free(capture->slots);
+    capture->slots = NULL;
+    capture->num_slots = 0;
+
+    SDL_DestroyCond(capture->slot_free);
+    SDL_DestroyCond(capture->frame_ready);
+    SDL_DestroyMutex(capture->mutex);
+}
+
+SDL_Surface* frame_capture_begin(frame_capture_t* const capture, const bool wait)
+{
+    SDL_LockMutex(capture->mutex);
+    while(capture->count == capture->num_slots && wait) {
+        SDL_CondWait(capture->slot_free, capture->mutex);
+    }
+    const bool full = capture->count == capture->num_slots;
+    if(full) {
+        ++capture->num_dropped;
+    }
+    SDL_UnlockMutex(capture->mutex);
+
+    // The head slot is not visible to the writer until it is submitted, so it is filled without holding the lock
+    return full ? NULL : capture->slots[capture->head].surface;
+}
+
+void frame_capture_submit(frame_capture_t* const capture, const uint32_t frame)
+{
+    SDL_LockMutex(capture->mutex);
+    capture->slots[capture->head].frame = frame;
+    capture->head = (capture->head + 1) % capture->num_slots;
+    ++capture->count;
+    SDL_CondSignal(capture->frame_ready);
+    SDL_UnlockMutex(capture->mutex);
+}
+
+static int run_writer(void* const data)
+{
+    frame_capture_t* capture = data;
+
+    SDL_LockMutex(capture->mutex);
+    for(;;) {
+        while(capture->count == 0 && !capture->quit) {
+            SDL_CondWait(capture->frame_ready, capture->mutex);
+        }
+        if(capture->count == 0) {
+            break;
+        }
+
+        // The tail slot is not reused until it is released, so it is written without holding the lock
+        const frame_capture_slot_t* slot = &capture->slots[capture->tail];
+        SDL_UnlockMutex(capture->mutex);
+        const bool written = write_frame(capture, slot);
+        SDL_LockMutex(capture->mutex);
+
+        if(written) {
+            ++capture->num_written;
+        }
+        else if(capture->num_failed++ == 0) {
+            // Only the first failure is reported, since every later frame is likely to fail the same way
+            fprintf(stderr, "Failed to write captured frame %u to: \"%s\"\n", slot->frame, capture->directory);
+        }
+        capture->tail = (capture->tail + 1) % capture->num_slots;
+        --capture->count;
+        SDL_CondSignal(capture->slot_free);
+    }
+    SDL_UnlockMutex(capture->mutex);
+
+    return 0;
+}
+
+static bool write_frame(const frame_capture_t* const capture, const frame_capture_slot_t* const slot)
+{
+    char filename[MAX_PATH_LENGTH];
+    const int length = snprintf(filename, MAX_PATH_LENGTH, "%s/frame-%06u.%s", capture->directory, slot->frame, frame_capture_format_names[capture->format]);
+    if(length < 0 || length >= MAX_PATH_LENGTH) {
+        return false;
+    }
+
+    if(capture->format == FRAME_CAPTURE_FORMAT_PNG) {
+        return IMG_SavePNG(slot->surface, filename) == 0;
+    }
+
+    // Raw frames are the bare rows of ARGB8888 pixels, without any padding
+    FILE* file = fopen(filename, "wb");
+    if(file == NULL) {
+        return false;
+    }
+    const SDL_Surface* surface = slot->surface;
+    const size_t row_size = (size_t)surface->w * sizeof(uint32_t);
+    bool written = true;
+    for(int y = 0; y < surface->h && written; ++y) {
+        written = fwrite((const uint8_t*)surface->pixels + (size_t)y * (size_t)surface->pitch, 1, row_size, file) == row_size;
+    }
+    return fclose(file) == 0 && written;
+}
@@ -0,0 +1,72 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_mutex.h>
+#include <SDL_surface.h>
+#include <SDL_thread.h>
+
+// ============================================================================
+// Frame capture
+// ============================================================================
+
+typedef enum {
+    FRAME_CAPTURE_FORMAT_RAW,
+    FRAME_CAPTURE_FORMAT_PNG,
+    FRAME_CAPTURE_FORMATS_TOTAL
+} frame_capture_format_t;
+
+// A captured frame waiting to be written, held in an ARGB8888 surface over a
+// buffer allocated once up front
+typedef struct {
+    SDL_Surface* surface;
+    uint32_t frame;
+} frame_capture_slot_t;
+
+// Writes rendered frames to a directory, one file per frame, on a background
+// thread. Frames are copied into a fixed ring of buffers by the rendering
+// thread, which never touches the disk. When every buffer is still waiting to
+// be written, the frame is either dropped and counted, or, when the caller can
+// afford to, waited for.
+typedef struct {
+    const char* directory;
+    frame_capture_format_t format;
+    int32_t width;
+    int32_t height;
+
+    frame_capture_slot_t* slots;
+    size_t num_slots;
+    // The slot the next frame is copied into, the next slot to be written, and the number of slots waiting to be written
+    size_t head;
+    size_t tail;
+    size_t count;
+
+    SDL_Thread* thread;
+    SDL_mutex* mutex;
+    SDL_cond* frame_ready;
+    SDL_cond* slot_free;
+    bool quit;
+
+    // Counted once each frame has been handled, and only read once the writer has stopped
+    uint32_t num_written;
+    uint32_t num_dropped;
+    uint32_t num_failed;
+} frame_capture_t;
+
+extern const char* frame_capture_format_names[FRAME_CAPTURE_FORMATS_TOTAL];
+
+// Starts a writer thread with a ring of num_slots frame buffers of the given size
+void frame_capture_init(frame_capture_t* capture, const char* directory, frame_capture_format_t format, int32_t width, int32_t height, size_t num_slots);
+// Writes every frame still in the ring, then stops the writer thread
+void frame_capture_destroy(frame_capture_t* capture);
+
+// Returns the next free buffer to copy a frame into, or NULL if the frame is dropped because every buffer is in use.
+// If wait is set, blocks until a buffer is free instead of dropping the frame.
+SDL_Surface* frame_capture_begin(frame_capture_t* capture, bool wait);
+// Hands the buffer returned by frame_capture_begin() to the writer thread, to be written as the given frame number
+void frame_capture_submit(frame_capture_t* capture, uint32_t frame);
+
+#endif
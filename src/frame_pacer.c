@@ -0,0 +1,73 @@
+#include "frame_pacer.h"
+
+#include <SDL_timer.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Sleeps can overshoot by about a scheduler tick, so the last part of each wait spins instead
+#define FRAME_PACER_SPIN_S 0.002
+
+const char* frame_pacing_mode_names[FRAME_PACING_MODES_TOTAL] = {
+    [FRAME_PACING_VSYNC] = "vsync",
+    [FRAME_PACING_FIXED] = "fixed",
+    [FRAME_PACING_UNCAPPED] = "uncapped"
+};
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void frame_pacer_init(frame_pacer_t* const pacer, const frame_pacing_mode_t mode, const uint32_t target_fps, const size_t max_samples)
+{
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    pacer->mode = mode;
+    pacer->target_fps = target_fps > 0 ? target_fps : 1;
+    pacer->frame_ticks = frequency / pacer->target_fps;
+    pacer->spin_ticks = (uint64_t)(FRAME_PACER_SPIN_S * (double)frequency);
+    pacer->next_frame_time = 0;
+    pacer->last_present_time = 0;
+    sample_stats_init(&pacer->frame_time_ms, max_samples);
+}
+
+void frame_pacer_destroy(frame_pacer_t* const pacer)
+{
+    sample_stats_destroy(&pacer->frame_time_ms);
+}
+
+uint64_t frame_pacer_next_frame_time(const frame_pacer_t* const pacer)
+{
+    return pacer->mode == FRAME_PACING_FIXED ? pacer->next_frame_time : 0;
+}
+
+void frame_pacer_wait(frame_pacer_t* const pacer)
+{
+    if(pacer->mode != FRAME_PACING_FIXED) {
+        return;
+    }
+
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t now = SDL_GetPerformanceCounter();
+    while(now < pacer->next_frame_time) {
+        const uint64_t remaining_ticks = pacer->next_frame_time - now;
+        if(remaining_ticks > pacer->spin_ticks) {
+            SDL_Delay((uint32_t)((remaining_ticks - pacer->spin_ticks) * 1000 / frequency));
+        }
+        now = SDL_GetPerformanceCounter();
+    }
+}
+
+void frame_pacer_presented(frame_pacer_t* const pacer)
+{
+    const uint64_t now = SDL_GetPerformanceCounter();
+    if(pacer->last_present_time != 0) {
+        sample_stats_add(&pacer->frame_time_ms, (double)(now - pacer->last_present_time) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    }
+    pacer->last_present_time = now;
+
+    pacer->next_frame_time += pacer->frame_ticks;
+    if(pacer->next_frame_time + pacer->frame_ticks < now) {
+        pacer->next_frame_time = now + pacer->frame_ticks;
+    }
+}
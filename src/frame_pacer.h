@@ -0,0 +1,57 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sample_stats.h"
+
+// ============================================================================
+// Frame pacing
+// ============================================================================
+
+typedef enum {
+    // Frames are presented in step with the display, which blocks until each refresh
+    FRAME_PACING_VSYNC,
+    // Frames are presented at a fixed rate, by sleeping and then spinning until each is due
+    FRAME_PACING_FIXED,
+    // Frames are presented as fast as they can be rendered
+    FRAME_PACING_UNCAPPED,
+    FRAME_PACING_MODES_TOTAL
+} frame_pacing_mode_t;
+
+// Schedules when each frame is presented, and measures the time between
+// consecutive presents so that their jitter can be reported.
+//
+// In fixed mode, each frame is due one period after the last was due, rather
+// than after it was presented, so that small delays do not accumulate. A frame
+// more than a whole period late starts a new schedule instead of being
+// followed by a burst of frames to catch up.
+typedef struct {
+    frame_pacing_mode_t mode;
+    uint32_t target_fps;
+    // The time between frames in fixed mode, and below which waiting spins instead of sleeping, in counter ticks
+    uint64_t frame_ticks;
+    uint64_t spin_ticks;
+    uint64_t next_frame_time;
+
+    // When the last frame was presented, or 0 before the first
+    uint64_t last_present_time;
+    // The time between consecutive presents, in milliseconds
+    sample_stats_t frame_time_ms;
+} frame_pacer_t;
+
+extern const char* frame_pacing_mode_names[FRAME_PACING_MODES_TOTAL];
+
+// Starts pacing frames, keeping at most max_samples frame times for percentiles
+void frame_pacer_init(frame_pacer_t* pacer, frame_pacing_mode_t mode, uint32_t target_fps, size_t max_samples);
+void frame_pacer_destroy(frame_pacer_t* pacer);
+
+// Returns when the next frame is due to be presented, or 0 if it is presented as soon as it is ready
+uint64_t frame_pacer_next_frame_time(const frame_pacer_t* pacer);
+// In fixed mode, waits until the next frame is due. Otherwise returns immediately.
+void frame_pacer_wait(frame_pacer_t* pacer);
+// Records that a frame has just been presented, and schedules the next one
+void frame_pacer_presented(frame_pacer_t* pacer);
+
+#endif
@@ -0,0 +1,58 @@
+#include "input_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void input_queue_init(input_queue_t* const queue, const size_t capacity)
+{
+    size_t pow2_capacity = 1;
+    while(pow2_capacity < capacity) {
+        pow2_capacity *= 2;
+    }
+
+    queue->events = calloc(pow2_capacity, sizeof(SDL_Event));
+    if(queue->events == NULL) {
+        fprintf(stderr, "Failed to allocate an input queue of capacity: %zu\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+    queue->capacity = pow2_capacity;
+    atomic_init(&queue->num_pushed, 0);
+    atomic_init(&queue->num_popped, 0);
+}
+
+void input_queue_destroy(input_queue_t* const queue)
+{
+    free(queue->events);
+    queue->events = NULL;
+    queue->capacity = 0;
+}
+
+bool input_queue_push(input_queue_t* const queue, const SDL_Event* const event)
+{
+    const size_t num_pushed = atomic_load_explicit(&queue->num_pushed, memory_order_relaxed);
+    const size_t num_popped = atomic_load_explicit(&queue->num_popped, memory_order_acquire);
+    if(num_pushed - num_popped == queue->capacity) {
+        return false;
+    }
+
+    queue->events[num_pushed & (queue->capacity - 1)] = *event;
+    atomic_store_explicit(&queue->num_pushed, num_pushed + 1, memory_order_release);
+    return true;
+}
+
+bool input_queue_pop(input_queue_t* const queue, SDL_Event* const event)
+{
+    const size_t num_popped = atomic_load_explicit(&queue->num_popped, memory_order_relaxed);
+    const size_t num_pushed = atomic_load_explicit(&queue->num_pushed, memory_order_acquire);
+    if(num_pushed == num_popped) {
+        return false;
+    }
+
+    *event = queue->events[num_popped & (queue->capacity - 1)];
+    atomic_store_explicit(&queue->num_popped, num_popped + 1, memory_order_release);
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <SDL_events.h>
+
+// ============================================================================
+// Input event queue
+// ============================================================================
+
+// A bounded, lock-free queue of events, passed from one producer thread to one
+// consumer thread. Capacities are rounded up to a power of two.
+typedef struct {
+    SDL_Event* events;
+    size_t capacity;
+    // The number of events ever pushed and popped, which only their own thread writes
+    atomic_size_t num_pushed;
+    atomic_size_t num_popped;
+} input_queue_t;
+
+void input_queue_init(input_queue_t* queue, size_t capacity);
+void input_queue_destroy(input_queue_t* queue);
+
+// Appends an event, returning false if the queue is full
+bool input_queue_push(input_queue_t* queue, const SDL_Event* event);
+// Removes the oldest event, returning false if the queue is empty
+bool input_queue_pop(input_queue_t* queue, SDL_Event* event);
+
+#endif
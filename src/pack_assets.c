@@ -0,0 +1,127 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_rect.h>
+#include <SDL_surface.h>
+
+#include "asset_pack.h"
+#include "atlas.h"
+#include "sprites.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define MAX_PATH_LENGTH 4096
+
+// Each sheet's image, relative to the data directory
+const char* sheet_filenames[ATLAS_SHEETS_TOTAL] = {
+    [ATLAS_SHEET_BACKGROUND] = "desert-background-looped.png",
+    [ATLAS_SHEET_SPACESHIP] = "ship.png",
+    [ATLAS_SHEET_PROJECTILE] = "laser-bolts.png",
+    [ATLAS_SHEET_SMALL_ENEMY] = "enemy-small.png",
+    [ATLAS_SHEET_EXPLOSION] = "explosion.png"
+};
+
+// The sprites within each sheet, in sheet coordinates. The background is a
+// single screen-sized window onto its sheet, which scrolls up it over time.
+SDL_Rect background_sprite_quads[BACKGROUND_SPRITES_TOTAL] = {
+    [BACKGROUND_1] = { .x = 0, .y = 266, .w = 256, .h = 304 }
+};
+
+SDL_Rect spaceship_sprite_quads[SPACESHIP_SPRITES_TOTAL] = {
+    [SPACESHIP_BANK_HARD_LEFT_1] = { .x = 0, .y = 0, .w = 16, .h = 24 },
+    [SPACESHIP_BANK_LEFT_1] = { .x = 16, .y = 0, .w = 16, .h = 24 },
+    [SPACESHIP_STATIONARY_1] = { .x = 32, .y = 0, .w = 16, .h = 24 },
+    [SPACESHIP_BANK_RIGHT_1] = { .x = 48, .y = 0, .w = 16, .h = 24 },
+    [SPACESHIP_BANK_HARD_RIGHT_1] = { .x = 64, .y = 0, .w = 16, .h = 24 },
+    [SPACESHIP_BANK_HARD_LEFT_2] = { .x = 0, .y = 24, .w = 16, .h = 24 },
+    [SPACESHIP_BANK_LEFT_2] = { .x = 16, .y = 24, .w = 16, .h = 24 },
+    [SPACESHIP_STATIONARY_2] = { .x = 32, .y = 24, .w = 16, .h = 24 },
+    [SPACESHIP_BANK_RIGHT_2] = { .x = 48, .y = 24, .w = 16, .h = 24 },
+    [SPACESHIP_BANK_HARD_RIGHT_2] = { .x = 64, .y = 24, .w = 16, .h = 24 }
+};
+
+SDL_Rect projectile_sprite_quads[PROJECTILE_SPRITES_TOTAL] = {
+    [PROJECTILE_1] = { .x = 0, .y = 0, .w = 16, .h = 32 },
+    [PROJECTILE_2] = { .x = 16, .y = 0, .w = 16, .h = 32 },
+    [PROJECTILE_ORB_1] = { .x = 4, .y = 5, .w = 9, .h = 9 },
+    [PROJECTILE_ORB_2] = { .x = 18, .y = 5, .w = 9, .h = 9 }
+};
+
+SDL_Rect small_enemy_sprite_quads[SMALL_ENEMY_SPRITES_TOTAL] = {
+    [SMALL_ENEMY_1] = { .x = 0, .y = 0, .w = 16, .h = 16 },
+    [SMALL_ENEMY_2] = { .x = 16, .y = 0, .w = 16, .h = 16 }
+};
+
+SDL_Rect explosion_sprite_quads[EXPLOSION_TOTAL] = {
+    [EXPLOSION_1] = { .x = 0, .y = 0, .w = 16, .h = 16 },
+    [EXPLOSION_2] = { .x = 16, .y = 0, .w = 16, .h = 16 },
+    [EXPLOSION_3] = { .x = 32, .y = 0, .w = 16, .h = 16 },
+    [EXPLOSION_4] = { .x = 48, .y = 0, .w = 16, .h = 16 },
+    [EXPLOSION_5] = { .x = 64, .y = 0, .w = 16, .h = 16 }
+};
+
+// ============================================================================
+// Main entry point
+// ============================================================================
+
+// Decodes and packs every sprite sheet in the data directory into an asset pack
+int main(int argc, char* argv[])
+{
+    if(argc != 3) {
+        fprintf(stderr, "Usage: %s DATA_DIR OUTPUT\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* data_dir = argv[1];
+    const char* output_filename = argv[2];
+
+    int imgFlags = IMG_INIT_PNG;
+    if(!(IMG_Init(imgFlags) & imgFlags)) {
+        fprintf(stderr, "SDL image could no be initialised: %s\n", IMG_GetError());
+        return EXIT_FAILURE;
+    }
+
+    char paths[ATLAS_SHEETS_TOTAL][MAX_PATH_LENGTH];
+    atlas_sheet_t sheets[ATLAS_SHEETS_TOTAL];
+    SDL_Rect* quads[ATLAS_SHEETS_TOTAL] = {
+        [ATLAS_SHEET_BACKGROUND] = background_sprite_quads,
+        [ATLAS_SHEET_SPACESHIP] = spaceship_sprite_quads,
+        [ATLAS_SHEET_PROJECTILE] = projectile_sprite_quads,
+        [ATLAS_SHEET_SMALL_ENEMY] = small_enemy_sprite_quads,
+        [ATLAS_SHEET_EXPLOSION] = explosion_sprite_quads
+    };
+    const size_t num_quads[ATLAS_SHEETS_TOTAL] = {
+        [ATLAS_SHEET_BACKGROUND] = BACKGROUND_SPRITES_TOTAL,
+        [ATLAS_SHEET_SPACESHIP] = SPACESHIP_SPRITES_TOTAL,
+        [ATLAS_SHEET_PROJECTILE] = PROJECTILE_SPRITES_TOTAL,
+        [ATLAS_SHEET_SMALL_ENEMY] = SMALL_ENEMY_SPRITES_TOTAL,
+        [ATLAS_SHEET_EXPLOSION] = EXPLOSION_TOTAL
+    };
+    for(size_t i = 0; i < ATLAS_SHEETS_TOTAL; ++i) {
+        const int length = snprintf(paths[i], MAX_PATH_LENGTH, "%s/%s", data_dir, sheet_filenames[i]);
+        if(length < 0 || length >= MAX_PATH_LENGTH) {
+            fprintf(stderr, "Data directory path is too long: \"%s\"\n", data_dir);
+            return EXIT_FAILURE;
+        }
+        sheets[i].filename = paths[i];
+        sheets[i].quads = quads[i];
+        sheets[i].num_quads = num_quads[i];
+    }
+
+    // The atlas is built in the format its texture is created with, so the pack can be uploaded as it is
+    SDL_Surface* atlas = atlas_build(sheets, ATLAS_SHEETS_TOTAL);
+    const bool written = asset_pack_write(output_filename, atlas, sheets, ATLAS_SHEETS_TOTAL);
+    if(written) {
+        printf("Packed %d sheets into a %dx%d atlas: \"%s\"\n", ATLAS_SHEETS_TOTAL, atlas->w, atlas->h, output_filename);
+    }
+
+    SDL_FreeSurface(atlas);
+    IMG_Quit();
+
+    return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
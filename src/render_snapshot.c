@@ -0,0 +1,89 @@
+#include "render_snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Set in shared_idx when the shared snapshot was published after the reader last took one
+#define RENDER_SNAPSHOT_FRESH 0x4U
+#define RENDER_SNAPSHOT_IDX_MASK 0x3U
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void render_snapshot_buffer_init(render_snapshot_buffer_t* const buffer, const size_t sprite_capacity)
+{
+    for(size_t i = 0; i < 3; ++i) {
+        render_snapshot_t* snapshot = &buffer->snapshots[i];
+        snapshot->sprites = malloc(sprite_capacity * sizeof(render_sprite_t));
+        if(snapshot->sprites == NULL) {
+            fprintf(stderr, "Failed to allocate a render snapshot of capacity: %zu\n", sprite_capacity);
+            exit(EXIT_FAILURE);
+        }
+        snapshot->count = 0;
+        snapshot->capacity = sprite_capacity;
+        snapshot->step_time = 0;
+        snapshot->num_inputs = 0;
+    }
+    buffer->write_idx = 0;
+    atomic_init(&buffer->shared_idx, 1);
+    buffer->read_idx = 2;
+}
+
+void render_snapshot_buffer_destroy(render_snapshot_buffer_t* const buffer)
+{
+    for(size_t i = 0; i < 3; ++i) {
+        free(buffer->snapshots[i].sprites);
+        buffer->snapshots[i].sprites = NULL;
+        buffer->snapshots[i].count = 0;
+        buffer->snapshots[i].capacity = 0;
+    }
+}
+
+render_snapshot_t* render_snapshot_buffer_begin_write(render_snapshot_buffer_t* const buffer)
+{
+    render_snapshot_t* snapshot = &buffer->snapshots[buffer->write_idx];
+    snapshot->count = 0;
+    return snapshot;
+}
+
+void render_snapshot_buffer_publish(render_snapshot_buffer_t* const buffer)
+{
+    // Swap the finished snapshot with the shared one. If the reader never took the old shared snapshot, it is simply overwritten next time.
+    const unsigned int previous = atomic_exchange_explicit(&buffer->shared_idx, buffer->write_idx | RENDER_SNAPSHOT_FRESH, memory_order_acq_rel);
+    buffer->write_idx = previous & RENDER_SNAPSHOT_IDX_MASK;
+}
+
+const render_snapshot_t* render_snapshot_buffer_read(render_snapshot_buffer_t* const buffer)
+{
+    // Only swap when something new has been published, otherwise keep drawing the current snapshot
+    if(atomic_load_explicit(&buffer->shared_idx, memory_order_relaxed) & RENDER_SNAPSHOT_FRESH) {
+        const unsigned int shared = atomic_exchange_explicit(&buffer->shared_idx, buffer->read_idx, memory_order_acq_rel);
+        buffer->read_idx = shared & RENDER_SNAPSHOT_IDX_MASK;
+    }
+    return &buffer->snapshots[buffer->read_idx];
+}
+
+void render_snapshot_add(render_snapshot_t* const snapshot, const SDL_Rect* const sprite_quad, const SDL_FRect* const render_quad, const float prev_x, const float prev_y)
+{
+    if(snapshot->count == snapshot->capacity) {
+        const size_t capacity = snapshot->capacity == 0 ? 64 : snapshot->capacity * 2;
+        render_sprite_t* sprites = realloc(snapshot->sprites, capacity * sizeof(render_sprite_t));
+        if(sprites == NULL) {
+            fprintf(stderr, "Failed to grow a render snapshot to capacity: %zu\n", capacity);
+            exit(EXIT_FAILURE);
+        }
+        snapshot->sprites = sprites;
+        snapshot->capacity = capacity;
+    }
+
+    render_sprite_t* sprite = &snapshot->sprites[snapshot->count++];
+    sprite->sprite_quad = *sprite_quad;
+    sprite->render_quad = *render_quad;
+    sprite->prev_x = prev_x;
+    sprite->prev_y = prev_y;
+}
@@ -0,0 +1,59 @@
+#ifndef RENDER_SNAPSHOT_H
+#define RENDER_SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_rect.h>
+
+// ============================================================================
+// Render snapshots
+// ============================================================================
+
+// A sprite as it was at the end of a simulation step, at its sub-pixel position.
+// The previous origin is where render_quad was one step earlier, so that it can
+// be interpolated.
+typedef struct {
+    SDL_Rect sprite_quad;
+    SDL_FRect render_quad;
+    float prev_x;
+    float prev_y;
+} render_sprite_t;
+
+// Everything the renderer needs to draw one simulation step, in layering order
+typedef struct {
+    render_sprite_t* sprites;
+    size_t count;
+    size_t capacity;
+    // The performance counter time that the step represents
+    uint64_t step_time;
+    // The number of input events the simulation had applied by the end of the step
+    uint32_t num_inputs;
+} render_snapshot_t;
+
+// Triple-buffered snapshots, shared between one writer and one reader thread
+// without locking. The writer always has a snapshot to fill, and the reader
+// always has a complete snapshot to draw, which is the latest one published.
+typedef struct {
+    render_snapshot_t snapshots[3];
+    // The index of the snapshot that is neither being written nor read, flagged when it is newer than the reader's
+    atomic_uint shared_idx;
+    unsigned int write_idx;
+    unsigned int read_idx;
+} render_snapshot_buffer_t;
+
+void render_snapshot_buffer_init(render_snapshot_buffer_t* buffer, size_t sprite_capacity);
+void render_snapshot_buffer_destroy(render_snapshot_buffer_t* buffer);
+
+// Returns the writer's snapshot, emptied and ready to be filled
+render_snapshot_t* render_snapshot_buffer_begin_write(render_snapshot_buffer_t* buffer);
+// Publishes the writer's snapshot, making it the one returned by the next read
+void render_snapshot_buffer_publish(render_snapshot_buffer_t* buffer);
+// Returns the most recently published snapshot, which stays valid until the next read
+const render_snapshot_t* render_snapshot_buffer_read(render_snapshot_buffer_t* buffer);
+
+// Appends a sprite, growing the snapshot if it is full
+void render_snapshot_add(render_snapshot_t* snapshot, const SDL_Rect* sprite_quad, const SDL_FRect* render_quad, float prev_x, float prev_y);
+
+#endif
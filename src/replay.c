@@ -0,0 +1,195 @@
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Recordings are a fixed header followed by every event, with each field stored little-endian:
+//
+//   magic "SHMR", u32 version, u32 seed, i32 time step (16.16 seconds), u32 steps, u64 checksum, u32 event count
+//   per event: u32 step, i32 key, u8 pressed
+#define REPLAY_MAGIC "SHMR"
+// Bumped whenever the same seed and input no longer reproduce the same session
+#define REPLAY_VERSION 2
+#define REPLAY_HEADER_SIZE 32
+#define REPLAY_EVENT_SIZE 9
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void put_u32(uint8_t* p, uint32_t v);
+static void put_u64(uint8_t* p, uint64_t v);
+static uint32_t get_u32(const uint8_t* p);
+static uint64_t get_u64(const uint8_t* p);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void replay_init(replay_t* const replay, const uint32_t seed, const fixed_t time_step_s)
+{
+    replay->seed = seed;
+    replay->time_step_s = time_step_s;
+    replay->num_steps = 0;
+    replay->checksum = 0;
+    replay->events = NULL;
+    replay->num_events = 0;
+    replay->capacity = 0;
+    replay->next_event = 0;
+}
+
+void replay_destroy(replay_t* const replay)
+{
+    free(replay->events);
+    replay->events = NULL;
+    replay->num_events = 0;
+    replay->capacity = 0;
+}
+
+void replay_record(replay_t* const replay, const uint32_t step, const SDL_Event* const event)
+{
+    if((event->type != SDL_KEYDOWN && event->type != SDL_KEYUP) || event->key.repeat != 0) {
+        return;
+    }
+
+    if(replay->num_events == replay->capacity) {
+        const size_t capacity = replay->capacity == 0 ? 256 : replay->capacity * 2;
+        replay_event_t* events = realloc(replay->events, capacity * sizeof(replay_event_t));
+        if(events == NULL) {
+            fprintf(stderr, "Failed to grow a recording to capacity: %zu\n", capacity);
+            exit(EXIT_FAILURE);
+        }
+        replay->events = events;
+        replay->capacity = capacity;
+    }
+
+    replay_event_t* recorded = &replay->events[replay->num_events++];
+    recorded->step = step;
+    recorded->key = event->key.keysym.sym;
+    recorded->pressed = event->type == SDL_KEYDOWN;
+}
+
+bool replay_save(const replay_t* const replay, const char* const filename)
+{
+    FILE* file = fopen(filename, "wb");
+    if(file == NULL) {
+        fprintf(stderr, "Failed to open recording file: \"%s\"\n", filename);
+        return false;
+    }
+
+    uint8_t header[REPLAY_HEADER_SIZE];
+    memcpy(header, REPLAY_MAGIC, 4);
+    put_u32(&header[4], REPLAY_VERSION);
+    put_u32(&header[8], replay->seed);
+    put_u32(&header[12], (uint32_t)replay->time_step_s);
+    put_u32(&header[16], replay->num_steps);
+    put_u64(&header[20], replay->checksum);
+    put_u32(&header[28], (uint32_t)replay->num_events);
+    bool written = fwrite(header, sizeof(header), 1, file) == 1;
+
+    for(size_t i = 0; i < replay->num_events && written; ++i) {
+        uint8_t record[REPLAY_EVENT_SIZE];
+        put_u32(&record[0], replay->events[i].step);
+        put_u32(&record[4], (uint32_t)replay->events[i].key);
+        record[8] = replay->events[i].pressed ? 1 : 0;
+        written = fwrite(record, sizeof(record), 1, file) == 1;
+    }
+
+    if(fclose(file) != 0 || !written) {
+        fprintf(stderr, "Failed to write recording file: \"%s\"\n", filename);
+        return false;
+    }
+
+    return true;
+}
+
+void replay_load(replay_t* const replay, const char* const filename)
+{
+    FILE* file = fopen(filename, "rb");
+    if(file == NULL) {
+        fprintf(stderr, "Failed to open recording file: \"%s\"\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t header[REPLAY_HEADER_SIZE];
+    if(fread(header, sizeof(header), 1, file) != 1 || memcmp(header, REPLAY_MAGIC, 4) != 0 || get_u32(&header[4]) != REPLAY_VERSION) {
+        fprintf(stderr, "Not a version %d recording: \"%s\"\n", REPLAY_VERSION, filename);
+        exit(EXIT_FAILURE);
+    }
+
+    replay_init(replay, get_u32(&header[8]), (fixed_t)get_u32(&header[12]));
+    replay->num_steps = get_u32(&header[16]);
+    replay->checksum = get_u64(&header[20]);
+    const size_t num_events = get_u32(&header[28]);
+
+    replay->events = malloc((num_events > 0 ? num_events : 1) * sizeof(replay_event_t));
+    if(replay->events == NULL) {
+        fprintf(stderr, "Failed to allocate a recording of %zu events\n", num_events);
+        exit(EXIT_FAILURE);
+    }
+    replay->capacity = num_events;
+
+    for(size_t i = 0; i < num_events; ++i) {
+        uint8_t record[REPLAY_EVENT_SIZE];
+        if(fread(record, sizeof(record), 1, file) != 1) {
+            fprintf(stderr, "Recording is truncated: \"%s\"\n", filename);
+            exit(EXIT_FAILURE);
+        }
+        replay->events[i].step = get_u32(&record[0]);
+        replay->events[i].key = (int32_t)get_u32(&record[4]);
+        replay->events[i].pressed = record[8] != 0;
+    }
+    replay->num_events = num_events;
+
+    fclose(file);
+}
+
+bool replay_next_event(replay_t* const replay, const uint32_t step, SDL_Event* const event)
+{
+    if(replay->next_event == replay->num_events || replay->events[replay->next_event].step > step) {
+        return false;
+    }
+
+    const replay_event_t* recorded = &replay->events[replay->next_event++];
+    memset(event, 0, sizeof(SDL_Event));
+    event->type = recorded->pressed ? SDL_KEYDOWN : SDL_KEYUP;
+    event->key.keysym.sym = recorded->key;
+    return true;
+}
+
+static void put_u32(uint8_t* const p, const uint32_t v)
+{
+    for(size_t i = 0; i < 4; ++i) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void put_u64(uint8_t* const p, const uint64_t v)
+{
+    for(size_t i = 0; i < 8; ++i) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t* const p)
+{
+    uint32_t v = 0;
+    for(size_t i = 0; i < 4; ++i) {
+        v |= (uint32_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t* const p)
+{
+    uint64_t v = 0;
+    for(size_t i = 0; i < 8; ++i) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    return v;
+}
@@ -0,0 +1,53 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_events.h>
+
+#include "fixed.h"
+
+// ============================================================================
+// Input recording and replay
+// ============================================================================
+
+// A key press or release, applied at the start of the given simulation step
+typedef struct {
+    uint32_t step;
+    int32_t key;
+    bool pressed;
+} replay_event_t;
+
+// Everything needed to reproduce a session: the seed and step length it was
+// simulated with, and every input event keyed by the step it was applied on.
+// The number of steps simulated and a checksum of the final state are kept so
+// that a replay can tell whether it reproduced the session exactly.
+typedef struct {
+    uint32_t seed;
+    fixed_t time_step_s;
+    uint32_t num_steps;
+    uint64_t checksum;
+    replay_event_t* events;
+    size_t num_events;
+    size_t capacity;
+    // The next event to be played back
+    size_t next_event;
+} replay_t;
+
+// Starts an empty recording
+void replay_init(replay_t* replay, uint32_t seed, fixed_t time_step_s);
+void replay_destroy(replay_t* replay);
+
+// Appends a key event applied at the start of the given step. Other events, and key repeats, are ignored.
+void replay_record(replay_t* replay, uint32_t step, const SDL_Event* event);
+// Writes the recording to a file, returning whether it succeeded
+bool replay_save(const replay_t* replay, const char* filename);
+
+// Reads a recording from a file, ready to be played back from the first step
+void replay_load(replay_t* replay, const char* filename);
+// Returns the next recorded event due at the start of the given step, or false once there are none left for it
+bool replay_next_event(replay_t* replay, uint32_t step, SDL_Event* event);
+
+#endif
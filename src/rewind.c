@@ -0,0 +1,990 @@
+#include "rewind.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Frame tables start with room for this many rows, and grow by doubling
+#define REWIND_TABLE_INITIAL_CAPACITY 64
+
+// The index of where each step is encoded takes this fraction of the budget, which is enough for several minutes of
+// steps where nothing much happens
+#define REWIND_INDEX_SHARE 16
+
+// A row that does not match its own prediction is looked for among this many rows, back from the end of the frame
+// before, as entities removed from the end are skipped over
+#define REWIND_MAX_MOVE_SEARCH 8
+
+// Once this many rows in a row are not found among the rows they may have moved from, the rest of the table is not
+// searched, since its new rows were most likely added rather than moved
+#define REWIND_MAX_FAILED_MOVES 8
+
+// A varint takes at most this many bytes for 32 bits
+#define REWIND_MAX_VARINT_SIZE 5
+
+// Entities point at one of the instance's animation clips, which frames store as its position in this order
+#define REWIND_NUM_CLIPS 7
+
+enum {
+    ENTITY_COLUMN_X,
+    ENTITY_COLUMN_Y,
+    ENTITY_COLUMN_VY,
+    ENTITY_COLUMN_CLIP,
+    ENTITY_COLUMN_BULLET_PATTERN,
+    ENTITY_COLUMN_SPAWN_STEP,
+    ENTITY_COLUMN_SPRITE_SCALING,
+    ENTITY_COLUMN_RENDER_W,
+    ENTITY_COLUMN_RENDER_H,
+    ENTITY_COLUMNS_TOTAL
+};
+
+enum {
+    BULLET_COLUMN_X,
+    BULLET_COLUMN_Y,
+    BULLET_COLUMN_VX,
+    BULLET_COLUMN_VY,
+    BULLET_COLUMN_SPAWN_STEP,
+    BULLET_COLUMNS_TOTAL
+};
+
+// What a column is predicted to hold from the frame before: the same row of the base column, plus the added column's
+// if there is one. Rows the frame before did not have are predicted to be zero.
+typedef struct {
+    int base;
+    int added;
+} prediction_t;
+
+#define NO_COLUMN (-1)
+
+// Entities only move along y, so an entity that has not changed apart from moving is predicted exactly
+static const prediction_t entity_predictions[ENTITY_COLUMNS_TOTAL] = {
+    [ENTITY_COLUMN_X] = {ENTITY_COLUMN_X, NO_COLUMN},
+    [ENTITY_COLUMN_Y] = {ENTITY_COLUMN_Y, ENTITY_COLUMN_VY},
+    [ENTITY_COLUMN_VY] = {ENTITY_COLUMN_VY, NO_COLUMN},
+    [ENTITY_COLUMN_CLIP] = {ENTITY_COLUMN_CLIP, NO_COLUMN},
+    [ENTITY_COLUMN_BULLET_PATTERN] = {ENTITY_COLUMN_BULLET_PATTERN, NO_COLUMN},
+    [ENTITY_COLUMN_SPAWN_STEP] = {ENTITY_COLUMN_SPAWN_STEP, NO_COLUMN},
+    [ENTITY_COLUMN_SPRITE_SCALING] = {ENTITY_COLUMN_SPRITE_SCALING, NO_COLUMN},
+    [ENTITY_COLUMN_RENDER_W] = {ENTITY_COLUMN_RENDER_W, NO_COLUMN},
+    [ENTITY_COLUMN_RENDER_H] = {ENTITY_COLUMN_RENDER_H, NO_COLUMN}
+};
+
+static const prediction_t bullet_predictions[BULLET_COLUMNS_TOTAL] = {
+    [BULLET_COLUMN_X] = {BULLET_COLUMN_X, BULLET_COLUMN_VX},
+    [BULLET_COLUMN_Y] = {BULLET_COLUMN_Y, BULLET_COLUMN_VY},
+    [BULLET_COLUMN_VX] = {BULLET_COLUMN_VX, NO_COLUMN},
+    [BULLET_COLUMN_VY] = {BULLET_COLUMN_VY, NO_COLUMN},
+    [BULLET_COLUMN_SPAWN_STEP] = {BULLET_COLUMN_SPAWN_STEP, NO_COLUMN}
+};
+
+static const prediction_t* const table_predictions[REWIND_TABLES_TOTAL] = {
+    [REWIND_TABLE_PROJECTILES] = entity_predictions,
+    [REWIND_TABLE_ENEMIES] = entity_predictions,
+    [REWIND_TABLE_EXPLOSIONS] = entity_predictions,
+    [REWIND_TABLE_BULLETS] = bullet_predictions
+};
+
+static const size_t table_num_columns[REWIND_TABLES_TOTAL] = {
+    [REWIND_TABLE_PROJECTILES] = ENTITY_COLUMNS_TOTAL,
+    [REWIND_TABLE_ENEMIES] = ENTITY_COLUMNS_TOTAL,
+    [REWIND_TABLE_EXPLOSIONS] = ENTITY_COLUMNS_TOTAL,
+    [REWIND_TABLE_BULLETS] = BULLET_COLUMNS_TOTAL
+};
+
+// Keyframes' headers are encoded against one that is all zero
+static const int32_t empty_header[REWIND_HEADER_SIZE];
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void init_frame(rewind_frame_t* frame);
+static void destroy_frame(rewind_frame_t* frame);
+static void reserve_table(rewind_table_t* table, size_t capacity);
+static void swap_frames(rewind_frame_t* a, rewind_frame_t* b);
+
+static void list_clips(const simulation_t* sim, const animation_clip_t** clips);
+static void capture_frame(rewind_frame_t* frame, const simulation_t* sim);
+static void capture_entities(rewind_table_t* table, const entity_pool_t* pool, const simulation_t* sim, const animation_clip_t* const* clips);
+static void capture_bullets(rewind_table_t* table, const bullet_pool_t* pool);
+static void restore_frame(const rewind_frame_t* frame, simulation_t* sim);
+static void restore_entities(entity_pool_t* pool, const rewind_table_t* table, simulation_t* sim, const animation_clip_t* const* clips);
+static void restore_bullets(bullet_pool_t* pool, const rewind_table_t* table);
+
+static void encode_frame(rewind_buffer_t* buffer, const rewind_frame_t* base, const rewind_frame_t* frame);
+static void reserve_encoded(rewind_buffer_t* buffer, size_t size);
+static uint32_t find_changed_columns(const rewind_table_t* table, int32_t* const* predicted, size_t start, size_t num_rows, uint32_t columns);
+static void predict_rows(int32_t* const* predicted, size_t num_columns, const rewind_table_t* base, const prediction_t* predictions, size_t start, size_t num_rows);
+static void predict_row(int32_t* const* predicted, size_t num_columns, size_t row, const rewind_table_t* base, const prediction_t* predictions, size_t base_row);
+static void predict_keyframe_rows(int32_t* const* predicted, const rewind_table_t* table, size_t start, size_t num_rows);
+static size_t find_moved_rows(rewind_buffer_t* buffer, const rewind_table_t* table, const rewind_table_t* base, const prediction_t* predictions, size_t start, size_t num_rows, uint32_t changed, size_t* last_moved_row, size_t* source_end, size_t* num_failed);
+static bool is_row_predicted_from(const rewind_table_t* table, size_t row, const rewind_table_t* base, const prediction_t* predictions, size_t base_row);
+static void encode_runs(rewind_buffer_t* buffer, const int32_t* values, const int32_t* predicted, size_t count);
+static size_t find_first_mismatch(const int32_t* values, const int32_t* predicted, size_t start, size_t count);
+static const uint8_t* decode_frame(const uint8_t* data, const rewind_frame_t* base, rewind_frame_t* frame);
+static const uint8_t* decode_runs(const uint8_t* data, int32_t* values, size_t count);
+static uint8_t* put_varint(uint8_t* out, uint32_t value);
+static const uint8_t* get_varint(const uint8_t* data, uint32_t* value);
+
+static bool find_space(const rewind_buffer_t* buffer, size_t size, size_t* offset);
+static void evict_oldest_keyframe(rewind_buffer_t* buffer);
+static const rewind_entry_t* entry_at(const rewind_buffer_t* buffer, size_t idx);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void rewind_init(rewind_buffer_t* const buffer, const size_t budget, const uint32_t keyframe_interval)
+{
+    buffer->keyframe_interval = keyframe_interval > 0 ? keyframe_interval : 1;
+
+    buffer->entries_capacity = budget / REWIND_INDEX_SHARE / sizeof(rewind_entry_t);
+    buffer->entries_capacity = buffer->entries_capacity > 0 ? buffer->entries_capacity : 1;
+    const size_t entries_size = buffer->entries_capacity * sizeof(rewind_entry_t);
+    buffer->data_capacity = budget > entries_size ? budget - entries_size : 0;
+    buffer->entries = malloc(entries_size);
+    buffer->data = malloc(buffer->data_capacity > 0 ? buffer->data_capacity : 1);
+    if(buffer->entries == NULL || buffer->data == NULL) {
+        fprintf(stderr, "Failed to allocate a rewind buffer of %zu bytes\n", budget);
+        exit(EXIT_FAILURE);
+    }
+    buffer->data_end = 0;
+    buffer->first_entry = 0;
+    buffer->num_entries = 0;
+
+    init_frame(&buffer->last);
+    init_frame(&buffer->current);
+    init_frame(&buffer->seek_frames[0]);
+    init_frame(&buffer->seek_frames[1]);
+    buffer->last_keyframe_step = 0;
+    buffer->needs_keyframe = false;
+    buffer->encoded = NULL;
+    buffer->encoded_size = 0;
+    buffer->encoded_capacity = 0;
+
+    buffer->retained_size = 0;
+    buffer->num_recorded = 0;
+    buffer->num_keyframes = 0;
+    buffer->total_recorded_size = 0;
+    buffer->num_dropped = 0;
+}
+
+void rewind_destroy(rewind_buffer_t* const buffer)
+{
+    free(buffer->encoded);
+    destroy_frame(&buffer->seek_frames[1]);
+    destroy_frame(&buffer->seek_frames[0]);
+    destroy_frame(&buffer->current);
+    destroy_frame(&buffer->last);
+    free(buffer->data);
+    free(buffer->entries);
+    buffer->encoded = NULL;
+    buffer->data = NULL;
+    buffer->entries = NULL;
+    buffer->num_entries = 0;
+}
+
+void rewind_record(rewind_buffer_t* const buffer, const simulation_t* const sim)
+{
+    capture_frame(&buffer->current, sim);
+
+    // Steps are only encoded against the one before, so a gap, or a ring with nothing left to decode from, needs a
+    // keyframe
+    bool is_keyframe = buffer->num_entries == 0 || buffer->needs_keyframe ||
+        sim->step != entry_at(buffer, buffer->num_entries - 1)->step + 1 ||
+        sim->step - buffer->last_keyframe_step >= buffer->keyframe_interval;
+    encode_frame(buffer, is_keyframe ? NULL : &buffer->last, &buffer->current);
+
+    size_t offset;
+    while(buffer->num_entries == buffer->entries_capacity || !find_space(buffer, buffer->encoded_size, &offset)) {
+        if(buffer->num_entries == 0) {
+            // Not even the whole budget can hold this step, so there is nothing before it left to rewind to either
+            ++buffer->num_dropped;
+            swap_frames(&buffer->last, &buffer->current);
+            return;
+        }
+
+        evict_oldest_keyframe(buffer);
+        if(buffer->num_entries == 0 && !is_keyframe) {
+            is_keyframe = true;
+            encode_frame(buffer, NULL, &buffer->current);
+        }
+    }
+
+    memcpy(buffer->data + offset, buffer->encoded, buffer->encoded_size);
+    rewind_entry_t* entry = &buffer->entries[(buffer->first_entry + buffer->num_entries) % buffer->entries_capacity];
+    entry->step = sim->step;
+    entry->is_keyframe = is_keyframe;
+    entry->offset = offset;
+    entry->size = buffer->encoded_size;
+    ++buffer->num_entries;
+    buffer->data_end = offset + buffer->encoded_size;
+    buffer->retained_size += buffer->encoded_size;
+
+    buffer->needs_keyframe = false;
+    if(is_keyframe) {
+        buffer->last_keyframe_step = sim->step;
+        ++buffer->num_keyframes;
+    }
+    ++buffer->num_recorded;
+    buffer->total_recorded_size += buffer->encoded_size;
+    swap_frames(&buffer->last, &buffer->current);
+}
+
+void rewind_truncate(rewind_buffer_t* const buffer, const uint32_t step)
+{
+    bool truncated = false;
+    while(buffer->num_entries > 0 && entry_at(buffer, buffer->num_entries - 1)->step > step) {
+        buffer->retained_size -= entry_at(buffer, buffer->num_entries - 1)->size;
+        --buffer->num_entries;
+        truncated = true;
+    }
+    if(!truncated) {
+        return;
+    }
+
+    // The next step follows on from one that is no longer the last recorded, which the encoder still holds
+    if(buffer->num_entries > 0) {
+        const rewind_entry_t* newest = entry_at(buffer, buffer->num_entries - 1);
+        buffer->data_end = newest->offset + newest->size;
+    }
+    buffer->needs_keyframe = true;
+}
+
+bool rewind_range(const rewind_buffer_t* const buffer, uint32_t* const oldest, uint32_t* const newest)
+{
+    if(buffer->num_entries == 0) {
+        return false;
+    }
+    *oldest = entry_at(buffer, 0)->step;
+    *newest = entry_at(buffer, buffer->num_entries - 1)->step;
+    return true;
+}
+
+bool rewind_seek(rewind_buffer_t* const buffer, const uint32_t step, simulation_t* const sim)
+{
+    // Steps only ever increase through the ring
+    size_t begin = 0;
+    size_t end = buffer->num_entries;
+    while(begin < end) {
+        const size_t mid = begin + (end - begin) / 2;
+        if(entry_at(buffer, mid)->step < step) {
+            begin = mid + 1;
+        }
+        else {
+            end = mid;
+        }
+    }
+    if(begin == buffer->num_entries || entry_at(buffer, begin)->step != step) {
+        return false;
+    }
+
+    // The oldest entry is always a keyframe, so there is always one to start decoding from
+    size_t keyframe = begin;
+    while(!entry_at(buffer, keyframe)->is_keyframe) {
+        --keyframe;
+    }
+
+    const rewind_frame_t* base = NULL;
+    rewind_frame_t* frame = NULL;
+    for(size_t i = keyframe; i <= begin; ++i) {
+        const rewind_entry_t* entry = entry_at(buffer, i);
+        frame = &buffer->seek_frames[(i - keyframe) % 2];
+        decode_frame(buffer->data + entry->offset, base, frame);
+        base = frame;
+    }
+
+    restore_frame(frame, sim);
+    return true;
+}
+
+size_t rewind_retained_size(const rewind_buffer_t* const buffer)
+{
+    return buffer->retained_size;
+}
+
+static void init_frame(rewind_frame_t* const frame)
+{
+    memset(frame->header, 0, sizeof(frame->header));
+    for(int t = 0; t < REWIND_TABLES_TOTAL; ++t) {
+        rewind_table_t* table = &frame->tables[t];
+        table->num_columns = table_num_columns[t];
+        table->count = 0;
+        table->capacity = 0;
+        table->storage = NULL;
+        for(size_t c = 0; c < REWIND_MAX_COLUMNS; ++c) {
+            table->columns[c] = NULL;
+        }
+        reserve_table(table, REWIND_TABLE_INITIAL_CAPACITY);
+    }
+}
+
+static void destroy_frame(rewind_frame_t* const frame)
+{
+    for(int t = 0; t < REWIND_TABLES_TOTAL; ++t) {
+        free(frame->tables[t].storage);
+        frame->tables[t].storage = NULL;
+        frame->tables[t].count = 0;
+        frame->tables[t].capacity = 0;
+    }
+}
+
+static void reserve_table(rewind_table_t* const table, const size_t capacity)
+{
+    if(capacity <= table->capacity) {
+        return;
+    }
+
+    size_t new_capacity = table->capacity > 0 ? table->capacity : REWIND_TABLE_INITIAL_CAPACITY;
+    while(new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+
+    // Every column lives in one allocation, and the rows already held are carried over
+    int32_t* storage = malloc(new_capacity * table->num_columns * sizeof(int32_t));
+    if(storage == NULL) {
+        fprintf(stderr, "Failed to grow a rewind frame to %zu rows\n", new_capacity);
+        exit(EXIT_FAILURE);
+    }
+    for(size_t c = 0; c < table->num_columns; ++c) {
+        int32_t* column = storage + c * new_capacity;
+        if(table->count > 0) {
+            memcpy(column, table->columns[c], table->count * sizeof(int32_t));
+        }
+        table->columns[c] = column;
+    }
+    free(table->storage);
+    table->storage = storage;
+    table->capacity = new_capacity;
+}
+
+static void swap_frames(rewind_frame_t* const a, rewind_frame_t* const b)
+{
+    const rewind_frame_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void list_clips(const simulation_t* const sim, const animation_clip_t** const clips)
+{
+    // Ordered by how many entities point at each, so that looking one up usually stops at the first
+    clips[0] = &sim->projectile_clip;
+    clips[1] = &sim->small_enemy_clip;
+    clips[2] = &sim->explosion_clip;
+    clips[3] = &sim->enemy_bullet_clip;
+    clips[4] = &sim->spaceship_stationary_clip;
+    clips[5] = &sim->spaceship_bank_hard_left_clip;
+    clips[6] = &sim->spaceship_bank_hard_right_clip;
+}
+
+static void capture_frame(rewind_frame_t* const frame, const simulation_t* const sim)
+{
+    int32_t* header = frame->header;
+    header[REWIND_HEADER_STEP] = (int32_t)sim->step;
+    header[REWIND_HEADER_GAME_OVER] = sim->game_over;
+    header[REWIND_HEADER_INPUT] = (int32_t)sim->input;
+    header[REWIND_HEADER_SPACESHIP_X] = sim->spaceship.position.x;
+    header[REWIND_HEADER_SPACESHIP_Y] = sim->spaceship.position.y;
+    header[REWIND_HEADER_SPACESHIP_VELOCITY_X] = sim->spaceship.velocity.x;
+    header[REWIND_HEADER_SPACESHIP_VELOCITY_Y] = sim->spaceship.velocity.y;
+    header[REWIND_HEADER_SPACESHIP_QUAD_X] = sim->spaceship.render_quad.x;
+    header[REWIND_HEADER_SPACESHIP_QUAD_Y] = sim->spaceship.render_quad.y;
+    header[REWIND_HEADER_SPACESHIP_FIRING] = sim->spaceship.is_firing;
+    header[REWIND_HEADER_SPACESHIP_SHOT_TIMER] = sim->spaceship.time_till_next_shot_s;
+    header[REWIND_HEADER_ENEMY_SPAWN_TIMER] = sim->time_till_next_enemy_spawn_s;
+    header[REWIND_HEADER_ENEMIES_SPAWNED] = (int32_t)sim->num_enemies_spawned;
+    header[REWIND_HEADER_BACKGROUND_Y] = sim->background_quad.y;
+    header[REWIND_HEADER_BACKGROUND_COUNTER] = (int32_t)sim->background_counter;
+    for(int i = 0; i < 4; ++i) {
+        header[REWIND_HEADER_SPAWN_RNG + 2 * i] = (int32_t)(uint32_t)sim->spawn_rng.s[i];
+        header[REWIND_HEADER_SPAWN_RNG + 2 * i + 1] = (int32_t)(uint32_t)(sim->spawn_rng.s[i] >> 32);
+        header[REWIND_HEADER_SCENARIO_RNG + 2 * i] = (int32_t)(uint32_t)sim->scenario_rng.s[i];
+        header[REWIND_HEADER_SCENARIO_RNG + 2 * i + 1] = (int32_t)(uint32_t)(sim->scenario_rng.s[i] >> 32);
+    }
+
+    const animation_clip_t* clips[REWIND_NUM_CLIPS];
+    list_clips(sim, clips);
+    capture_entities(&frame->tables[REWIND_TABLE_PROJECTILES], &sim->projectiles, sim, clips);
+    capture_entities(&frame->tables[REWIND_TABLE_ENEMIES], &sim->enemies, sim, clips);
+    capture_entities(&frame->tables[REWIND_TABLE_EXPLOSIONS], &sim->explosions, sim, clips);
+    capture_bullets(&frame->tables[REWIND_TABLE_BULLETS], &sim->bullets);
+}
+
+static void capture_entities(rewind_table_t* const table, const entity_pool_t* const pool, const simulation_t* const sim, const animation_clip_t* const* const clips)
+{
+    const size_t count = pool->count;
+    reserve_table(table, count);
+    table->count = count;
+    if(count == 0) {
+        return;
+    }
+
+    memcpy(table->columns[ENTITY_COLUMN_X], pool->x, count * sizeof(fixed_t));
+    memcpy(table->columns[ENTITY_COLUMN_Y], pool->y, count * sizeof(fixed_t));
+    memcpy(table->columns[ENTITY_COLUMN_VY], pool->vy, count * sizeof(fixed_t));
+    for(size_t i = 0; i < count; ++i) {
+        const entity_cold_t* cold = &pool->cold[i];
+        int32_t clip = 0;
+        while(clip < REWIND_NUM_CLIPS - 1 && clips[clip] != cold->clip) {
+            ++clip;
+        }
+        table->columns[ENTITY_COLUMN_CLIP][i] = clip;
+        table->columns[ENTITY_COLUMN_BULLET_PATTERN][i] = cold->bullet_pattern == NULL ? -1 : (int32_t)(cold->bullet_pattern - sim->enemy_bullet_patterns);
+        table->columns[ENTITY_COLUMN_SPAWN_STEP][i] = (int32_t)cold->spawn_step;
+        table->columns[ENTITY_COLUMN_SPRITE_SCALING][i] = cold->sprite_scaling;
+        table->columns[ENTITY_COLUMN_RENDER_W][i] = cold->render_w;
+        table->columns[ENTITY_COLUMN_RENDER_H][i] = cold->render_h;
+    }
+}
+
+static void capture_bullets(rewind_table_t* const table, const bullet_pool_t* const pool)
+{
+    const size_t count = pool->count;
+    reserve_table(table, count);
+    table->count = count;
+    if(count == 0) {
+        return;
+    }
+
+    memcpy(table->columns[BULLET_COLUMN_X], pool->x, count * sizeof(fixed_t));
+    memcpy(table->columns[BULLET_COLUMN_Y], pool->y, count * sizeof(fixed_t));
+    memcpy(table->columns[BULLET_COLUMN_VX], pool->vx, count * sizeof(fixed_t));
+    memcpy(table->columns[BULLET_COLUMN_VY], pool->vy, count * sizeof(fixed_t));
+    memcpy(table->columns[BULLET_COLUMN_SPAWN_STEP], pool->spawn_step, count * sizeof(uint32_t));
+}
+
+static void restore_frame(const rewind_frame_t* const frame, simulation_t* const sim)
+{
+    const int32_t* header = frame->header;
+    sim->step = (uint32_t)header[REWIND_HEADER_STEP];
+    sim->game_over = header[REWIND_HEADER_GAME_OVER] != 0;
+    sim->input = (simulation_input_t)header[REWIND_HEADER_INPUT];
+    sim->spaceship.position.x = header[REWIND_HEADER_SPACESHIP_X];
+    sim->spaceship.position.y = header[REWIND_HEADER_SPACESHIP_Y];
+    sim->spaceship.velocity.x = header[REWIND_HEADER_SPACESHIP_VELOCITY_X];
+    sim->spaceship.velocity.y = header[REWIND_HEADER_SPACESHIP_VELOCITY_Y];
+    // The spaceship's previous position is not recorded either, see restore_entities(). It is taken to be a step's worth
+    // of its velocity back, which is per second, or where it is once the game is over. That is only wrong for a step it
+    // spent against the edge of the screen, and for the step the game ended on.
+    sim->spaceship.previous_position = sim->spaceship.position;
+    if(!sim->game_over) {
+        sim->spaceship.previous_position.x -= fixed_mul(sim->spaceship.velocity.x, sim->config.time_step_s);
+        sim->spaceship.previous_position.y -= fixed_mul(sim->spaceship.velocity.y, sim->config.time_step_s);
+    }
+    sim->spaceship.render_quad.x = header[REWIND_HEADER_SPACESHIP_QUAD_X];
+    sim->spaceship.render_quad.y = header[REWIND_HEADER_SPACESHIP_QUAD_Y];
+    sim->spaceship.is_firing = header[REWIND_HEADER_SPACESHIP_FIRING] != 0;
+    sim->spaceship.time_till_next_shot_s = header[REWIND_HEADER_SPACESHIP_SHOT_TIMER];
+    sim->time_till_next_enemy_spawn_s = header[REWIND_HEADER_ENEMY_SPAWN_TIMER];
+    sim->num_enemies_spawned = (uint32_t)header[REWIND_HEADER_ENEMIES_SPAWNED];
+    sim->background_quad.y = header[REWIND_HEADER_BACKGROUND_Y];
+    sim->background_counter = (uint32_t)header[REWIND_HEADER_BACKGROUND_COUNTER];
+    for(int i = 0; i < 4; ++i) {
+        sim->spawn_rng.s[i] = (uint64_t)(uint32_t)header[REWIND_HEADER_SPAWN_RNG + 2 * i] |
+            (uint64_t)(uint32_t)header[REWIND_HEADER_SPAWN_RNG + 2 * i + 1] << 32;
+        sim->scenario_rng.s[i] = (uint64_t)(uint32_t)header[REWIND_HEADER_SCENARIO_RNG + 2 * i] |
+            (uint64_t)(uint32_t)header[REWIND_HEADER_SCENARIO_RNG + 2 * i + 1] << 32;
+    }
+
+    const animation_clip_t* clips[REWIND_NUM_CLIPS];
+    list_clips(sim, clips);
+    restore_entities(&sim->projectiles, &frame->tables[REWIND_TABLE_PROJECTILES], sim, clips);
+    restore_entities(&sim->enemies, &frame->tables[REWIND_TABLE_ENEMIES], sim, clips);
+    restore_entities(&sim->explosions, &frame->tables[REWIND_TABLE_EXPLOSIONS], sim, clips);
+    restore_bullets(&sim->bullets, &frame->tables[REWIND_TABLE_BULLETS]);
+}
+
+static void restore_entities(entity_pool_t* const pool, const rewind_table_t* const table, simulation_t* const sim, const animation_clip_t* const* const clips)
+{
+    // Nothing holds on to handles between steps, so the restored entities are free to take new ones
+    while(pool->count > 0) {
+        entity_pool_remove(pool, pool->count - 1);
+    }
+    const size_t count = table->count;
+    for(size_t i = 0; i < count; ++i) {
+        entity_pool_push(pool);
+    }
+    if(count == 0) {
+        return;
+    }
+
+    memcpy(pool->x, table->columns[ENTITY_COLUMN_X], count * sizeof(fixed_t));
+    memcpy(pool->y, table->columns[ENTITY_COLUMN_Y], count * sizeof(fixed_t));
+    memcpy(pool->vy, table->columns[ENTITY_COLUMN_VY], count * sizeof(fixed_t));
+    // Previous positions are not recorded, since the next step overwrites them before reading them. Only rendering reads
+    // them in between, and a browsed step is drawn where it ended, so they are taken to be a step's velocity back. That
+    // is only wrong for what spawned during the step, and for everything once the game is over.
+    for(size_t i = 0; i < count; ++i) {
+        entity_cold_t* cold = &pool->cold[i];
+        pool->prev_y[i] = pool->y[i] - pool->vy[i];
+        const int32_t bullet_pattern = table->columns[ENTITY_COLUMN_BULLET_PATTERN][i];
+        cold->clip = clips[table->columns[ENTITY_COLUMN_CLIP][i]];
+        cold->bullet_pattern = bullet_pattern < 0 ? NULL : &sim->enemy_bullet_patterns[bullet_pattern];
+        cold->spawn_step = (uint32_t)table->columns[ENTITY_COLUMN_SPAWN_STEP][i];
+        cold->sprite_scaling = table->columns[ENTITY_COLUMN_SPRITE_SCALING][i];
+        cold->render_w = table->columns[ENTITY_COLUMN_RENDER_W][i];
+        cold->render_h = table->columns[ENTITY_COLUMN_RENDER_H][i];
+    }
+}
+
+static void restore_bullets(bullet_pool_t* const pool, const rewind_table_t* const table)
+{
+    const size_t count = table->count;
+    pool->count = 0;
+    if(count == 0) {
+        return;
+    }
+
+    bullet_pool_push(pool, count);
+    memcpy(pool->x, table->columns[BULLET_COLUMN_X], count * sizeof(fixed_t));
+    memcpy(pool->y, table->columns[BULLET_COLUMN_Y], count * sizeof(fixed_t));
+    memcpy(pool->vx, table->columns[BULLET_COLUMN_VX], count * sizeof(fixed_t));
+    memcpy(pool->vy, table->columns[BULLET_COLUMN_VY], count * sizeof(fixed_t));
+    memcpy(pool->spawn_step, table->columns[BULLET_COLUMN_SPAWN_STEP], count * sizeof(uint32_t));
+    // Previous positions are not recorded, see restore_entities()
+    for(size_t i = 0; i < count; ++i) {
+        pool->prev_x[i] = pool->x[i] - pool->vx[i];
+        pool->prev_y[i] = pool->y[i] - pool->vy[i];
+    }
+}
+
+// A frame is encoded as its header, then each table in turn: its row count, then each block of rows. A block holds the
+// rows that moved since the frame before, a bitmask of the columns that still differ anywhere from their prediction,
+// and each of those columns. Without a frame before, the frame is a keyframe, and its blocks leave out moves and
+// predict each value from the row before.
+static void encode_frame(rewind_buffer_t* const buffer, const rewind_frame_t* const base, const rewind_frame_t* const frame)
+{
+    buffer->encoded_size = 0;
+    encode_runs(buffer, frame->header, base != NULL ? base->header : empty_header, REWIND_HEADER_SIZE);
+
+    for(int t = 0; t < REWIND_TABLES_TOTAL; ++t) {
+        const rewind_table_t* table = &frame->tables[t];
+        const rewind_table_t* base_table = base != NULL ? &base->tables[t] : NULL;
+        const prediction_t* predictions = table_predictions[t];
+        const size_t count = table->count;
+
+        reserve_encoded(buffer, REWIND_MAX_VARINT_SIZE);
+        buffer->encoded_size = (size_t)(put_varint(buffer->encoded + buffer->encoded_size, (uint32_t)count) - buffer->encoded);
+
+        int32_t* predicted[REWIND_MAX_COLUMNS];
+        for(size_t c = 0; c < table->num_columns; ++c) {
+            predicted[c] = buffer->predicted[c];
+        }
+
+        size_t last_moved_row = 0;
+        size_t source_end = base_table != NULL ? base_table->count : 0;
+        size_t num_failed_moves = 0;
+        for(size_t start = 0; start < count; start += REWIND_BLOCK_SIZE) {
+            const size_t num_rows = count - start < REWIND_BLOCK_SIZE ? count - start : REWIND_BLOCK_SIZE;
+            if(base_table == NULL) {
+                predict_keyframe_rows(predicted, table, start, num_rows);
+            }
+            else {
+                predict_rows(predicted, table->num_columns, base_table, predictions, start, num_rows);
+            }
+            uint32_t changed = find_changed_columns(table, predicted, start, num_rows, (1U << table->num_columns) - 1);
+
+            // Moves are only looked for where something changed, and can only leave fewer columns changed
+            size_t num_moves = 0;
+            if(base_table != NULL && changed != 0 && num_failed_moves < REWIND_MAX_FAILED_MOVES) {
+                num_moves = find_moved_rows(buffer, table, base_table, predictions, start, num_rows, changed, &last_moved_row, &source_end, &num_failed_moves);
+                if(num_moves > 0) {
+                    changed = find_changed_columns(table, predicted, start, num_rows, changed);
+                }
+            }
+
+            reserve_encoded(buffer, (2 + 2 * num_moves) * REWIND_MAX_VARINT_SIZE);
+            uint8_t* out = buffer->encoded + buffer->encoded_size;
+            if(base_table != NULL) {
+                out = put_varint(out, (uint32_t)num_moves);
+                for(size_t m = 0; m < 2 * num_moves; ++m) {
+                    out = put_varint(out, buffer->moves[m]);
+                }
+            }
+            out = put_varint(out, changed);
+            buffer->encoded_size = (size_t)(out - buffer->encoded);
+
+            for(size_t c = 0; c < table->num_columns; ++c) {
+                if(changed & (1U << c)) {
+                    encode_runs(buffer, table->columns[c] + start, predicted[c], num_rows);
+                }
+            }
+        }
+    }
+}
+
+static void reserve_encoded(rewind_buffer_t* const buffer, const size_t size)
+{
+    if(buffer->encoded_size + size <= buffer->encoded_capacity) {
+        return;
+    }
+
+    size_t capacity = buffer->encoded_capacity > 0 ? buffer->encoded_capacity : 1024;
+    while(capacity < buffer->encoded_size + size) {
+        capacity *= 2;
+    }
+    uint8_t* encoded = realloc(buffer->encoded, capacity);
+    if(encoded == NULL) {
+        fprintf(stderr, "Failed to grow the rewind encoding buffer to %zu bytes\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+    buffer->encoded = encoded;
+    buffer->encoded_capacity = capacity;
+}
+
+// Returns which of the given columns differ from their prediction anywhere in the given rows
+static uint32_t find_changed_columns(const rewind_table_t* const table, int32_t* const* const predicted, const size_t start, const size_t num_rows, const uint32_t columns)
+{
+    uint32_t changed = 0;
+    for(size_t c = 0; c < table->num_columns; ++c) {
+        if((columns & (1U << c)) && memcmp(table->columns[c] + start, predicted[c], num_rows * sizeof(int32_t)) != 0) {
+            changed |= 1U << c;
+        }
+    }
+    return changed;
+}
+
+// Predicts the given rows from the frame before, into columns that start at the first of them
+static void predict_rows(int32_t* const* const predicted, const size_t num_columns, const rewind_table_t* const base, const prediction_t* const predictions, const size_t start, const size_t num_rows)
+{
+    const size_t num_predicted = base->count <= start ? 0 : base->count - start < num_rows ? base->count - start : num_rows;
+    for(size_t c = 0; c < num_columns; ++c) {
+        int32_t* values = predicted[c];
+        if(num_predicted > 0) {
+            const int32_t* base_values = base->columns[predictions[c].base] + start;
+            if(predictions[c].added == NO_COLUMN) {
+                memcpy(values, base_values, num_predicted * sizeof(int32_t));
+            }
+            else {
+                const int32_t* added = base->columns[predictions[c].added] + start;
+                for(size_t i = 0; i < num_predicted; ++i) {
+                    values[i] = (int32_t)((uint32_t)base_values[i] + (uint32_t)added[i]);
+                }
+            }
+        }
+        if(num_rows > num_predicted) {
+            memset(values + num_predicted, 0, (num_rows - num_predicted) * sizeof(int32_t));
+        }
+    }
+}
+
+static void predict_row(int32_t* const* const predicted, const size_t num_columns, const size_t row, const rewind_table_t* const base, const prediction_t* const predictions, const size_t base_row)
+{
+    for(size_t c = 0; c < num_columns; ++c) {
+        const uint32_t added = predictions[c].added == NO_COLUMN ? 0 : (uint32_t)base->columns[predictions[c].added][base_row];
+        predicted[c][row] = (int32_t)((uint32_t)base->columns[predictions[c].base][base_row] + added);
+    }
+}
+
+static void predict_keyframe_rows(int32_t* const* const predicted, const rewind_table_t* const table, const size_t start, const size_t num_rows)
+{
+    for(size_t c = 0; c < table->num_columns; ++c) {
+        const int32_t* values = table->columns[c];
+        predicted[c][0] = start > 0 ? values[start - 1] : 0;
+        memcpy(predicted[c] + 1, values + start, (num_rows - 1) * sizeof(int32_t));
+    }
+}
+
+// Pools remove entities by swapping the last one into their place, so a row that does not match its own prediction has
+// usually been moved there from the end of the frame before. Moves are taken from the end backwards, as removals make
+// them, and a move is only found if it matches its new row exactly. Each is stored as the distance from the last row
+// moved, and how many rows were skipped back from the one the last was moved from. Rows not found since the last move
+// are counted, and the search stops once there are too many.
+static size_t find_moved_rows(rewind_buffer_t* const buffer, const rewind_table_t* const table, const rewind_table_t* const base, const prediction_t* const predictions, const size_t start, const size_t num_rows, const uint32_t changed, size_t* const last_moved_row, size_t* const source_end, size_t* const num_failed)
+{
+    if(*source_end <= start + 1) {
+        return 0;
+    }
+
+    uint8_t* mismatched = buffer->mismatched;
+    memset(mismatched, 0, num_rows);
+    for(size_t c = 0; c < table->num_columns; ++c) {
+        if(!(changed & (1U << c))) {
+            continue;
+        }
+        const int32_t* values = table->columns[c] + start;
+        const int32_t* predicted = buffer->predicted[c];
+        for(size_t i = find_first_mismatch(values, predicted, 0, num_rows); i < num_rows; i = find_first_mismatch(values, predicted, i + 1, num_rows)) {
+            mismatched[i] = 1;
+        }
+    }
+
+    int32_t* predicted[REWIND_MAX_COLUMNS];
+    for(size_t c = 0; c < table->num_columns; ++c) {
+        predicted[c] = buffer->predicted[c];
+    }
+
+    size_t num_moves = 0;
+    const uint8_t* next;
+    for(size_t i = 0; i < num_rows && (next = memchr(mismatched + i, 1, num_rows - i)) != NULL; ++i) {
+        i = (size_t)(next - mismatched);
+        const size_t row = start + i;
+        if(*source_end <= row + 1) {
+            break;
+        }
+
+        const size_t min_source = *source_end > row + 1 + REWIND_MAX_MOVE_SEARCH ? *source_end - REWIND_MAX_MOVE_SEARCH : row + 1;
+        bool found = false;
+        for(size_t source = *source_end; source-- > min_source;) {
+            if(is_row_predicted_from(table, row, base, predictions, source)) {
+                predict_row(predicted, table->num_columns, i, base, predictions, source);
+                buffer->moves[2 * num_moves] = (uint32_t)(row - *last_moved_row);
+                buffer->moves[2 * num_moves + 1] = (uint32_t)(*source_end - 1 - source);
+                ++num_moves;
+                *last_moved_row = row;
+                *source_end = source;
+                found = true;
+                break;
+            }
+        }
+
+        *num_failed = found ? 0 : *num_failed + 1;
+        if(*num_failed >= REWIND_MAX_FAILED_MOVES) {
+            break;
+        }
+    }
+    return num_moves;
+}
+
+static bool is_row_predicted_from(const rewind_table_t* const table, const size_t row, const rewind_table_t* const base, const prediction_t* const predictions, const size_t base_row)
+{
+    for(size_t c = 0; c < table->num_columns; ++c) {
+        const uint32_t added = predictions[c].added == NO_COLUMN ? 0 : (uint32_t)base->columns[predictions[c].added][base_row];
+        if((uint32_t)table->columns[c][row] != (uint32_t)base->columns[predictions[c].base][base_row] + added) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Values are encoded as runs of those that differ from their prediction: the number skipped since the last run, the
+// run's length, then each one's difference, zigzagged so that small negative differences stay small. A run carries on
+// through a single predicted value, which costs less than starting another. Differences wrap round as unsigned, as the
+// fixed-point arithmetic they come from does.
+static void encode_runs(rewind_buffer_t* const buffer, const int32_t* const values, const int32_t* const predicted, const size_t count)
+{
+    // At worst every other value is a run of its own
+    reserve_encoded(buffer, count * REWIND_MAX_VARINT_SIZE * 2 + 2 * REWIND_MAX_VARINT_SIZE);
+    uint8_t* out = buffer->encoded + buffer->encoded_size;
+
+    size_t i = 0;
+    while(i < count) {
+        const size_t run_start = i;
+        i = find_first_mismatch(values, predicted, i, count);
+        if(i == count) {
+            // Only predicted values are left, which the decoder fills in without being told
+            out = put_varint(out, (uint32_t)(i - run_start));
+            out = put_varint(out, 0);
+            break;
+        }
+
+        size_t run_end = i + 1;
+        while(run_end < count && (values[run_end] != predicted[run_end] || (run_end + 1 < count && values[run_end + 1] != predicted[run_end + 1]))) {
+            ++run_end;
+        }
+
+        out = put_varint(out, (uint32_t)(i - run_start));
+        out = put_varint(out, (uint32_t)(run_end - i));
+        for(; i < run_end; ++i) {
+            const uint32_t difference = (uint32_t)values[i] - (uint32_t)predicted[i];
+            out = put_varint(out, (difference << 1) ^ (0U - (difference >> 31)));
+        }
+    }
+
+    buffer->encoded_size = (size_t)(out - buffer->encoded);
+}
+
+// Returns the index of the first value from start onwards that differs from its prediction, or count if there is none
+static size_t find_first_mismatch(const int32_t* const values, const int32_t* const predicted, const size_t start, const size_t count)
+{
+    size_t i = start;
+#if defined(__AVX2__)
+    for(; i + 8 <= count; i += 8) {
+        const __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)&values[i]), _mm256_loadu_si256((const __m256i*)&predicted[i]));
+        const int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(equal)) & 0xFF;
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#elif defined(__SSE2__)
+    for(; i + 4 <= count; i += 4) {
+        const __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&values[i]), _mm_loadu_si128((const __m128i*)&predicted[i]));
+        const int mask = ~_mm_movemask_ps(_mm_castsi128_ps(equal)) & 0xF;
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    for(; i < count; ++i) {
+        if(values[i] != predicted[i]) {
+            return i;
+        }
+    }
+    return count;
+}
+
+// Decodes a frame encoded by encode_frame(), against the same frame before, or none for a keyframe
+static const uint8_t* decode_frame(const uint8_t* data, const rewind_frame_t* const base, rewind_frame_t* const frame)
+{
+    memcpy(frame->header, base != NULL ? base->header : empty_header, sizeof(frame->header));
+    data = decode_runs(data, frame->header, REWIND_HEADER_SIZE);
+
+    for(int t = 0; t < REWIND_TABLES_TOTAL; ++t) {
+        rewind_table_t* table = &frame->tables[t];
+        const rewind_table_t* base_table = base != NULL ? &base->tables[t] : NULL;
+        const prediction_t* predictions = table_predictions[t];
+
+        uint32_t count;
+        data = get_varint(data, &count);
+        reserve_table(table, count);
+        table->count = count;
+
+        size_t moved_row = 0;
+        size_t source_end = base_table != NULL ? base_table->count : 0;
+        for(size_t start = 0; start < count; start += REWIND_BLOCK_SIZE) {
+            const size_t num_rows = count - start < REWIND_BLOCK_SIZE ? count - start : REWIND_BLOCK_SIZE;
+            int32_t* values[REWIND_MAX_COLUMNS];
+            for(size_t c = 0; c < table->num_columns; ++c) {
+                values[c] = table->columns[c] + start;
+            }
+
+            if(base_table != NULL) {
+                predict_rows(values, table->num_columns, base_table, predictions, start, num_rows);
+
+                uint32_t num_moves;
+                data = get_varint(data, &num_moves);
+                for(uint32_t m = 0; m < num_moves; ++m) {
+                    uint32_t row_distance;
+                    uint32_t skipped;
+                    data = get_varint(data, &row_distance);
+                    data = get_varint(data, &skipped);
+                    moved_row += row_distance;
+                    source_end -= skipped + 1;
+                    predict_row(values, table->num_columns, moved_row - start, base_table, predictions, source_end);
+                }
+            }
+
+            uint32_t changed;
+            data = get_varint(data, &changed);
+            for(size_t c = 0; c < table->num_columns; ++c) {
+                if(base_table != NULL) {
+                    if(changed & (1U << c)) {
+                        data = decode_runs(data, values[c], num_rows);
+                    }
+                    continue;
+                }
+
+                // Each keyframe value predicted from the one before is that one plus its own difference
+                memset(values[c], 0, num_rows * sizeof(int32_t));
+                if(changed & (1U << c)) {
+                    data = decode_runs(data, values[c], num_rows);
+                }
+                uint32_t previous = start > 0 ? (uint32_t)values[c][-1] : 0;
+                for(size_t i = 0; i < num_rows; ++i) {
+                    previous += (uint32_t)values[c][i];
+                    values[c][i] = (int32_t)previous;
+                }
+            }
+        }
+    }
+    return data;
+}
+
+// Adds the differences encoded by encode_runs() to the values, which must already hold their predictions
+static const uint8_t* decode_runs(const uint8_t* data, int32_t* const values, const size_t count)
+{
+    size_t i = 0;
+    while(i < count) {
+        uint32_t skipped;
+        uint32_t length;
+        data = get_varint(data, &skipped);
+        data = get_varint(data, &length);
+        i += skipped;
+        for(const size_t run_end = i + length; i < run_end; ++i) {
+            uint32_t zigzag;
+            data = get_varint(data, &zigzag);
+            values[i] = (int32_t)((uint32_t)values[i] + ((zigzag >> 1) ^ (0U - (zigzag & 1))));
+        }
+    }
+    return data;
+}
+
+// Little-endian base 128, seven bits per byte, with the top bit set on every byte but the last
+static uint8_t* put_varint(uint8_t* out, uint32_t value)
+{
+    while(value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+static const uint8_t* get_varint(const uint8_t* data, uint32_t* const value)
+{
+    uint32_t result = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+        byte = *data++;
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while(byte & 0x80);
+    *value = result;
+    return data;
+}
+
+// Steps are laid out one after another from the oldest, wrapping round to the start of the data when the next does not
+// fit before its end. The space free for the next step runs from the end of the newest to the start of the oldest.
+static bool find_space(const rewind_buffer_t* const buffer, const size_t size, size_t* const offset)
+{
+    if(buffer->num_entries == 0) {
+        *offset = 0;
+        return size <= buffer->data_capacity;
+    }
+
+    const size_t start = entry_at(buffer, 0)->offset;
+    const size_t end = buffer->data_end;
+    if(start < end) {
+        if(end + size <= buffer->data_capacity) {
+            *offset = end;
+            return true;
+        }
+        if(size <= start) {
+            *offset = 0;
+            return true;
+        }
+        return false;
+    }
+
+    if(end + size <= start) {
+        *offset = end;
+        return true;
+    }
+    return false;
+}
+
+// Steps after the oldest keyframe cannot be decoded without it, so they go with it, up to the next keyframe
+static void evict_oldest_keyframe(rewind_buffer_t* const buffer)
+{
+    do {
+        buffer->retained_size -= entry_at(buffer, 0)->size;
+        buffer->first_entry = (buffer->first_entry + 1) % buffer->entries_capacity;
+        --buffer->num_entries;
+    } while(buffer->num_entries > 0 && !entry_at(buffer, 0)->is_keyframe);
+}
+
+static const rewind_entry_t* entry_at(const rewind_buffer_t* const buffer, const size_t idx)
+{
+    return &buffer->entries[(buffer->first_entry + idx) % buffer->entries_capacity];
+}
@@ -0,0 +1,146 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simulation.h"
+
+// ============================================================================
+// Rewind buffer
+// ============================================================================
+
+// Every value that describes a simulation instance apart from its entities,
+// beyond what it was configured with
+enum {
+    REWIND_HEADER_STEP,
+    REWIND_HEADER_GAME_OVER,
+    REWIND_HEADER_INPUT,
+    REWIND_HEADER_SPACESHIP_X,
+    REWIND_HEADER_SPACESHIP_Y,
+    REWIND_HEADER_SPACESHIP_VELOCITY_X,
+    REWIND_HEADER_SPACESHIP_VELOCITY_Y,
+    REWIND_HEADER_SPACESHIP_QUAD_X,
+    REWIND_HEADER_SPACESHIP_QUAD_Y,
+    REWIND_HEADER_SPACESHIP_FIRING,
+    REWIND_HEADER_SPACESHIP_SHOT_TIMER,
+    REWIND_HEADER_ENEMY_SPAWN_TIMER,
+    REWIND_HEADER_ENEMIES_SPAWNED,
+    REWIND_HEADER_BACKGROUND_Y,
+    REWIND_HEADER_BACKGROUND_COUNTER,
+    // Each stream's 256 bits of state, as eight 32-bit words
+    REWIND_HEADER_SPAWN_RNG,
+    REWIND_HEADER_SCENARIO_RNG = REWIND_HEADER_SPAWN_RNG + 8,
+    REWIND_HEADER_SIZE = REWIND_HEADER_SCENARIO_RNG + 8
+};
+
+// The pools each frame holds a table for, with one column per field
+enum {
+    REWIND_TABLE_PROJECTILES,
+    REWIND_TABLE_ENEMIES,
+    REWIND_TABLE_EXPLOSIONS,
+    REWIND_TABLE_BULLETS,
+    REWIND_TABLES_TOTAL
+};
+
+#define REWIND_MAX_COLUMNS 10
+
+// Tables are encoded a block of rows at a time, so that each block's values, predictions and the rows they are
+// predicted from stay in cache across every pass over them
+#define REWIND_BLOCK_SIZE 256
+
+typedef struct {
+    size_t num_columns;
+    size_t count;
+    size_t capacity;
+    int32_t* columns[REWIND_MAX_COLUMNS];
+    void* storage;
+} rewind_table_t;
+
+// A simulation instance's state, flattened into 32-bit values, so that every
+// field of every live entity can be compared with the frame before
+typedef struct {
+    int32_t header[REWIND_HEADER_SIZE];
+    rewind_table_t tables[REWIND_TABLES_TOTAL];
+} rewind_frame_t;
+
+// Where a recorded step's encoding lives in the ring
+typedef struct {
+    uint32_t step;
+    bool is_keyframe;
+    size_t offset;
+    size_t size;
+} rewind_entry_t;
+
+// A ring of the most recent simulation steps, kept within a fixed memory
+// budget. A keyframe holds a step's whole state, and every step after it until
+// the next holds only what differs from what the step before would predict:
+// entities that have only moved by their velocity, or not changed at all, cost
+// nothing. Each field is stored as the difference from its prediction, in as
+// few bytes as it needs.
+//
+// The oldest keyframe and the steps that depend on it are dropped together
+// once a new step does not fit, so seeking to any retained step decodes at most
+// a keyframe interval's worth of steps.
+typedef struct {
+    uint32_t keyframe_interval;
+
+    // Encoded steps, oldest first, wrapping round the end of the data
+    uint8_t* data;
+    size_t data_capacity;
+    size_t data_end;
+    rewind_entry_t* entries;
+    size_t entries_capacity;
+    size_t first_entry;
+    size_t num_entries;
+
+    // The last step recorded, which the next is encoded against, and the step that is being encoded
+    rewind_frame_t last;
+    rewind_frame_t current;
+    uint32_t last_keyframe_step;
+    // The last step recorded is no longer the one the next follows on from
+    bool needs_keyframe;
+    uint8_t* encoded;
+    size_t encoded_size;
+    size_t encoded_capacity;
+
+    // What the block of rows being encoded is predicted to hold, which of them differ from that, and which moved
+    int32_t predicted[REWIND_MAX_COLUMNS][REWIND_BLOCK_SIZE];
+    uint8_t mismatched[REWIND_BLOCK_SIZE];
+    uint32_t moves[2 * REWIND_BLOCK_SIZE];
+
+    // Frames that steps are decoded into while seeking
+    rewind_frame_t seek_frames[2];
+
+    size_t retained_size;
+    uint64_t num_recorded;
+    uint64_t num_keyframes;
+    uint64_t total_recorded_size;
+    // Steps whose keyframe would not fit in the budget at all
+    uint64_t num_dropped;
+} rewind_buffer_t;
+
+// Creates a ring that holds its encoded steps and their index within budget bytes, with a keyframe at least every
+// keyframe_interval steps. The frames that steps are encoded from and decoded into grow with the number of live
+// entities, outside the budget.
+void rewind_init(rewind_buffer_t* buffer, size_t budget, uint32_t keyframe_interval);
+void rewind_destroy(rewind_buffer_t* buffer);
+
+// Records the instance's state after its latest step. A step that does not directly follow the last one recorded
+// starts a new keyframe.
+void rewind_record(rewind_buffer_t* buffer, const simulation_t* sim);
+
+// Forgets every step after the given one, so that the game can carry on from it once it has been sought to
+void rewind_truncate(rewind_buffer_t* buffer, uint32_t step);
+
+// Returns whether any steps are retained, setting the oldest and newest if so
+bool rewind_range(const rewind_buffer_t* buffer, uint32_t* oldest, uint32_t* newest);
+// Restores the state recorded after the given step into an instance created with the same configuration as the one
+// recorded, returning false, and leaving it untouched, if the step is not retained
+bool rewind_seek(rewind_buffer_t* buffer, uint32_t step, simulation_t* sim);
+
+// Returns the number of bytes the retained steps are encoded in
+size_t rewind_retained_size(const rewind_buffer_t* buffer);
+
+#endif
@@ -0,0 +1,86 @@
+#include "rng.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Equivalent to 2^128 calls to rng_next()
+static const uint64_t jump_polynomial[4] = {
+    0x180EC6D33CFD0ABAULL,
+    0xD5A61266F0C9392CULL,
+    0xA9582618E03FC9AAULL,
+    0x39ABDC4529B1661CULL
+};
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static uint64_t splitmix64(uint64_t* state);
+static void jump(rng_t* rng);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void rng_init(rng_t* const rng, const uint64_t seed)
+{
+    // SplitMix64 never gives four zeroes in a row, so the state is never all zero
+    uint64_t state = seed;
+    for(int i = 0; i < 4; ++i) {
+        rng->s[i] = splitmix64(&state);
+    }
+}
+
+rng_t rng_split(rng_t* const rng)
+{
+    const rng_t stream = *rng;
+    jump(rng);
+    return stream;
+}
+
+void rng_fill_bounded(rng_t* const rng, uint32_t* const out, const size_t count, const uint32_t bound)
+{
+    size_t i = 0;
+    while(i < count) {
+        const uint64_t bits = rng_next(rng);
+        // The high half is the better half of xoshiro256**'s output, so it is used first, and on its own for the last
+        // number of an odd count
+        const uint64_t high = rng_scale_bounded((uint32_t)(bits >> 32), bound);
+        if(high != UINT64_MAX) {
+            out[i++] = (uint32_t)high;
+        }
+        if(i < count) {
+            const uint64_t low = rng_scale_bounded((uint32_t)bits, bound);
+            if(low != UINT64_MAX) {
+                out[i++] = (uint32_t)low;
+            }
+        }
+    }
+}
+
+static uint64_t splitmix64(uint64_t* const state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void jump(rng_t* const rng)
+{
+    uint64_t s[4] = { 0, 0, 0, 0 };
+    for(int i = 0; i < 4; ++i) {
+        for(int b = 0; b < 64; ++b) {
+            if(jump_polynomial[i] & (1ULL << b)) {
+                for(int j = 0; j < 4; ++j) {
+                    s[j] ^= rng->s[j];
+                }
+            }
+            rng_next(rng);
+        }
+    }
+    for(int j = 0; j < 4; ++j) {
+        rng->s[j] = s[j];
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Pseudo-random number streams
+// ============================================================================
+
+// A xoshiro256** generator. Each stream's whole state lives in its own rng_t,
+// so streams can be owned by separate subsystems or threads without sharing
+// anything, and the numbers each one gives depend only on its seed and how many
+// it has given before.
+//
+// Independent streams are made by splitting them off a stream seeded once, each
+// split taking a block of 2^128 numbers that no other stream will reach, so a
+// whole session can be reproduced from a single seed.
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+// Seeds the stream by expanding the seed with SplitMix64, as xoshiro's authors recommend
+void rng_init(rng_t* rng, uint64_t seed);
+// Returns a stream starting at this one's current state, then jumps this one 2^128 numbers ahead, so that the two never
+// overlap
+rng_t rng_split(rng_t* rng);
+
+// Fills out with numbers from 0 up to but excluding bound, which must be positive. Each 64-bit output gives two numbers,
+// so this is around twice as fast as drawing them one at a time.
+void rng_fill_bounded(rng_t* rng, uint32_t* out, size_t count, uint32_t bound);
+
+static inline uint64_t rng_next(rng_t* const rng)
+{
+    uint64_t* s = rng->s;
+    const uint64_t x = s[1] * 5;
+    const uint64_t result = ((x << 7) | (x >> 57)) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+
+// Maps 32 random bits onto [0, bound) with Lemire's multiply-shift, returning UINT64_MAX if they land in the biased
+// region and must be drawn again. Rejection is only possible when the low half of the product is below bound.
+static inline uint64_t rng_scale_bounded(const uint32_t bits, const uint32_t bound)
+{
+    const uint64_t m = (uint64_t)bits * bound;
+    if((uint32_t)m < bound && (uint32_t)m < (uint32_t)(-bound) % bound) {
+        return UINT64_MAX;
+    }
+    return m >> 32;
+}
+
+// Returns a number from 0 up to but excluding bound, which must be positive, without any modulo bias
+static inline uint32_t rng_bounded(rng_t* const rng, const uint32_t bound)
+{
+    uint64_t value;
+    do {
+        value = rng_scale_bounded((uint32_t)(rng_next(rng) >> 32), bound);
+    } while(value == UINT64_MAX);
+    return (uint32_t)value;
+}
+
+// Returns a number from min to max inclusive, which must not be less than min
+static inline int32_t rng_range(rng_t* const rng, const int32_t min, const int32_t max)
+{
+    const uint32_t span = (uint32_t)max - (uint32_t)min + 1;
+    // The whole 32-bit range wraps the span round to zero
+    const uint32_t offset = span == 0 ? (uint32_t)(rng_next(rng) >> 32) : rng_bounded(rng, span);
+    return (int32_t)((uint32_t)min + offset);
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "sample_stats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define SAMPLE_STATS_INITIAL_CAPACITY 256
+#define SAMPLE_STATS_RANDOM_SEED 0x9E3779B97F4A7C15ULL
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void grow(sample_stats_t* stats);
+static uint64_t next_random(sample_stats_t* stats);
+static int compare_values(const void* a, const void* b);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void sample_stats_init(sample_stats_t* const stats, const size_t max_count)
+{
+    stats->values = NULL;
+    stats->count = 0;
+    stats->capacity = 0;
+    stats->max_count = max_count > 0 ? max_count : 1;
+    stats->sorted = true;
+    stats->num_samples = 0;
+    stats->mean = 0.0;
+    stats->sum_squared_deviations = 0.0;
+    stats->max = 0.0;
+    stats->random_state = SAMPLE_STATS_RANDOM_SEED;
+}
+
+void sample_stats_destroy(sample_stats_t* const stats)
+{
+    free(stats->values);
+    stats->values = NULL;
+    stats->count = 0;
+    stats->capacity = 0;
+}
+
+void sample_stats_add(sample_stats_t* const stats, const double value)
+{
+    ++stats->num_samples;
+    const double deviation = value - stats->mean;
+    stats->mean += deviation / (double)stats->num_samples;
+    stats->sum_squared_deviations += deviation * (value - stats->mean);
+    stats->max = stats->num_samples == 1 || value > stats->max ? value : stats->max;
+
+    if(stats->count < stats->max_count) {
+        if(stats->count == stats->capacity) {
+            grow(stats);
+        }
+        stats->values[stats->count++] = value;
+        stats->sorted = false;
+        return;
+    }
+
+    // Reservoir sampling: the nth sample replaces a kept one with probability max_count / n, which leaves every sample
+    // added so far equally likely to be kept
+    const uint64_t i = next_random(stats) % stats->num_samples;
+    if(i < stats->max_count) {
+        stats->values[i] = value;
+        stats->sorted = false;
+    }
+}
+
+double sample_stats_percentile(sample_stats_t* const stats, const double percentile)
+{
+    if(stats->count == 0) {
+        return 0.0;
+    }
+    if(!stats->sorted) {
+        qsort(stats->values, stats->count, sizeof(double), compare_values);
+        stats->sorted = true;
+    }
+
+    // The smallest sample that at least the given percentage of samples are no greater than
+    const double rank = ceil(percentile / 100.0 * (double)stats->count);
+    const size_t i = rank > 1.0 ? (size_t)rank - 1 : 0;
+    return stats->values[i < stats->count ? i : stats->count - 1];
+}
+
+double sample_stats_mean(const sample_stats_t* const stats)
+{
+    return stats->mean;
+}
+
+double sample_stats_stddev(const sample_stats_t* const stats)
+{
+    return stats->num_samples > 0 ? sqrt(stats->sum_squared_deviations / (double)stats->num_samples) : 0.0;
+}
+
+double sample_stats_max(const sample_stats_t* const stats)
+{
+    return stats->max;
+}
+
+static void grow(sample_stats_t* const stats)
+{
+    size_t capacity = stats->capacity > 0 ? stats->capacity * 2 : SAMPLE_STATS_INITIAL_CAPACITY;
+    capacity = capacity < stats->max_count ? capacity : stats->max_count;
+    double* values = realloc(stats->values, capacity * sizeof(double));
+    if(values == NULL) {
+        fprintf(stderr, "Failed to grow sample statistics to capacity: %zu\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+    stats->values = values;
+    stats->capacity = capacity;
+}
+
+static uint64_t next_random(sample_stats_t* const stats)
+{
+    // xorshift64*
+    uint64_t x = stats->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    stats->random_state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static int compare_values(const void* const a, const void* const b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
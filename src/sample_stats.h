@@ -0,0 +1,51 @@
+#ifndef SAMPLE_STATS_H
+#define SAMPLE_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Sample statistics
+// ============================================================================
+
+// A measurement taken over a session, such as a latency or a frame time. The
+// mean, standard deviation and maximum are exact. Percentiles are exact until
+// max_count samples have been added, after which a uniform random subset of
+// max_count samples is kept, so that memory stays bounded however long the
+// session runs. Kept samples are sorted lazily, the first time a percentile is
+// asked for after adding more.
+typedef struct {
+    double* values;
+    size_t count;
+    size_t capacity;
+    size_t max_count;
+    bool sorted;
+
+    // Every sample ever added, summarised with Welford's method
+    uint64_t num_samples;
+    double mean;
+    double sum_squared_deviations;
+    double max;
+
+    // Picks which samples replace kept ones once max_count is reached
+    uint64_t random_state;
+} sample_stats_t;
+
+// Starts an empty set of samples, keeping at most max_count of them for percentiles
+void sample_stats_init(sample_stats_t* stats, size_t max_count);
+void sample_stats_destroy(sample_stats_t* stats);
+
+// Adds a sample, growing the storage until it holds max_count of them
+void sample_stats_add(sample_stats_t* stats, double value);
+
+// Returns the sample at the given percentile from 0 to 100, using the nearest rank, or 0 if there are no samples
+double sample_stats_percentile(sample_stats_t* stats, double percentile);
+// Returns the mean of every sample, or 0 if there are none
+double sample_stats_mean(const sample_stats_t* stats);
+// Returns the standard deviation of every sample from their mean, or 0 if there are none
+double sample_stats_stddev(const sample_stats_t* stats);
+// Returns the largest sample, or 0 if there are none
+double sample_stats_max(const sample_stats_t* stats);
+
+#endif
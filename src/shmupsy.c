@@ -1,820 +1,1568 @@
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include <SDL.h>
+#include <SDL_cpuinfo.h>
 #include <SDL_error.h>
 #include <SDL_events.h>
-#include <SDL_image.h>
 #include <SDL_keyboard.h>
 #include <SDL_keycode.h>
 #include <SDL_rect.h>
 #include <SDL_render.h>
 #include <SDL_surface.h>
+#include <SDL_thread.h>
 #include <SDL_timer.h>
 #include <SDL_video.h>
 
+#include "animation.h"
+#include "asset_pack.h"
+#include "bullet_pool.h"
+#include "cpu_renderer.h"
+#include "entity_pool.h"
+#include "frame_capture.h"
+#include "frame_pacer.h"
+#include "fixed.h"
+#include "input_queue.h"
+#include "render_snapshot.h"
+#include "replay.h"
+#include "rewind.h"
+#include "sample_stats.h"
+#include "simulation.h"
+#include "sprite_batch.h"
+#include "trace.h"
+#include "worker_pool.h"
+
 // ============================================================================
 // Global definitions
 // ============================================================================
 
-#define SCREEN_WIDTH 600
-#define SCREEN_HEIGHT 800
-
-#define SPACESHIP_VELOCITY_PPS 320
-#define SPACESHIP_FIRERATE_PPS 3
-
-#define MAX_NUM_PROJECTILES 1024
-#define PROJECTILE_VELOCITY_PPS 640
-
-#define MAX_NUM_ENEMIES 1024
-#define ENEMY_VELOCITY_PPS 160
-#define ENEMY_SPAWN_RATE_EPS 1
-
-#define MAX_NUM_EXPLOSIONS 1024
-
-const char* spaceship_img = "../data/ship.png";
-const char* projectile_img = "../data/laser-bolts.png";
-const char* small_enemy_img = "../data/enemy-small.png";
-const char* explosion_img = "../data/explosion.png";
-const char* background_img = "../data/desert-background-looped.png";
-
-enum {
-    SPACESHIP_STATIONARY_1,
-    SPACESHIP_STATIONARY_2,
-    SPACESHIP_BANK_LEFT_1,
-    SPACESHIP_BANK_LEFT_2,
-    SPACESHIP_BANK_HARD_LEFT_1,
-    SPACESHIP_BANK_HARD_LEFT_2,
-    SPACESHIP_BANK_RIGHT_1,
-    SPACESHIP_BANK_RIGHT_2,
-    SPACESHIP_BANK_HARD_RIGHT_1,
-    SPACESHIP_BANK_HARD_RIGHT_2,
-    SPACESHIP_SPRITES_TOTAL
+#define SCREEN_WIDTH SIMULATION_SCREEN_WIDTH
+#define SCREEN_HEIGHT SIMULATION_SCREEN_HEIGHT
+
+// The simulation advances in fixed steps, independent of the display's refresh rate. If rendering falls
+// behind, at most SIMULATION_MAX_CATCH_UP_STEPS are run per rendered frame and the remaining time is dropped.
+#define SIMULATION_STEP_RATE_HZ 60
+#define SIMULATION_TIME_STEP_S (1.0F / SIMULATION_STEP_RATE_HZ)
+#define SIMULATION_MAX_CATCH_UP_STEPS 5
+
+// The number of input events that can be waiting for the simulation thread, beyond which they are dropped
+#define INPUT_QUEUE_CAPACITY 256
+
+// The number of rendered frames that can be waiting to be written by the capture thread, beyond which they are dropped
+#define FRAME_CAPTURE_RING_SIZE 8
+
+// The number of input events whose poll times are kept until a frame showing their effect is presented. Events that
+// take longer than this many later ones to be presented go unmeasured.
+#define INPUT_LATENCY_HISTORY 1024
+// The number of latency and frame time samples kept for percentiles, beyond which a random subset is kept
+#define MAX_TIMING_SAMPLES 65536
+
+// In low-latency mode, input is polled this long before the next refresh is due, on top of the time the frame takes
+#define LOW_LATENCY_MARGIN_S 0.002
+// The refresh rate assumed when the display does not report one
+#define DEFAULT_REFRESH_RATE_HZ 60
+
+// The frame rate that fixed pacing runs at, unless told otherwise
+#define DEFAULT_TARGET_FPS 60
+#define MAX_TARGET_FPS 1000
+
+// Snapshots and sprite batches start with room for the background, the spaceship and 64 of each other kind of entity,
+// and grow as far as they need to
+#define RENDER_INITIAL_CAPACITY (3 * 64 + 2)
+
+// Per-entity update passes are split across worker threads once a pool holds at least this many entities
+#define PARALLEL_UPDATE_DEFAULT_THRESHOLD 4096
+#define MAX_NUM_WORKER_THREADS 8
+
+#define BENCHMARK_DEFAULT_FRAMES 600
+#define BENCHMARK_DEFAULT_SEED 1
+// The number of each kind of entity that the stress scenarios keep topped up
+#define BENCHMARK_STRESS_NUM_ENTITIES 1024
+// The bullet-hell scenario keeps this many enemies firing, and tops the screen up to this many bullets
+#define BENCHMARK_BULLET_HELL_NUM_EMITTERS 64
+#define BENCHMARK_BULLET_HELL_NUM_BULLETS 50000
+
+// When tracing is compiled in, the trace is written on exit, or whenever this key is pressed
+#define TRACE_HOTKEY SDLK_F9
+
+// Every step of an interactive session, or of a headless run verifying rewinding, is recorded into a rewind buffer of
+// this size unless told otherwise, with a keyframe at least once a second at the default step rate
+#define REWIND_DEFAULT_BUDGET_MIB 16
+#define REWIND_KEYFRAME_INTERVAL 60
+// This key pauses the game to look back through the recorded steps, a step at a time with the comma and full stop keys
+// or a keyframe interval at a time with page up and down, and unpauses it from whichever step is shown
+#define REWIND_HOTKEY SDLK_F5
+
+const char* trace_filename = "shmupsy-trace.json";
+
+typedef enum {
+    SCENARIO_GAMEPLAY,
+    SCENARIO_SWARM,
+    SCENARIO_BARRAGE,
+    SCENARIO_SATURATED,
+    SCENARIO_BULLET_HELL,
+    SCENARIOS_TOTAL
+} scenario_t;
+
+const char* scenario_names[SCENARIOS_TOTAL] = {
+    "gameplay",
+    "swarm",
+    "barrage",
+    "saturated",
+    "bullethell"
 };
 
-enum {
-    PROJECTILE_1,
-    PROJECTILE_2,
-    PROJECTILE_SPRITES_TOTAL
-};
+typedef enum {
+    REPLAY_MODE_OFF,
+    REPLAY_MODE_RECORD,
+    REPLAY_MODE_PLAYBACK
+} replay_mode_t;
 
+typedef struct {
+    collision_mode_t collision_mode;
+    const char* record_filename;
+    const char* replay_filename;
+    const char* capture_directory;
+    frame_capture_format_t capture_format;
+    size_t num_threads;
+    size_t parallel_threshold;
+    bool separate_passes;
+    bool headless;
+    bool headless_render;
+    bool cpu_render;
+    bool verify_cpu_render;
+    bool low_latency;
+    frame_pacing_mode_t pacing_mode;
+    uint32_t target_fps;
+    scenario_t scenario;
+    uint32_t num_frames;
+    float time_delta_s;
+    uint32_t seed;
+    // The number of live entities each stress scenario tops its pools up to every frame
+    size_t min_enemies;
+    size_t min_projectiles;
+    size_t min_explosions;
+    size_t min_bullets;
+    // The memory the rewind buffer may use, or zero for none
+    size_t rewind_budget;
+    bool verify_rewind;
+} options_t;
+
+// Where a frame drawn by the CPU renderer first differed from SDL's, and the pixels each drew there
+typedef struct {
+    uint32_t frame;
+    int x;
+    int y;
+    uint32_t cpu_pixel;
+    uint32_t sdl_pixel;
+} render_mismatch_t;
+
+// The simulation's own phases come first, in the same order
 enum {
-    SMALL_ENEMY_1,
-    SMALL_ENEMY_2,
-    SMALL_ENEMY_SPRITES_TOTAL
+    PHASE_REWIND = SIMULATION_PHASES_TOTAL,
+    PHASE_RENDER,
+    PHASE_CAPTURE,
+    PHASE_PRESENT,
+    PHASES_TOTAL
 };
 
-enum {
-    EXPLOSION_1,
-    EXPLOSION_2,
-    EXPLOSION_3,
-    EXPLOSION_4,
-    EXPLOSION_5,
-    EXPLOSION_TOTAL
+const char* phase_names[PHASES_TOTAL] = {
+    "expiry",
+    "background",
+    "positions",
+    "spawning",
+    "collisions",
+    "rewind",
+    "render",
+    "capture",
+    "present"
 };
 
-SDL_Rect spaceship_sprite_quads[SPACESHIP_SPRITES_TOTAL];
-SDL_Rect projectile_sprite_quads[PROJECTILE_SPRITES_TOTAL];
-SDL_Rect small_enemy_sprite_quads[SMALL_ENEMY_SPRITES_TOTAL];
-SDL_Rect explosion_sprite_quads[EXPLOSION_TOTAL];
-SDL_Rect background_sprite_quad;
-
-typedef struct {
-    int32_t x;
-    int32_t y;
-} vector_t;
-
-#define ENTITY_STRUCT_BODY                           \
-{                                                    \
-    vector_t position;                               \
-    vector_t velocity;                               \
-    SDL_Rect* sprite_quad;                           \
-    int32_t sprite_scaling;                          \
-    SDL_Rect render_quad;                            \
-    int32_t num_animation_frames;                    \
-    int32_t animation_idx;                           \
-    int32_t num_rendered_frames_per_animation_frame; \
-    int32_t rendered_frame_idx;                      \
-}
-
-typedef struct {
-    struct ENTITY_STRUCT_BODY;
-    bool is_firing;
-    float time_till_next_shot_s;
-} spaceship_t;
-
-typedef struct ENTITY_STRUCT_BODY projectile_t;
-typedef struct ENTITY_STRUCT_BODY enemy_t;
-typedef struct ENTITY_STRUCT_BODY explosion_t;
+// Performance counter ticks spent in each phase of the frame, accumulated since start up
+uint64_t phase_ticks[PHASES_TOTAL];
 
 typedef struct {
     SDL_Window* window;
+    SDL_Surface* render_target;
     SDL_Renderer* renderer;
-    bool game_over;
-
-    SDL_Texture* background_texture;
-
-    SDL_Texture* spaceship_texture;
-    spaceship_t spaceship;
-
-    SDL_Texture* projectile_texture;
-    projectile_t projectiles[MAX_NUM_PROJECTILES];
-    size_t projectile_count;
-
-    SDL_Texture* small_enemy_texture;
-    enemy_t enemies[MAX_NUM_ENEMIES];
-    size_t enemy_count;
-    float time_till_next_enemy_spawn_s;
-
-    SDL_Texture* explosion_texture;
-    explosion_t explosions[MAX_NUM_EXPLOSIONS];
-    size_t explosions_count;
+    sprite_batch_t sprite_batch;
+
+    // Sprites are drawn by the CPU renderer instead of SDL's, into the render target. When there is a window, the render
+    // target is then uploaded to a streaming texture and copied to it. It has its own worker pool, since the simulation
+    // thread uses the other.
+    bool cpu_render;
+    cpu_renderer_t cpu_renderer;
+    worker_pool_t render_workers;
+    SDL_Texture* framebuffer_texture;
+    // When verifying the CPU renderer, SDL's software renderer draws every frame again into this surface, to compare
+    SDL_Surface* reference_target;
+
+    // Rendered frames are copied into the capture ring, and written out by its own thread
+    bool capturing;
+    frame_capture_t capture;
+
+    // The game itself, whose per-entity update passes are split across the workers, and the buttons the player is
+    // holding down
+    simulation_t sim;
+    worker_pool_t workers;
+    simulation_input_t input;
+
+    // Every step the game has taken, as far back as the buffer's budget allows. While paused, the step being shown is
+    // restored into a separate instance, so that the game can carry on from where it was paused.
+    bool rewind_enabled;
+    rewind_buffer_t rewind;
+    bool rewinding;
+    uint32_t rewind_step;
+    simulation_t rewind_sim;
+
+    // The session's input, either being recorded or played back in place of the player's
+    replay_mode_t replay_mode;
+    replay_t replay;
+
+    asset_pack_t assets;
+    simulation_sprites_t sprites;
+    SDL_Texture* atlas_texture;
+
+    // Shared between the simulation thread and the main thread, which polls events and renders
+    input_queue_t input_queue;
+    render_snapshot_buffer_t snapshots;
+
+    // Real time not yet consumed by simulation steps, and when it was last measured
+    uint64_t accumulated_ticks;
+    uint64_t last_time;
+
+    // Input latency is measured from when each event is polled until the first frame that was simulated after it is
+    // applied has been presented. Events are numbered in the order they are polled, which is also the order they are
+    // applied, and each snapshot carries how many had been applied by its step.
+    uint32_t num_inputs_polled;
+    uint32_t num_inputs_applied;
+    uint32_t num_inputs_presented;
+    uint64_t input_poll_times[INPUT_LATENCY_HISTORY];
+    sample_stats_t input_latency_ms;
+
+    // Schedules the main thread's presents, and measures the time between them
+    frame_pacer_t pacer;
 } game_state_t;
 
 game_state_t state;
 
+atomic_bool simulation_running;
+
 // ============================================================================
 // Forward declarations
 // ============================================================================
 
-void init();
+void parse_options(int argc, char* argv[], options_t* options);
+void init(const options_t* options);
 void destroy();
-void update_state();
 void handle_event(const SDL_Event* event);
-void render();
+void apply_input_event(const SDL_Event* event);
+bool apply_rewind_event(const SDL_Event* event);
+void step_simulation();
+bool is_replay_finished();
+void finish_replay(const options_t* options);
+int run_simulation(void* data);
+void advance_simulation();
+bool poll_events();
+void poll_events_until(uint64_t deadline, bool* running);
+void sync_presented_frame();
+void record_input_latency(const render_snapshot_t* snapshot);
+void report_input_latency(const options_t* options);
+void report_frame_pacing(double cpu_s, double wall_s);
+void capture_snapshot(render_snapshot_t* snapshot, const simulation_t* sim, uint64_t step_time);
+void render(const render_snapshot_t* snapshot, float alpha);
+void render_cpu(const render_snapshot_t* snapshot, float alpha);
+void draw_sprites(const render_snapshot_t* snapshot, float alpha);
+void capture_frame(uint32_t frame, bool wait);
+void finish_capture();
+void end_phase(int phase, uint64_t* phase_start);
+
+bool run_benchmark(const options_t* options);
+simulation_input_t apply_scenario(const options_t* options, simulation_t* sim, uint32_t frame);
+uint64_t verify_cpu_frame(const render_snapshot_t* snapshot, uint32_t frame, render_mismatch_t* first);
+void verify_rewind(const options_t* options, const uint64_t* checksums);
+void report_benchmark(const options_t* options, uint32_t num_frames, uint64_t total_ticks, uint64_t min_frame_ticks, uint64_t max_frame_ticks, uint64_t total_entities);
+
+SDL_Texture* load_atlas_texture();
+void init_cpu_renderer(const options_t* options);
 
-SDL_Texture* load_texture(const char* filename);
+// ============================================================================
+// Function implementations
+// ============================================================================
 
-void update_background();
-void update_entity_positions(float time_delta_s);
-void spawn_entities(float time_delta_s);
-void update_entity_animations();
-void check_collisions();
+void parse_options(const int argc, char* argv[], options_t* const options)
+{
+    options->collision_mode = COLLISION_MODE_BROADPHASE;
+    options->record_filename = NULL;
+    options->replay_filename = NULL;
+    options->capture_directory = NULL;
+    options->capture_format = FRAME_CAPTURE_FORMAT_PNG;
+    options->num_threads = (size_t)SDL_GetCPUCount();
+    options->num_threads = options->num_threads < MAX_NUM_WORKER_THREADS ? options->num_threads : MAX_NUM_WORKER_THREADS;
+    options->parallel_threshold = PARALLEL_UPDATE_DEFAULT_THRESHOLD;
+    options->separate_passes = false;
+    options->headless = false;
+    options->headless_render = false;
+    options->cpu_render = false;
+    options->verify_cpu_render = false;
+    options->low_latency = false;
+    options->pacing_mode = FRAME_PACING_VSYNC;
+    options->target_fps = DEFAULT_TARGET_FPS;
+    options->scenario = SCENARIO_GAMEPLAY;
+    options->num_frames = BENCHMARK_DEFAULT_FRAMES;
+    options->time_delta_s = SIMULATION_TIME_STEP_S;
+    options->seed = (uint32_t)time(NULL);
+    options->min_enemies = SIZE_MAX;
+    options->min_projectiles = SIZE_MAX;
+    options->min_explosions = SIZE_MAX;
+    options->min_bullets = SIZE_MAX;
+    options->rewind_budget = (size_t)REWIND_DEFAULT_BUDGET_MIB << 20;
+    options->verify_rewind = false;
+
+    bool seed_given = false;
+    bool pacing_given = false;
+    bool rewind_budget_given = false;
+    bool valid = true;
+    for(int i = 1; i < argc && valid; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        char* end = NULL;
+
+        if(strcmp(arg, "--brute-force-collisions") == 0) {
+            options->collision_mode = COLLISION_MODE_BRUTE_FORCE;
+        }
+        else if(strcmp(arg, "--threads") == 0 && value != NULL) {
+            options->num_threads = strtoul(value, &end, 10);
+            valid = *end == '\0' && options->num_threads > 0 && options->num_threads <= MAX_NUM_WORKER_THREADS;
+            ++i;
+        }
+        else if(strcmp(arg, "--parallel-threshold") == 0 && value != NULL) {
+            options->parallel_threshold = strtoul(value, &end, 10);
+            valid = *end == '\0';
+            ++i;
+        }
+        else if(strcmp(arg, "--separate-passes") == 0) {
+            options->separate_passes = true;
+        }
+        else if(strcmp(arg, "--record") == 0 && value != NULL) {
+            options->record_filename = value;
+            ++i;
+        }
+        else if(strcmp(arg, "--replay") == 0 && value != NULL) {
+            options->replay_filename = value;
+            ++i;
+        }
+        else if(strcmp(arg, "--capture") == 0 && value != NULL) {
+            options->capture_directory = value;
+            ++i;
+        }
+        else if(strcmp(arg, "--capture-format") == 0 && value != NULL) {
+            valid = false;
+            for(int format = 0; format < FRAME_CAPTURE_FORMATS_TOTAL; ++format) {
+                if(strcmp(value, frame_capture_format_names[format]) == 0) {
+                    options->capture_format = (frame_capture_format_t)format;
+                    valid = true;
+                }
+            }
+            ++i;
+        }
+        else if(strcmp(arg, "--headless") == 0 || strcmp(arg, "--fast-forward") == 0) {
+            options->headless = true;
+        }
+        else if(strcmp(arg, "--render") == 0) {
+            options->headless_render = true;
+        }
+        else if(strcmp(arg, "--cpu-renderer") == 0) {
+            options->cpu_render = true;
+        }
+        else if(strcmp(arg, "--verify-cpu-renderer") == 0) {
+            options->verify_cpu_render = true;
+        }
+        else if(strcmp(arg, "--low-latency") == 0) {
+            options->low_latency = true;
+        }
+        else if(strcmp(arg, "--pacing") == 0 && value != NULL) {
+            valid = false;
+            for(int mode = 0; mode < FRAME_PACING_MODES_TOTAL; ++mode) {
+                if(strcmp(value, frame_pacing_mode_names[mode]) == 0) {
+                    options->pacing_mode = (frame_pacing_mode_t)mode;
+                    valid = true;
+                }
+            }
+            pacing_given = true;
+            ++i;
+        }
+        else if(strcmp(arg, "--fps") == 0 && value != NULL) {
+            options->target_fps = (uint32_t)strtoul(value, &end, 10);
+            valid = *end == '\0' && options->target_fps > 0 && options->target_fps <= MAX_TARGET_FPS;
+            ++i;
+        }
+        else if(strcmp(arg, "--scenario") == 0 && value != NULL) {
+            valid = false;
+            for(int scenario = 0; scenario < SCENARIOS_TOTAL; ++scenario) {
+                if(strcmp(value, scenario_names[scenario]) == 0) {
+                    options->scenario = (scenario_t)scenario;
+                    valid = true;
+                }
+            }
+            ++i;
+        }
+        else if(strcmp(arg, "--frames") == 0 && value != NULL) {
+            options->num_frames = (uint32_t)strtoul(value, &end, 10);
+            valid = *end == '\0' && options->num_frames > 0;
+            ++i;
+        }
+        else if(strcmp(arg, "--dt") == 0 && value != NULL) {
+            options->time_delta_s = strtof(value, &end);
+            valid = *end == '\0' && options->time_delta_s > 0.0F;
+            ++i;
+        }
+        else if(strcmp(arg, "--seed") == 0 && value != NULL) {
+            options->seed = (uint32_t)strtoul(value, &end, 10);
+            valid = *end == '\0';
+            seed_given = true;
+            ++i;
+        }
+        else if(strcmp(arg, "--enemies") == 0 && value != NULL) {
+            options->min_enemies = strtoul(value, &end, 10);
+            valid = *end == '\0' && options->min_enemies <= ENTITY_POOL_MAX_CAPACITY;
+            ++i;
+        }
+        else if(strcmp(arg, "--projectiles") == 0 && value != NULL) {
+            options->min_projectiles = strtoul(value, &end, 10);
+            valid = *end == '\0' && options->min_projectiles <= ENTITY_POOL_MAX_CAPACITY;
+            ++i;
+        }
+        else if(strcmp(arg, "--explosions") == 0 && value != NULL) {
+            options->min_explosions = strtoul(value, &end, 10);
+            valid = *end == '\0' && options->min_explosions <= ENTITY_POOL_MAX_CAPACITY;
+            ++i;
+        }
+        else if(strcmp(arg, "--bullets") == 0 && value != NULL) {
+            options->min_bullets = strtoul(value, &end, 10);
+            valid = *end == '\0' && options->min_bullets <= BULLET_POOL_MAX_CAPACITY;
+            ++i;
+        }
+        else if(strcmp(arg, "--rewind-budget") == 0 && value != NULL) {
+            const unsigned long budget_mib = strtoul(value, &end, 10);
+            valid = *end == '\0' && budget_mib <= SIZE_MAX >> 20;
+            options->rewind_budget = (size_t)budget_mib << 20;
+            rewind_budget_given = true;
+            ++i;
+        }
+        else if(strcmp(arg, "--verify-rewind") == 0) {
+            options->verify_rewind = true;
+        }
+        else {
+            valid = false;
+        }
 
-void spawn_projectile();
-void spawn_enemy();
-void spawn_explosion(vector_t p);
+        if(!valid) {
+            fprintf(stderr, "Invalid argument: \"%s\"\n", arg);
+        }
+    }
 
-bool is_collided(const SDL_Rect* a, const SDL_Rect* b);
-bool is_contained(const vector_t* p, const SDL_Rect* r);
+    // Only the player's own input can be recorded
+    if(valid && options->record_filename != NULL && (options->headless || options->replay_filename != NULL)) {
+        fprintf(stderr, "Only interactive sessions can be recorded\n");
+        valid = false;
+    }
 
-// ============================================================================
-// Function implementations
-// ============================================================================
+    // Interactive sessions always render, so --render only means something without a window
+    if(valid && options->headless_render && !options->headless) {
+        fprintf(stderr, "--render needs --headless or --fast-forward\n");
+        valid = false;
+    }
 
-void init()
-{
-    background_sprite_quad.x = 0;
-    background_sprite_quad.y = 266;
-    background_sprite_quad.w = 256;
-    background_sprite_quad.h = 304;
-
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_1].x = 0;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_1].y = 0;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_1].w = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_1].h = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_LEFT_1].x = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_LEFT_1].y = 0;
-    spaceship_sprite_quads[SPACESHIP_BANK_LEFT_1].w = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_LEFT_1].h = 24;
-    spaceship_sprite_quads[SPACESHIP_STATIONARY_1].x = 32;
-    spaceship_sprite_quads[SPACESHIP_STATIONARY_1].y = 0;
-    spaceship_sprite_quads[SPACESHIP_STATIONARY_1].w = 16;
-    spaceship_sprite_quads[SPACESHIP_STATIONARY_1].h = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_RIGHT_1].x = 48;
-    spaceship_sprite_quads[SPACESHIP_BANK_RIGHT_1].y = 0;
-    spaceship_sprite_quads[SPACESHIP_BANK_RIGHT_1].w = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_RIGHT_1].h = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_1].x = 64;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_1].y = 0;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_1].w = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_1].h = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_2].x = 0;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_2].y = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_2].w = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_2].h = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_LEFT_2].x = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_LEFT_2].y = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_LEFT_2].w = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_LEFT_2].h = 24;
-    spaceship_sprite_quads[SPACESHIP_STATIONARY_2].x = 32;
-    spaceship_sprite_quads[SPACESHIP_STATIONARY_2].y = 24;
-    spaceship_sprite_quads[SPACESHIP_STATIONARY_2].w = 16;
-    spaceship_sprite_quads[SPACESHIP_STATIONARY_2].h = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_RIGHT_2].x = 48;
-    spaceship_sprite_quads[SPACESHIP_BANK_RIGHT_2].y = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_RIGHT_2].w = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_RIGHT_2].h = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_2].x = 64;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_2].y = 24;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_2].w = 16;
-    spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_2].h = 24;
-
-    projectile_sprite_quads[PROJECTILE_1].x = 0;
-    projectile_sprite_quads[PROJECTILE_1].y = 0;
-    projectile_sprite_quads[PROJECTILE_1].w = 16;
-    projectile_sprite_quads[PROJECTILE_1].h = 32;
-    projectile_sprite_quads[PROJECTILE_2].x = 16;
-    projectile_sprite_quads[PROJECTILE_2].y = 0;
-    projectile_sprite_quads[PROJECTILE_2].w = 16;
-    projectile_sprite_quads[PROJECTILE_2].h = 32;
-
-    small_enemy_sprite_quads[SMALL_ENEMY_1].x = 0;
-    small_enemy_sprite_quads[SMALL_ENEMY_1].y = 0;
-    small_enemy_sprite_quads[SMALL_ENEMY_1].w = 16;
-    small_enemy_sprite_quads[SMALL_ENEMY_1].h = 16;
-    small_enemy_sprite_quads[SMALL_ENEMY_2].x = 16;
-    small_enemy_sprite_quads[SMALL_ENEMY_2].y = 0;
-    small_enemy_sprite_quads[SMALL_ENEMY_2].w = 16;
-    small_enemy_sprite_quads[SMALL_ENEMY_2].h = 16;
-
-    explosion_sprite_quads[EXPLOSION_1].x = 0;
-    explosion_sprite_quads[EXPLOSION_1].y = 0;
-    explosion_sprite_quads[EXPLOSION_1].w = 16;
-    explosion_sprite_quads[EXPLOSION_1].h = 16;
-    explosion_sprite_quads[EXPLOSION_2].x = 16;
-    explosion_sprite_quads[EXPLOSION_2].y = 0;
-    explosion_sprite_quads[EXPLOSION_2].w = 16;
-    explosion_sprite_quads[EXPLOSION_2].h = 16;
-    explosion_sprite_quads[EXPLOSION_3].x = 32;
-    explosion_sprite_quads[EXPLOSION_3].y = 0;
-    explosion_sprite_quads[EXPLOSION_3].w = 16;
-    explosion_sprite_quads[EXPLOSION_3].h = 16;
-    explosion_sprite_quads[EXPLOSION_4].x = 48;
-    explosion_sprite_quads[EXPLOSION_4].y = 0;
-    explosion_sprite_quads[EXPLOSION_4].w = 16;
-    explosion_sprite_quads[EXPLOSION_4].h = 16;
-    explosion_sprite_quads[EXPLOSION_5].x = 64;
-    explosion_sprite_quads[EXPLOSION_5].y = 0;
-    explosion_sprite_quads[EXPLOSION_5].w = 16;
-    explosion_sprite_quads[EXPLOSION_5].h = 16;
+    // Only rendered frames can be captured
+    if(valid && options->capture_directory != NULL && options->headless && !options->headless_render) {
+        fprintf(stderr, "Headless runs can only be captured with --render\n");
+        valid = false;
+    }
 
-    state.window = NULL;
-    state.renderer = NULL;
-    state.game_over = false;
-
-    state.background_texture = NULL;
-    state.spaceship_texture = NULL;
-    state.projectile_texture = NULL;
-    state.small_enemy_texture = NULL;
-    state.explosion_texture = NULL;
-
-    state.spaceship.sprite_scaling = 2;
-    state.spaceship.position.x = SCREEN_WIDTH / 2;
-    state.spaceship.position.y = SCREEN_HEIGHT - 1 - spaceship_sprite_quads[SPACESHIP_STATIONARY_1].h * state.spaceship.sprite_scaling / 2;
-    state.spaceship.velocity.x = 0;
-    state.spaceship.velocity.y = 0;
-    state.spaceship.sprite_quad = NULL;
-    state.spaceship.render_quad.x = 0;
-    state.spaceship.render_quad.y = 0;
-    state.spaceship.render_quad.w = 0;
-    state.spaceship.render_quad.h = 0;
-    state.spaceship.num_animation_frames = 2;
-    state.spaceship.animation_idx = 0;
-    state.spaceship.num_rendered_frames_per_animation_frame = 4;
-    state.spaceship.rendered_frame_idx = 0;
-    state.spaceship.is_firing = false;
-    state.spaceship.time_till_next_shot_s = 0.0F;
-
-    state.projectile_count = 0;
-    state.enemy_count = 0;
-    state.time_till_next_enemy_spawn_s = 0.0F;
-
-    if(SDL_Init(SDL_INIT_VIDEO) < 0) {
-        fprintf(stderr, "SDL failed to initialise: %s\n", SDL_GetError());
-        exit(EXIT_FAILURE);
+    // Reading frames back from a GPU renderer stalls its pipeline every frame, so only frames drawn into system memory
+    // are captured
+    if(valid && options->capture_directory != NULL && !options->headless && !options->cpu_render) {
+        fprintf(stderr, "Interactive sessions can only be captured with --cpu-renderer\n");
+        valid = false;
     }
 
-    state.window = SDL_CreateWindow(
-        "shmupsy",
-        SDL_WINDOWPOS_UNDEFINED,
-        SDL_WINDOWPOS_UNDEFINED,
-        SCREEN_WIDTH,
-        SCREEN_HEIGHT,
-        SDL_WINDOW_SHOWN);
-    if(state.window == NULL) {
-        fprintf(stderr, "SDL window could not be created: %s\n", SDL_GetError());
-        exit(EXIT_FAILURE);
+    // The CPU renderer is checked against SDL's software renderer, which only draws offscreen without a window
+    if(valid && options->verify_cpu_render && (!options->headless_render || !options->cpu_render)) {
+        fprintf(stderr, "Only headless runs rendered with --cpu-renderer can verify it\n");
+        valid = false;
     }
 
-    state.renderer = SDL_CreateRenderer(state.window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if(state.renderer == NULL) {
-        fprintf(stderr, "SDL renderer could not be created: %s\n", SDL_GetError());
-        exit(EXIT_FAILURE);
+    // Rewinding is only verified at the end of a headless run, against what it recorded along the way
+    if(valid && options->verify_rewind && (!options->headless || options->rewind_budget == 0)) {
+        fprintf(stderr, "Only headless runs with a rewind budget can verify rewinding\n");
+        valid = false;
     }
 
-    int imgFlags = IMG_INIT_PNG;
-    if(!(IMG_Init(imgFlags) & imgFlags)) {
-        fprintf(stderr, "SDL image could no be initialised: %s\n", IMG_GetError());
+    if(!valid) {
+        fprintf(stderr, "Usage: %s [--brute-force-collisions] [--threads N] [--parallel-threshold N] [--separate-passes] [--cpu-renderer] [--low-latency]\n", argv[0]);
+        fprintf(stderr, "           [--pacing vsync|fixed|uncapped] [--fps N] [--rewind-budget MIB]\n");
+        fprintf(stderr, "           [--record FILE | --replay FILE [--fast-forward [--render]]] [--capture DIR [--capture-format raw|png]]\n");
+        fprintf(stderr, "       %s --headless [--render [--cpu-renderer [--verify-cpu-renderer]]] [--scenario gameplay|swarm|barrage|saturated|bullethell]\n", argv[0]);
+        fprintf(stderr, "           [--frames N] [--dt SECONDS] [--seed N] [--rewind-budget MIB] [--verify-rewind]\n");
+        fprintf(stderr, "           [--enemies N] [--projectiles N] [--explosions N] [--bullets N]\n");
         exit(EXIT_FAILURE);
     }
 
-    state.background_texture = load_texture(background_img);
-    state.spaceship_texture = load_texture(spaceship_img);
-    state.projectile_texture = load_texture(projectile_img);
-    state.small_enemy_texture = load_texture(small_enemy_img);
-    state.explosion_texture = load_texture(explosion_img);
+    // Asking for a frame rate implies pacing to it, unless a pacing mode was also given
+    if(!pacing_given && options->target_fps != DEFAULT_TARGET_FPS) {
+        options->pacing_mode = FRAME_PACING_FIXED;
+    }
+
+    // Recording can cost headless runs more than the rest of a step in the busiest scenarios, so they only record when
+    // asked to, or when verifying rewinding
+    if(options->headless && !rewind_budget_given && !options->verify_rewind) {
+        options->rewind_budget = 0;
+    }
+
+    // Headless runs must be repeatable, so they only take a seed from the clock when asked to
+    if(options->headless && !seed_given) {
+        options->seed = BENCHMARK_DEFAULT_SEED;
+    }
 
-    srand(time(NULL));
+    // Stress scenarios keep their pools topped up, unless told otherwise
+    const bool swarm = options->scenario == SCENARIO_SWARM || options->scenario == SCENARIO_SATURATED;
+    const bool barrage = options->scenario == SCENARIO_BARRAGE || options->scenario == SCENARIO_SATURATED;
+    const bool saturated = options->scenario == SCENARIO_SATURATED;
+    const bool bullet_hell = options->scenario == SCENARIO_BULLET_HELL;
+    if(options->min_enemies == SIZE_MAX) {
+        options->min_enemies = swarm ? BENCHMARK_STRESS_NUM_ENTITIES : bullet_hell ? BENCHMARK_BULLET_HELL_NUM_EMITTERS : 0;
+    }
+    if(options->min_projectiles == SIZE_MAX) {
+        options->min_projectiles = barrage ? BENCHMARK_STRESS_NUM_ENTITIES : 0;
+    }
+    if(options->min_explosions == SIZE_MAX) {
+        options->min_explosions = saturated ? BENCHMARK_STRESS_NUM_ENTITIES : 0;
+    }
+    if(options->min_bullets == SIZE_MAX) {
+        options->min_bullets = bullet_hell ? BENCHMARK_BULLET_HELL_NUM_BULLETS : 0;
+    }
 }
 
-void destroy()
+void init(const options_t* const options)
 {
-    SDL_DestroyTexture(state.explosion_texture);
-    state.explosion_texture = NULL;
+    // Every sprite quad comes from the asset pack, already in atlas coordinates
+    asset_pack_open(&state.assets, ASSET_PACK_FILENAME);
+    simulation_sprites_load(&state.sprites, &state.assets);
+
+    state.window = NULL;
+    state.render_target = NULL;
+    state.renderer = NULL;
+    state.cpu_render = options->cpu_render;
+    state.framebuffer_texture = NULL;
+    state.reference_target = NULL;
+    state.capturing = options->capture_directory != NULL;
+    state.atlas_texture = NULL;
+
+    simulation_config_t config = {
+        .sprites = &state.sprites,
+        .seed = options->seed,
+        .time_step_s = fixed_from_float(options->headless ? options->time_delta_s : SIMULATION_TIME_STEP_S),
+        .collision_mode = options->collision_mode,
+        .invulnerable = false,
+        .workers = &state.workers,
+        .parallel_threshold = options->parallel_threshold,
+        .separate_passes = options->separate_passes,
+        .clock = SDL_GetPerformanceCounter
+    };
+
+    // A replay is simulated exactly as it was recorded, so it brings its own seed and step length. Otherwise headless
+    // runs cannot be lost, so that every scenario runs its full length.
+    state.replay_mode = REPLAY_MODE_OFF;
+    if(options->replay_filename != NULL) {
+        replay_load(&state.replay, options->replay_filename);
+        state.replay_mode = REPLAY_MODE_PLAYBACK;
+        config.time_step_s = state.replay.time_step_s;
+        config.seed = state.replay.seed;
+    }
+    else if(options->record_filename != NULL) {
+        replay_init(&state.replay, config.seed, config.time_step_s);
+        state.replay_mode = REPLAY_MODE_RECORD;
+    }
+    else if(options->headless) {
+        config.invulnerable = true;
+    }
+
+    worker_pool_init(&state.workers, options->num_threads);
+    simulation_init(&state.sim, &config);
+    state.input = 0;
+
+    state.rewind_enabled = options->rewind_budget > 0;
+    state.rewinding = false;
+    state.rewind_step = 0;
+    if(state.rewind_enabled) {
+        rewind_init(&state.rewind, options->rewind_budget, REWIND_KEYFRAME_INTERVAL);
+        simulation_init(&state.rewind_sim, &config);
+    }
+
+    input_queue_init(&state.input_queue, INPUT_QUEUE_CAPACITY);
+    render_snapshot_buffer_init(&state.snapshots, RENDER_INITIAL_CAPACITY);
+    atomic_init(&simulation_running, false);
+    state.accumulated_ticks = 0;
+    state.last_time = 0;
+
+    state.num_inputs_polled = 0;
+    state.num_inputs_applied = 0;
+    state.num_inputs_presented = 0;
+    sample_stats_init(&state.input_latency_ms, MAX_TIMING_SAMPLES);
+    frame_pacer_init(&state.pacer, options->pacing_mode, options->target_fps, MAX_TIMING_SAMPLES);
+
+    if(options->headless) {
+        // Headless runs have no window, and only render if asked to, into an offscreen surface
+        if(SDL_Init(0) < 0) {
+            fprintf(stderr, "SDL failed to initialise: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
+
+        if(options->headless_render) {
+            state.render_target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+            if(state.render_target == NULL) {
+                fprintf(stderr, "SDL render target could not be created: %s\n", SDL_GetError());
+                exit(EXIT_FAILURE);
+            }
+
+            if(options->verify_cpu_render) {
+                state.reference_target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+                if(state.reference_target == NULL) {
+                    fprintf(stderr, "SDL reference render target could not be created: %s\n", SDL_GetError());
+                    exit(EXIT_FAILURE);
+                }
+            }
+
+            if(!state.cpu_render || state.reference_target != NULL) {
+                state.renderer = SDL_CreateSoftwareRenderer(state.cpu_render ? state.reference_target : state.render_target);
+                if(state.renderer == NULL) {
+                    fprintf(stderr, "SDL renderer could not be created: %s\n", SDL_GetError());
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+    else {
+        if(SDL_Init(SDL_INIT_VIDEO) < 0) {
+            fprintf(stderr, "SDL failed to initialise: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
 
-    SDL_DestroyTexture(state.small_enemy_texture);
-    state.small_enemy_texture = NULL;
+        state.window = SDL_CreateWindow(
+            "shmupsy",
+            SDL_WINDOWPOS_UNDEFINED,
+            SDL_WINDOWPOS_UNDEFINED,
+            SCREEN_WIDTH,
+            SCREEN_HEIGHT,
+            SDL_WINDOW_SHOWN);
+        if(state.window == NULL) {
+            fprintf(stderr, "SDL window could not be created: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
+
+        // The CPU renderer only needs a frame copied to the window, so it takes whichever renderer is available. Presenting
+        // only waits for the display when pacing with vsync.
+        Uint32 renderer_flags = state.cpu_render ? 0 : SDL_RENDERER_ACCELERATED;
+        if(options->pacing_mode == FRAME_PACING_VSYNC) {
+            renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+        }
+        state.renderer = SDL_CreateRenderer(state.window, -1, renderer_flags);
+        if(state.renderer == NULL) {
+            fprintf(stderr, "SDL renderer could not be created: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(state.cpu_render) {
+        init_cpu_renderer(options);
+    }
+    if(state.renderer != NULL && (!state.cpu_render || state.reference_target != NULL)) {
+        sprite_batch_init(&state.sprite_batch, state.renderer, RENDER_INITIAL_CAPACITY);
+        state.atlas_texture = load_atlas_texture();
+    }
+
+    if(state.capturing) {
+        frame_capture_init(&state.capture, options->capture_directory, options->capture_format, SCREEN_WIDTH, SCREEN_HEIGHT, FRAME_CAPTURE_RING_SIZE);
+    }
 
-    SDL_DestroyTexture(state.projectile_texture);
-    state.projectile_texture = NULL;
+    TRACE_INIT();
+}
 
-    SDL_DestroyTexture(state.spaceship_texture);
-    state.spaceship_texture = NULL;
+void destroy()
+{
+    TRACE_WRITE(trace_filename);
+    TRACE_DESTROY();
+
+    if(state.cpu_render) {
+        cpu_renderer_destroy(&state.cpu_renderer);
+        worker_pool_destroy(&state.render_workers);
+        SDL_DestroyTexture(state.framebuffer_texture);
+        state.framebuffer_texture = NULL;
+    }
+    if(!state.cpu_render || state.reference_target != NULL) {
+        SDL_DestroyTexture(state.atlas_texture);
+        state.atlas_texture = NULL;
 
-    SDL_DestroyTexture(state.background_texture);
-    state.background_texture = NULL;
+        sprite_batch_destroy(&state.sprite_batch);
+    }
 
     SDL_DestroyRenderer(state.renderer);
     state.renderer = NULL;
 
+    SDL_FreeSurface(state.render_target);
+    state.render_target = NULL;
+    SDL_FreeSurface(state.reference_target);
+    state.reference_target = NULL;
+
     SDL_DestroyWindow(state.window);
     state.window = NULL;
 
-    IMG_Quit();
     SDL_Quit();
+
+    render_snapshot_buffer_destroy(&state.snapshots);
+    input_queue_destroy(&state.input_queue);
+    sample_stats_destroy(&state.input_latency_ms);
+    frame_pacer_destroy(&state.pacer);
+
+    if(state.rewind_enabled) {
+        simulation_destroy(&state.rewind_sim);
+        rewind_destroy(&state.rewind);
+    }
+    simulation_destroy(&state.sim);
+    worker_pool_destroy(&state.workers);
+
+    if(state.replay_mode != REPLAY_MODE_OFF) {
+        replay_destroy(&state.replay);
+    }
+
+    asset_pack_close(&state.assets);
 }
 
 void handle_event(const SDL_Event* const event)
 {
-    // Set the spaceship's velocity
-    if(event->key.repeat == 0) {
-        if(event->type == SDL_KEYDOWN) {
-            switch(event->key.keysym.sym) {
-            case SDLK_UP:
-                state.spaceship.velocity.y -= SPACESHIP_VELOCITY_PPS;
-                break;
-            case SDLK_DOWN:
-                state.spaceship.velocity.y += SPACESHIP_VELOCITY_PPS;
-                break;
-            case SDLK_LEFT:
-                state.spaceship.velocity.x -= SPACESHIP_VELOCITY_PPS;
-                break;
-            case SDLK_RIGHT:
-                state.spaceship.velocity.x += SPACESHIP_VELOCITY_PPS;
-                break;
-            case SDLK_SPACE:
-                state.spaceship.is_firing = true;
-                break;
-            }
-        }
-        else if(event->type == SDL_KEYUP) {
-            switch(event->key.keysym.sym) {
-            case SDLK_UP:
-                state.spaceship.velocity.y += SPACESHIP_VELOCITY_PPS;
-                break;
-            case SDLK_DOWN:
-                state.spaceship.velocity.y -= SPACESHIP_VELOCITY_PPS;
-                break;
-            case SDLK_LEFT:
-                state.spaceship.velocity.x += SPACESHIP_VELOCITY_PPS;
-                break;
-            case SDLK_RIGHT:
-                state.spaceship.velocity.x -= SPACESHIP_VELOCITY_PPS;
-                break;
-            case SDLK_SPACE:
-                state.spaceship.is_firing = false;
-                state.spaceship.time_till_next_shot_s = 0.0F;
-                break;
-            }
-        }
+    // The simulation only sees which buttons are held down, so key repeats change nothing
+    simulation_input_t button = 0;
+    switch(event->key.keysym.sym) {
+    case SDLK_UP:
+        button = SIMULATION_INPUT_UP;
+        break;
+    case SDLK_DOWN:
+        button = SIMULATION_INPUT_DOWN;
+        break;
+    case SDLK_LEFT:
+        button = SIMULATION_INPUT_LEFT;
+        break;
+    case SDLK_RIGHT:
+        button = SIMULATION_INPUT_RIGHT;
+        break;
+    case SDLK_SPACE:
+        button = SIMULATION_INPUT_FIRE;
+        break;
+    }
+
+    if(event->type == SDL_KEYDOWN) {
+        state.input |= button;
+    }
+    else if(event->type == SDL_KEYUP) {
+        state.input &= ~button;
     }
 }
 
-void update_entity_positions(float time_delta_s)
+void apply_input_event(const SDL_Event* const event)
 {
-    // Update the spaceship's position
-    state.spaceship.position.x += (int32_t)(state.spaceship.velocity.x * time_delta_s);
-    state.spaceship.position.y += (int32_t)(state.spaceship.velocity.y * time_delta_s);
-    const int32_t spaceship_min_x = (state.spaceship.render_quad.w / 2);
-    const int32_t spaceship_max_x = SCREEN_WIDTH - (state.spaceship.render_quad.w / 2);
-    const int32_t spaceship_min_y = (state.spaceship.render_quad.h / 2);
-    const int32_t spaceship_max_y = SCREEN_HEIGHT - (state.spaceship.render_quad.h / 2);
-    state.spaceship.position.x = state.spaceship.position.x < spaceship_min_x ? spaceship_min_x : state.spaceship.position.x;
-    state.spaceship.position.x = state.spaceship.position.x >= spaceship_max_x ? (spaceship_max_x - 1) : state.spaceship.position.x;
-    state.spaceship.position.y = state.spaceship.position.y < spaceship_min_y ? spaceship_min_y : state.spaceship.position.y;
-    state.spaceship.position.y = state.spaceship.position.y >= spaceship_max_y ? (spaceship_max_y - 1) : state.spaceship.position.y;
-    // Update the spaceship's rendering quad origin
-    state.spaceship.render_quad.x = state.spaceship.position.x - state.spaceship.render_quad.w / 2;
-    state.spaceship.render_quad.y = state.spaceship.position.y - state.spaceship.render_quad.h / 2;
-
-    // Update all projectile's positions
-    for(size_t i = 0; i < state.projectile_count; ++i) {
-        projectile_t* projectile = &state.projectiles[i];
-        projectile->position.y += (int32_t)(projectile->velocity.y * time_delta_s);
-        projectile->render_quad.y = projectile->position.y - projectile->render_quad.h / 2;
-    }
-    // Remove all projectiles that have exited the screen
-    for(size_t i = 0; i < state.projectile_count;) {
-        if(state.projectiles[i].position.y < 0) {
-            state.projectiles[i] = state.projectiles[state.projectile_count - 1];
-            state.projectile_count--;
-            continue;
-        }
-        ++i;
+    if(apply_rewind_event(event)) {
+        return;
     }
 
-    // Update all enemies' positions
-    for(size_t i = 0; i < state.enemy_count; ++i) {
-        enemy_t* enemy = &state.enemies[i];
-        enemy->position.y += (int32_t)(enemy->velocity.y * time_delta_s);
-        enemy->render_quad.y = enemy->position.y - enemy->render_quad.h / 2;
+    // While replaying, the recorded input replaces the player's
+    if(state.replay_mode == REPLAY_MODE_PLAYBACK) {
+        return;
     }
-    // Remove all enemies that have exited the screen
-    for(size_t i = 0; i < state.enemy_count;) {
-        if(state.enemies[i].position.y > SCREEN_HEIGHT) {
-            state.enemies[i] = state.enemies[state.enemy_count - 1];
-            state.enemy_count--;
-            continue;
-        }
-        ++i;
+    if(state.replay_mode == REPLAY_MODE_RECORD) {
+        replay_record(&state.replay, state.sim.step, event);
     }
+    handle_event(event);
 }
 
-void spawn_entities(float time_delta_s)
+bool apply_rewind_event(const SDL_Event* const event)
 {
-    // If the ship is firing, and is ready to generate a new projectile, then do so now
-    if(state.spaceship.is_firing) {
-        if(state.spaceship.time_till_next_shot_s <= 0.0F) {
-            spawn_projectile();
-            state.spaceship.time_till_next_shot_s = 1.0F / SPACESHIP_FIRERATE_PPS;
-        }
-        else {
-            state.spaceship.time_till_next_shot_s -= time_delta_s;
-        }
+    // Only the rewind keys are taken, and every other key still changes the buttons held, even while paused
+    const SDL_Keycode key = event->key.keysym.sym;
+    const bool is_seek_key = key == SDLK_COMMA || key == SDLK_PERIOD || key == SDLK_PAGEUP || key == SDLK_PAGEDOWN;
+    if(!state.rewind_enabled || (key != REWIND_HOTKEY && !(state.rewinding && is_seek_key))) {
+        return false;
+    }
+    if(event->type != SDL_KEYDOWN) {
+        return true;
     }
 
-    // If enough time has elapsed, spawn an enemy
-    if(state.time_till_next_enemy_spawn_s <= 0.0F) {
-        spawn_enemy();
-        state.time_till_next_enemy_spawn_s = 1.0F / ENEMY_SPAWN_RATE_EPS;
+    uint32_t oldest;
+    uint32_t newest;
+    if(!rewind_range(&state.rewind, &oldest, &newest)) {
+        return true;
     }
-    else {
-        state.time_till_next_enemy_spawn_s -= time_delta_s;
+
+    if(key == REWIND_HOTKEY && state.rewinding) {
+        // The game carries on from the step shown, forgetting the ones after it, unless its input is being recorded or
+        // played back, which only ever moves forward
+        state.rewinding = false;
+        if(state.replay_mode == REPLAY_MODE_OFF && state.rewind_step != state.sim.step && rewind_seek(&state.rewind, state.rewind_step, &state.sim)) {
+            rewind_truncate(&state.rewind, state.rewind_step);
+        }
+        printf("Resumed from step %u\n", state.sim.step);
+        return true;
     }
-}
 
-void update_entity_animations()
-{
-    // Select the correct spaceship sprite and set the rendering quad dimensions accordingly
-    state.spaceship.sprite_quad = &spaceship_sprite_quads[SPACESHIP_STATIONARY_1 + state.spaceship.animation_idx];
-    if(state.spaceship.velocity.x < 0) {
-        state.spaceship.sprite_quad = &spaceship_sprite_quads[SPACESHIP_BANK_HARD_LEFT_1 + state.spaceship.animation_idx];
+    uint32_t step = state.rewinding ? state.rewind_step : newest;
+    if(key == SDLK_COMMA) {
+        step = step > oldest ? step - 1 : oldest;
     }
-    else if(state.spaceship.velocity.x > 0) {
-        state.spaceship.sprite_quad = &spaceship_sprite_quads[SPACESHIP_BANK_HARD_RIGHT_1 + state.spaceship.animation_idx];
+    else if(key == SDLK_PERIOD) {
+        step = step < newest ? step + 1 : newest;
     }
-    state.spaceship.render_quad.w = state.spaceship.sprite_quad->w * state.spaceship.sprite_scaling;
-    state.spaceship.render_quad.h = state.spaceship.sprite_quad->h * state.spaceship.sprite_scaling;
-    // Update the spaceship's animation indices as needed
-    ++state.spaceship.rendered_frame_idx;
-    if(state.spaceship.rendered_frame_idx == state.spaceship.num_rendered_frames_per_animation_frame) {
-        state.spaceship.rendered_frame_idx = 0;
-        ++state.spaceship.animation_idx;
-        state.spaceship.animation_idx %= state.spaceship.num_animation_frames;
+    else if(key == SDLK_PAGEUP) {
+        step = step - oldest > REWIND_KEYFRAME_INTERVAL ? step - REWIND_KEYFRAME_INTERVAL : oldest;
+    }
+    else if(key == SDLK_PAGEDOWN) {
+        step = newest - step > REWIND_KEYFRAME_INTERVAL ? step + REWIND_KEYFRAME_INTERVAL : newest;
     }
 
-    // Update all projectile's animations
-    for(size_t i = 0; i < state.projectile_count; ++i) {
-        projectile_t* projectile = &state.projectiles[i];
-        projectile->sprite_quad = &projectile_sprite_quads[PROJECTILE_1 + projectile->animation_idx];
+    if(rewind_seek(&state.rewind, step, &state.rewind_sim)) {
+        state.rewinding = true;
+        state.rewind_step = step;
+        printf("Showing step %u of %u to %u\n", step, oldest, newest);
+    }
+    return true;
+}
 
-        ++projectile->rendered_frame_idx;
-        if(projectile->rendered_frame_idx == projectile->num_rendered_frames_per_animation_frame) {
-            projectile->rendered_frame_idx = 0;
-            ++projectile->animation_idx;
-            projectile->animation_idx %= projectile->num_animation_frames;
+void step_simulation()
+{
+    // Recorded input is applied at the start of exactly the step it was recorded on
+    if(state.replay_mode == REPLAY_MODE_PLAYBACK) {
+        SDL_Event event;
+        while(replay_next_event(&state.replay, state.sim.step, &event)) {
+            handle_event(&event);
         }
     }
 
-    // Update all enemies' animations
-    for(size_t i = 0; i < state.enemy_count; ++i) {
-        enemy_t* enemy = &state.enemies[i];
-        enemy->sprite_quad = &small_enemy_sprite_quads[SMALL_ENEMY_1 + enemy->animation_idx];
+    TRACE_BEGIN(update_start);
+    simulation_step(&state.sim, state.input);
 
-        ++enemy->rendered_frame_idx;
-        if(enemy->rendered_frame_idx == enemy->num_rendered_frames_per_animation_frame) {
-            enemy->rendered_frame_idx = 0;
-            ++enemy->animation_idx;
-            enemy->animation_idx %= enemy->num_animation_frames;
-        }
+    // The simulation times its phases on the performance counter, like every other phase
+    const uint64_t* phase_times = state.sim.phase_times;
+    for(int phase = 0; phase < SIMULATION_PHASES_TOTAL; ++phase) {
+        phase_ticks[phase] += phase_times[phase + 1] - phase_times[phase];
+        TRACE_SPAN(phase_names[phase], phase_times[phase], phase_times[phase + 1]);
     }
 
-    // Update all explosions animations and remove those that have completed
-    for(size_t i = 0; i < state.explosions_count;) {
-        explosion_t* explosion = &state.explosions[i];
-        explosion->sprite_quad = &explosion_sprite_quads[EXPLOSION_1 + explosion->animation_idx];
+    // Recording is timed as a phase of its own, since it runs every step
+    if(state.rewind_enabled) {
+        uint64_t phase_start = SDL_GetPerformanceCounter();
+        rewind_record(&state.rewind, &state.sim);
+        end_phase(PHASE_REWIND, &phase_start);
+    }
 
-        ++explosion->rendered_frame_idx;
-        if(explosion->rendered_frame_idx == explosion->num_rendered_frames_per_animation_frame) {
-            explosion->rendered_frame_idx = 0;
-            ++explosion->animation_idx;
-            if(explosion->animation_idx == explosion->num_animation_frames) {
-                state.explosions[i] = state.explosions[state.explosions_count - 1];
-                state.explosions_count--;
-                continue;
-            }
+    TRACE_COUNTER("projectiles", (int64_t)state.sim.projectiles.count);
+    TRACE_COUNTER("enemies", (int64_t)state.sim.enemies.count);
+    TRACE_COUNTER("explosions", (int64_t)state.sim.explosions.count);
+    TRACE_COUNTER("bullets", (int64_t)state.sim.bullets.count);
+    TRACE_END(update_start, "update");
+}
+
+bool is_replay_finished()
+{
+    return state.replay_mode == REPLAY_MODE_PLAYBACK && state.sim.step >= state.replay.num_steps;
+}
+
+void finish_replay(const options_t* const options)
+{
+    if(state.replay_mode == REPLAY_MODE_RECORD) {
+        state.replay.num_steps = state.sim.step;
+        state.replay.checksum = simulation_checksum(&state.sim);
+        if(replay_save(&state.replay, options->record_filename)) {
+            printf("Recorded %u steps and %zu input events to: \"%s\"\n", state.replay.num_steps, state.replay.num_events, options->record_filename);
         }
-        ++i;
+    }
+    else if(state.replay_mode == REPLAY_MODE_PLAYBACK && is_replay_finished()) {
+        const bool matched = simulation_checksum(&state.sim) == state.replay.checksum;
+        printf("Replayed %u steps: %s\n", state.sim.step, matched ? "final state matches the recording" : "final state differs from the recording");
     }
 }
 
-void check_collisions()
+void end_phase(const int phase, uint64_t* const phase_start)
 {
-    // Check enemy and projectile collisions
-    for(size_t i = 0; i < state.projectile_count;) {
-        projectile_t* projectile = &state.projectiles[i];
-        bool collision_detected = false;
+    const uint64_t now = SDL_GetPerformanceCounter();
+    phase_ticks[phase] += now - *phase_start;
+    TRACE_SPAN(phase_names[phase], *phase_start, now);
+    *phase_start = now;
+}
 
-        for(size_t j = 0; j < state.enemy_count; ++j) {
-            enemy_t* enemy = &state.enemies[j];
+int run_simulation(void* const data)
+{
+    (void)data;
 
-            if(is_contained(&projectile->position, &enemy->render_quad)) {
-                spawn_explosion(enemy->position);
-                state.enemies[j] = state.enemies[state.enemy_count - 1];
-                state.enemy_count--;
-                collision_detected = true;
-                break;
-            }
-        }
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    const uint64_t step_ticks = frequency / SIMULATION_STEP_RATE_HZ;
+    state.last_time = SDL_GetPerformanceCounter();
 
-        if(collision_detected) {
-            state.projectiles[i] = state.projectiles[state.projectile_count - 1];
-            state.projectile_count--;
-            continue;
-        }
-        ++i;
-    }
+    while(atomic_load_explicit(&simulation_running, memory_order_acquire)) {
+        advance_simulation();
 
-    // Check enemy and spaceship collisions
-    for(size_t i = 0; i < state.enemy_count; ++i) {
-        enemy_t* enemy = &state.enemies[i];
-        if(is_collided(&state.spaceship.render_quad, &enemy->render_quad)) {
-            spawn_explosion(state.spaceship.position);
-            state.game_over = true;
+        // A replay ends the session once it has played back every recorded step
+        if(is_replay_finished()) {
+            atomic_store_explicit(&simulation_running, false, memory_order_release);
             break;
         }
+
+        // Sleep until shortly before the next step is due
+        const uint64_t remaining_ms = (step_ticks - state.accumulated_ticks) * 1000 / frequency;
+        if(remaining_ms > 1) {
+            SDL_Delay((uint32_t)(remaining_ms - 1));
+        }
     }
+
+    return 0;
 }
 
-void update_background()
+void advance_simulation()
 {
-    const uint32_t frames_per_scroll = 4;
-    static uint32_t frame_counter = 0;
+    // Real time is measured with the high resolution counter, and consumed by the simulation in fixed steps
+    const uint64_t step_ticks = SDL_GetPerformanceFrequency() / SIMULATION_STEP_RATE_HZ;
+    const uint64_t max_accumulated_ticks = step_ticks * SIMULATION_MAX_CATCH_UP_STEPS;
+    const uint64_t current_time = SDL_GetPerformanceCounter();
+    state.accumulated_ticks += current_time - state.last_time;
+    state.last_time = current_time;
+    if(state.accumulated_ticks > max_accumulated_ticks) {
+        state.accumulated_ticks = max_accumulated_ticks;
+    }
+
+    // While paused, no time passes for the game, and the step being looked at is shown as it was, without blending
+    if(state.rewinding) {
+        SDL_Event event;
+        while(input_queue_pop(&state.input_queue, &event)) {
+            apply_input_event(&event);
+            ++state.num_inputs_applied;
+        }
+        state.accumulated_ticks = 0;
 
-    frame_counter++;
-    if(frame_counter != frames_per_scroll) {
+        const simulation_t* sim = state.rewinding ? &state.rewind_sim : &state.sim;
+        capture_snapshot(render_snapshot_buffer_begin_write(&state.snapshots), sim, current_time - step_ticks);
+        render_snapshot_buffer_publish(&state.snapshots);
         return;
     }
-    frame_counter = 0;
 
-    if(background_sprite_quad.y != 0) {
-        background_sprite_quad.y -= 1;
-    }
-    else {
-        background_sprite_quad.y = 304;
+    if(state.accumulated_ticks >= step_ticks) {
+        // Apply the input that arrived since the last steps, then run as many fixed steps as have elapsed
+        SDL_Event event;
+        while(input_queue_pop(&state.input_queue, &event)) {
+            apply_input_event(&event);
+            ++state.num_inputs_applied;
+        }
+        while(state.accumulated_ticks >= step_ticks && !is_replay_finished()) {
+            step_simulation();
+            state.accumulated_ticks -= step_ticks;
+        }
+
+        capture_snapshot(render_snapshot_buffer_begin_write(&state.snapshots), &state.sim, current_time - state.accumulated_ticks);
+        render_snapshot_buffer_publish(&state.snapshots);
     }
 }
 
-void update_state()
+void capture_snapshot(render_snapshot_t* const snapshot, const simulation_t* const sim, const uint64_t step_time)
 {
-    // Get the time delta since the last update
-    const uint32_t current_time_ms = SDL_GetTicks();
-    static bool time_initialised = false;
-    static uint32_t last_update_time_ms = 0;
-    if(!time_initialised) {
-        last_update_time_ms = current_time_ms;
-        time_initialised = true;
+    snapshot->step_time = step_time;
+    snapshot->num_inputs = state.num_inputs_applied;
+
+    // Sprites are placed at their exact sub-pixel positions, which are only converted from fixed-point here
+    // Background
+    const SDL_FRect background_render_quad = {
+        .x = 0.0F,
+        .y = 0.0F,
+        .w = (float)SCREEN_WIDTH,
+        .h = (float)SCREEN_HEIGHT
+    };
+    render_snapshot_add(snapshot, &sim->background_quad, &background_render_quad, 0.0F, 0.0F);
+    // Ship, which has been animating since the first step, and banks in the direction it is moving
+    if(!sim->game_over) {
+        const animation_clip_t* clip = &sim->spaceship_stationary_clip;
+        if(sim->spaceship.velocity.x < 0) {
+            clip = &sim->spaceship_bank_hard_left_clip;
+        }
+        else if(sim->spaceship.velocity.x > 0) {
+            clip = &sim->spaceship_bank_hard_right_clip;
+        }
+        const float half_w = (float)sim->spaceship.render_quad.w / 2.0F;
+        const float half_h = (float)sim->spaceship.render_quad.h / 2.0F;
+        const SDL_FRect render_quad = {
+            .x = fixed_to_float(sim->spaceship.position.x) - half_w,
+            .y = fixed_to_float(sim->spaceship.position.y) - half_h,
+            .w = (float)sim->spaceship.render_quad.w,
+            .h = (float)sim->spaceship.render_quad.h
+        };
+        const float prev_x = fixed_to_float(sim->spaceship.previous_position.x) - half_w;
+        const float prev_y = fixed_to_float(sim->spaceship.previous_position.y) - half_h;
+        render_snapshot_add(snapshot, animation_clip_frame(clip, sim->step), &render_quad, prev_x, prev_y);
     }
-    const float time_delta_s = (float)(current_time_ms - last_update_time_ms) / 1000.0F;
-    last_update_time_ms = current_time_ms;
-
-    update_entity_animations();
-
-    if(!state.game_over) {
-        update_background();
-
-        update_entity_positions(time_delta_s);
+    // Projectiles, enemies and explosions
+    const entity_pool_t* pools[] = { &sim->projectiles, &sim->enemies, &sim->explosions };
+    for(size_t p = 0; p < sizeof(pools) / sizeof(pools[0]); ++p) {
+        const entity_pool_t* pool = pools[p];
+        for(size_t i = 0; i < pool->count; ++i) {
+            const entity_cold_t* cold = &pool->cold[i];
+            const float half_w = (float)cold->render_w / 2.0F;
+            const float half_h = (float)cold->render_h / 2.0F;
+            const SDL_FRect render_quad = {
+                .x = fixed_to_float(pool->x[i]) - half_w,
+                .y = fixed_to_float(pool->y[i]) - half_h,
+                .w = (float)cold->render_w,
+                .h = (float)cold->render_h
+            };
+            const float prev_y = fixed_to_float(pool->prev_y[i]) - half_h;
+            render_snapshot_add(snapshot, animation_clip_frame(cold->clip, sim->step - cold->spawn_step), &render_quad, render_quad.x, prev_y);
+        }
+    }
+    // Enemy bullets, over everything else, since the player has to see every one of them
+    const bullet_pool_t* bullets = &sim->bullets;
+    const float bullet_w = (float)(sim->enemy_bullet_clip.frames[0].w * SIMULATION_ENEMY_BULLET_SPRITE_SCALING);
+    const float bullet_h = (float)(sim->enemy_bullet_clip.frames[0].h * SIMULATION_ENEMY_BULLET_SPRITE_SCALING);
+    for(size_t i = 0; i < bullets->count; ++i) {
+        const SDL_FRect render_quad = {
+            .x = fixed_to_float(bullets->x[i]) - bullet_w / 2.0F,
+            .y = fixed_to_float(bullets->y[i]) - bullet_h / 2.0F,
+            .w = bullet_w,
+            .h = bullet_h
+        };
+        const float prev_x = fixed_to_float(bullets->prev_x[i]) - bullet_w / 2.0F;
+        const float prev_y = fixed_to_float(bullets->prev_y[i]) - bullet_h / 2.0F;
+        render_snapshot_add(snapshot, animation_clip_frame(&sim->enemy_bullet_clip, sim->step - bullets->spawn_step[i]), &render_quad, prev_x, prev_y);
+    }
+}
 
-        update_entity_animations();
+void render(const render_snapshot_t* const snapshot, const float alpha)
+{
+    if(state.cpu_render) {
+        render_cpu(snapshot, alpha);
+        return;
+    }
 
-        spawn_entities(time_delta_s);
+    uint64_t phase_start = SDL_GetPerformanceCounter();
+    draw_sprites(snapshot, alpha);
+    end_phase(PHASE_RENDER, &phase_start);
+}
 
-        check_collisions();
+void render_cpu(const render_snapshot_t* const snapshot, const float alpha)
+{
+    uint64_t phase_start = SDL_GetPerformanceCounter();
+
+    // The frame is kept in system memory, so that it can be captured without reading it back from the renderer
+    cpu_renderer_draw(&state.cpu_renderer, state.render_target->pixels, state.render_target->pitch, snapshot, alpha);
+    if(state.framebuffer_texture != NULL) {
+        if(SDL_UpdateTexture(state.framebuffer_texture, NULL, state.render_target->pixels, state.render_target->pitch) < 0) {
+            fprintf(stderr, "SDL framebuffer texture could not be updated: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
+        SDL_RenderCopy(state.renderer, state.framebuffer_texture, NULL, NULL);
     }
+
+    end_phase(PHASE_RENDER, &phase_start);
 }
 
-void render()
+void draw_sprites(const render_snapshot_t* const snapshot, const float alpha)
 {
     SDL_SetRenderDrawColor(state.renderer, 0x0, 0x0, 0x0, 0xFF);
     SDL_RenderClear(state.renderer);
 
-    // Render background
-    SDL_Rect background_render_quad;
-    background_render_quad.x = 0;
-    background_render_quad.y = 0;
-    background_render_quad.w = SCREEN_WIDTH;
-    background_render_quad.h = SCREEN_HEIGHT;
-    SDL_RenderCopy(state.renderer, state.background_texture, &background_sprite_quad, &background_render_quad);
-    if(!state.game_over) {
-        // Render ship
-        SDL_RenderCopy(state.renderer, state.spaceship_texture, state.spaceship.sprite_quad, &state.spaceship.render_quad);
-    }
-    // Render projectiles
-    for(size_t i = 0; i < state.projectile_count; ++i) {
-        projectile_t* projectile = &state.projectiles[i];
-        SDL_RenderCopy(state.renderer, state.projectile_texture, projectile->sprite_quad, &projectile->render_quad);
-    }
-    // Render enemies
-    for(size_t i = 0; i < state.enemy_count; ++i) {
-        enemy_t* enemy = &state.enemies[i];
-        SDL_RenderCopy(state.renderer, state.small_enemy_texture, enemy->sprite_quad, &enemy->render_quad);
+    // Every sprite is queued in layering order. They all share the atlas texture, so the whole frame is drawn with a single submission.
+    // Each sprite is drawn between its positions at the last two simulation steps, according to alpha.
+    sprite_batch_t* batch = &state.sprite_batch;
+    for(size_t i = 0; i < snapshot->count; ++i) {
+        const render_sprite_t* sprite = &snapshot->sprites[i];
+        SDL_FRect render_quad = sprite->render_quad;
+        render_quad.x = sprite->prev_x + (render_quad.x - sprite->prev_x) * alpha;
+        render_quad.y = sprite->prev_y + (render_quad.y - sprite->prev_y) * alpha;
+        sprite_batch_add(batch, state.atlas_texture, &sprite->sprite_quad, &render_quad);
     }
-    // Render explosions
-    for(size_t i = 0; i < state.explosions_count; ++i) {
-        explosion_t* explosion = &state.explosions[i];
-        SDL_RenderCopy(state.renderer, state.explosion_texture, explosion->sprite_quad, &explosion->render_quad);
+    sprite_batch_flush(batch);
+}
+
+void capture_frame(const uint32_t frame, const bool wait)
+{
+    uint64_t phase_start = SDL_GetPerformanceCounter();
+
+    // Only frames rendered into a surface are captured, so they are copied straight out of it
+    SDL_Surface* target = frame_capture_begin(&state.capture, wait);
+    if(target != NULL) {
+        for(int y = 0; y < SCREEN_HEIGHT; ++y) {
+            memcpy((uint8_t*)target->pixels + y * target->pitch, (const uint8_t*)state.render_target->pixels + y * state.render_target->pitch, SCREEN_WIDTH * sizeof(uint32_t));
+        }
+        frame_capture_submit(&state.capture, frame);
     }
 
-    SDL_RenderPresent(state.renderer);
+    end_phase(PHASE_CAPTURE, &phase_start);
 }
 
-SDL_Texture* load_texture(const char* const filename)
+void finish_capture()
 {
-    SDL_Surface* surface = IMG_Load(filename);
-    if(surface == NULL) {
-        fprintf(stderr, "Failed to load image from: \"%s\": %s\n", filename, IMG_GetError());
-        exit(EXIT_FAILURE);
+    if(state.capturing) {
+        frame_capture_destroy(&state.capture);
+        state.capturing = false;
+        printf("Captured %u frames to: \"%s\" (%u dropped, %u failed)\n", state.capture.num_written, state.capture.directory, state.capture.num_dropped, state.capture.num_failed);
     }
+}
 
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(state.renderer, surface);
+SDL_Texture* load_atlas_texture()
+{
+    // The pack's pixels are already in the texture's format, so they are uploaded straight from the mapping
+    const asset_pack_header_t* header = state.assets.header;
+    SDL_Texture* texture = SDL_CreateTexture(state.renderer, header->pixel_format, SDL_TEXTUREACCESS_STATIC, header->width, header->height);
     if(texture == NULL) {
         fprintf(stderr, "SDL texture could not be created: %s\n", SDL_GetError());
         exit(EXIT_FAILURE);
     }
-
-    SDL_FreeSurface(surface);
+    if(SDL_UpdateTexture(texture, NULL, state.assets.pixels, header->pitch) < 0) {
+        fprintf(stderr, "SDL texture could not be updated: %s\n", SDL_GetError());
+        exit(EXIT_FAILURE);
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
 
     return texture;
 }
 
-void spawn_projectile()
+void init_cpu_renderer(const options_t* const options)
 {
-    if(state.projectile_count < MAX_NUM_PROJECTILES) {
-        projectile_t* projectile = &state.projectiles[state.projectile_count++];
-
-        projectile->position.x = state.spaceship.position.x;
-        projectile->position.y = state.spaceship.position.y + state.spaceship.render_quad.h / 2;
+    // The renderer samples the mapped atlas directly, so it must already be in the framebuffer's format
+    const asset_pack_header_t* header = state.assets.header;
+    if(header->pixel_format != SDL_PIXELFORMAT_ARGB8888) {
+        fprintf(stderr, "The CPU renderer needs an ARGB8888 asset pack, not %s\n", SDL_GetPixelFormatName(header->pixel_format));
+        exit(EXIT_FAILURE);
+    }
 
-        projectile->velocity.x = 0;
-        projectile->velocity.y = -PROJECTILE_VELOCITY_PPS;
+    if(state.window != NULL) {
+        state.render_target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+        if(state.render_target == NULL) {
+            fprintf(stderr, "SDL render target could not be created: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
 
-        projectile->sprite_quad = &projectile_sprite_quads[PROJECTILE_1];
-        projectile->sprite_scaling = 2;
+        state.framebuffer_texture = SDL_CreateTexture(state.renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+        if(state.framebuffer_texture == NULL) {
+            fprintf(stderr, "SDL framebuffer texture could not be created: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
+    }
 
-        projectile->render_quad.w = projectile->sprite_quad->w * projectile->sprite_scaling;
-        projectile->render_quad.h = projectile->sprite_quad->h * projectile->sprite_scaling;
-        projectile->render_quad.x = projectile->position.x - projectile->render_quad.w / 2;
-        projectile->render_quad.y = projectile->position.y - projectile->render_quad.h / 2;
+    worker_pool_init(&state.render_workers, options->num_threads);
+    cpu_renderer_init(&state.cpu_renderer, SCREEN_WIDTH, SCREEN_HEIGHT, state.assets.pixels, header->width, header->height, header->pitch, &state.render_workers);
+}
 
-        projectile->num_animation_frames = 2;
-        projectile->animation_idx = 0;
-        projectile->num_rendered_frames_per_animation_frame = 4;
-        projectile->rendered_frame_idx = 0;
+bool poll_events()
+{
+    // Input is passed on to the simulation, stamped with when it was polled so that its latency can be measured
+    bool running = true;
+    SDL_Event event;
+    while(SDL_PollEvent(&event)) {
+        if(event.type == SDL_QUIT) {
+            running = false;
+        }
+        else if(event.type == SDL_KEYDOWN && event.key.keysym.sym == TRACE_HOTKEY) {
+            TRACE_WRITE(trace_filename);
+        }
+        else if(event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+            if(input_queue_push(&state.input_queue, &event)) {
+                state.input_poll_times[state.num_inputs_polled % INPUT_LATENCY_HISTORY] = SDL_GetPerformanceCounter();
+                ++state.num_inputs_polled;
+            }
+        }
     }
+    return running;
 }
 
-void spawn_enemy()
+void poll_events_until(const uint64_t deadline, bool* const running)
 {
-    if(state.enemy_count < MAX_NUM_ENEMIES) {
-        enemy_t* enemy = &state.enemies[state.enemy_count++];
-
-        enemy->sprite_quad = &small_enemy_sprite_quads[SMALL_ENEMY_1];
-        enemy->sprite_scaling = 2;
-
-        enemy->render_quad.w = enemy->sprite_quad->w * enemy->sprite_scaling;
-        enemy->render_quad.h = enemy->sprite_quad->h * enemy->sprite_scaling;
+    // Events keep being polled while waiting, so that the time they arrived is still measured closely
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t now = SDL_GetPerformanceCounter();
+    while(now < deadline && *running) {
+        *running = poll_events();
+        const uint64_t remaining_ms = (deadline - now) * 1000 / frequency;
+        SDL_Delay(remaining_ms > 1 ? 1 : 0);
+        now = SDL_GetPerformanceCounter();
+    }
+}
 
-        const int32_t min_x = enemy->render_quad.w / 2;
-        const int32_t max_x = SCREEN_WIDTH - enemy->render_quad.w / 2;
+void sync_presented_frame()
+{
+    // Reading a pixel back cannot complete until the renderer has finished every frame submitted so far, so no more
+    // frames can queue up behind the one being presented
+    uint32_t pixel = 0;
+    const SDL_Rect rect = { .x = 0, .y = 0, .w = 1, .h = 1 };
+    SDL_RenderReadPixels(state.renderer, &rect, SDL_PIXELFORMAT_ARGB8888, &pixel, sizeof(pixel));
+}
 
-        const int32_t random_var = rand();
-        const int32_t x_pos = min_x + (float)random_var / RAND_MAX * (max_x - min_x);
+void record_input_latency(const render_snapshot_t* const snapshot)
+{
+    const uint64_t now = SDL_GetPerformanceCounter();
+    const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    for(; state.num_inputs_presented != snapshot->num_inputs; ++state.num_inputs_presented) {
+        if(state.num_inputs_polled - state.num_inputs_presented <= INPUT_LATENCY_HISTORY) {
+            const uint64_t poll_time = state.input_poll_times[state.num_inputs_presented % INPUT_LATENCY_HISTORY];
+            sample_stats_add(&state.input_latency_ms, (double)(now - poll_time) * ms_per_tick);
+        }
+    }
+}
 
-        enemy->position.x = x_pos;
-        enemy->position.y = 0;
+void report_input_latency(const options_t* const options)
+{
+    sample_stats_t* latency = &state.input_latency_ms;
+    if(latency->num_samples == 0) {
+        return;
+    }
 
-        enemy->velocity.x = 0;
-        enemy->velocity.y = ENEMY_VELOCITY_PPS;
+    printf("Input latency over %llu events%s: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+        (unsigned long long)latency->num_samples,
+        options->low_latency ? " (low-latency mode)" : "",
+        sample_stats_percentile(latency, 50.0),
+        sample_stats_percentile(latency, 90.0),
+        sample_stats_percentile(latency, 99.0),
+        sample_stats_max(latency));
+}
 
-        enemy->render_quad.x = enemy->position.x - enemy->render_quad.w / 2;
-        enemy->render_quad.y = enemy->position.y - enemy->render_quad.h / 2;
+void report_frame_pacing(const double cpu_s, const double wall_s)
+{
+    sample_stats_t* frame_time = &state.pacer.frame_time_ms;
+    if(frame_time->num_samples == 0) {
+        return;
+    }
 
-        enemy->num_animation_frames = 2;
-        enemy->animation_idx = 0;
-        enemy->num_rendered_frames_per_animation_frame = 4;
-        enemy->rendered_frame_idx = 0;
+    // Jitter is the standard deviation of the time between presents. CPU time covers every thread, so it can exceed
+    // one core.
+    const double mean_ms = sample_stats_mean(frame_time);
+    printf("Frame pacing (%s", frame_pacing_mode_names[state.pacer.mode]);
+    if(state.pacer.mode == FRAME_PACING_FIXED) {
+        printf(" at %u fps", state.pacer.target_fps);
     }
+    printf("): %llu frames, mean %.2f ms (%.1f fps), jitter %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms, CPU %.0f%%\n",
+        (unsigned long long)frame_time->num_samples,
+        mean_ms,
+        mean_ms > 0.0 ? 1000.0 / mean_ms : 0.0,
+        sample_stats_stddev(frame_time),
+        sample_stats_percentile(frame_time, 50.0),
+        sample_stats_percentile(frame_time, 99.0),
+        sample_stats_max(frame_time),
+        wall_s > 0.0 ? cpu_s * 100.0 / wall_s : 0.0);
 }
 
-void spawn_explosion(vector_t p)
+// ============================================================================
+// Headless benchmark
+// ============================================================================
+
+bool run_benchmark(const options_t* const options)
 {
-    if(state.explosions_count < MAX_NUM_EXPLOSIONS) {
-        explosion_t* explosion = &state.explosions[state.explosions_count++];
+    // A replay is fast-forwarded through every recorded step, driven only by its recorded input. Otherwise each
+    // scenario supplies the input.
+    const bool replaying = state.replay_mode == REPLAY_MODE_PLAYBACK;
+    const uint32_t num_frames = replaying ? state.replay.num_steps : options->num_frames;
+
+    memset(phase_ticks, 0, sizeof(phase_ticks));
+    uint64_t min_frame_ticks = UINT64_MAX;
+    uint64_t max_frame_ticks = 0;
+    uint64_t total_entities = 0;
+    uint32_t num_cpu_frames_mismatched = 0;
+    uint64_t num_cpu_pixels_mismatched = 0;
+    render_mismatch_t first_mismatch;
+
+    // When verifying rewinding, every step's checksum is kept to compare with what it rewinds to, indexed by step
+    uint64_t* checksums = NULL;
+    if(options->verify_rewind) {
+        checksums = calloc((size_t)num_frames + 1, sizeof(uint64_t));
+        if(checksums == NULL) {
+            fprintf(stderr, "Failed to allocate checksums for %u steps\n", num_frames);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const uint64_t start = SDL_GetPerformanceCounter();
+    for(uint32_t frame = 0; frame < num_frames; ++frame) {
+        const uint64_t frame_start = SDL_GetPerformanceCounter();
+        TRACE_BEGIN(trace_frame_start);
+
+        if(!replaying) {
+            state.input = apply_scenario(options, &state.sim, frame);
+        }
+
+        step_simulation();
+        if(checksums != NULL) {
+            checksums[state.sim.step] = simulation_checksum(&state.sim);
+        }
 
-        explosion->position = p;
+        if(options->headless_render) {
+            capture_snapshot(render_snapshot_buffer_begin_write(&state.snapshots), &state.sim, frame_start);
+            render_snapshot_buffer_publish(&state.snapshots);
+            render(render_snapshot_buffer_read(&state.snapshots), 1.0F);
+        }
+        if(state.reference_target != NULL) {
+            const uint64_t num_mismatched = verify_cpu_frame(render_snapshot_buffer_read(&state.snapshots), frame, num_cpu_frames_mismatched == 0 ? &first_mismatch : NULL);
+            num_cpu_frames_mismatched += num_mismatched > 0 ? 1 : 0;
+            num_cpu_pixels_mismatched += num_mismatched;
+        }
+        if(state.capturing) {
+            // There is no display to keep up with, so every frame is kept, even if the writer falls behind
+            capture_frame(frame, true);
+        }
 
-        explosion->velocity.x = 0;
-        explosion->velocity.y = 0;
+        TRACE_END(trace_frame_start, "frame");
+        const uint64_t frame_ticks = SDL_GetPerformanceCounter() - frame_start;
+        min_frame_ticks = frame_ticks < min_frame_ticks ? frame_ticks : min_frame_ticks;
+        max_frame_ticks = frame_ticks > max_frame_ticks ? frame_ticks : max_frame_ticks;
+        total_entities += simulation_num_entities(&state.sim);
+    }
+    const uint64_t total_ticks = SDL_GetPerformanceCounter() - start;
 
-        explosion->sprite_quad = &explosion_sprite_quads[EXPLOSION_1];
-        explosion->sprite_scaling = 2;
+    report_benchmark(options, num_frames, total_ticks, min_frame_ticks, max_frame_ticks, total_entities);
 
-        explosion->render_quad.w = explosion->sprite_quad->w * explosion->sprite_scaling;
-        explosion->render_quad.h = explosion->sprite_quad->h * explosion->sprite_scaling;
-        explosion->render_quad.x = explosion->position.x - explosion->render_quad.w / 2;
-        explosion->render_quad.y = explosion->position.y - explosion->render_quad.h / 2;
+    if(checksums != NULL) {
+        verify_rewind(options, checksums);
+        free(checksums);
+    }
 
-        explosion->num_animation_frames = 2;
-        explosion->animation_idx = 0;
-        explosion->num_rendered_frames_per_animation_frame = 4;
-        explosion->rendered_frame_idx = 0;
+    if(state.reference_target != NULL) {
+        printf("renderer:     %u of %u frames match SDL's software renderer (%llu pixels differ)\n", num_frames - num_cpu_frames_mismatched, num_frames, (unsigned long long)num_cpu_pixels_mismatched);
+        if(num_cpu_frames_mismatched > 0) {
+            printf("renderer:     frame %u first differs at (%d, %d), 0x%08X rather than SDL's 0x%08X\n", first_mismatch.frame, first_mismatch.x, first_mismatch.y, first_mismatch.cpu_pixel, first_mismatch.sdl_pixel);
+        }
     }
+    return num_cpu_frames_mismatched == 0;
 }
 
-bool is_collided(const SDL_Rect* const a, const SDL_Rect* const b)
+simulation_input_t apply_scenario(const options_t* const options, simulation_t* const sim, const uint32_t frame)
 {
-    const vector_t a_top_l = {
-        .x = a->x,
-        .y = a->y
-    };
-    const vector_t a_bottom_l = {
-        .x = a->x,
-        .y = a->y + a->h
-    };
-    const vector_t a_top_r = {
-        .x = a->x + a->w,
-        .y = a->y
-    };
-    const vector_t a_bottom_r = {
-        .x = a->x + a->w,
-        .y = a->y + a->h
-    };
+    simulation_top_up(sim, options->min_enemies, options->min_projectiles, options->min_explosions, options->min_bullets);
+
+    // The spaceship fires constantly, sweeping from side to side and changing direction every second of simulated time
+    const uint32_t simulated_s = (uint32_t)(((int64_t)frame * sim->config.time_step_s) >> FIXED_SHIFT);
+    return SIMULATION_INPUT_FIRE | (simulated_s % 2 == 0 ? SIMULATION_INPUT_RIGHT : SIMULATION_INPUT_LEFT);
+}
+
+// Draws the frame again with SDL's software renderer, and returns how many of its pixels differ from the CPU renderer's,
+// recording where the first of them is if given somewhere to
+uint64_t verify_cpu_frame(const render_snapshot_t* const snapshot, const uint32_t frame, render_mismatch_t* const first)
+{
+    draw_sprites(snapshot, 1.0F);
+    SDL_RenderFlush(state.renderer);
+
+    uint64_t num_mismatched = 0;
+    for(int y = 0; y < SCREEN_HEIGHT; ++y) {
+        const uint32_t* cpu_row = (const uint32_t*)((const uint8_t*)state.render_target->pixels + y * state.render_target->pitch);
+        const uint32_t* sdl_row = (const uint32_t*)((const uint8_t*)state.reference_target->pixels + y * state.reference_target->pitch);
+        for(int x = 0; x < SCREEN_WIDTH; ++x) {
+            if(cpu_row[x] == sdl_row[x]) {
+                continue;
+            }
+            if(num_mismatched == 0 && first != NULL) {
+                *first = (render_mismatch_t){ .frame = frame, .x = x, .y = y, .cpu_pixel = cpu_row[x], .sdl_pixel = sdl_row[x] };
+            }
+            ++num_mismatched;
+        }
+    }
+    return num_mismatched;
+}
 
-    const bool collision_detected = is_contained(&a_top_l, b) || is_contained(&a_bottom_l, b) || is_contained(&a_top_r, b) || is_contained(&a_bottom_r, b);
+void verify_rewind(const options_t* const options, const uint64_t* const checksums)
+{
+    uint32_t oldest;
+    uint32_t newest;
+    if(!rewind_range(&state.rewind, &oldest, &newest)) {
+        printf("rewind:       nothing retained to verify\n");
+        return;
+    }
 
-    return collision_detected;
+    // Every retained step must rewind to exactly the state it was recorded in
+    uint32_t num_mismatched = 0;
+    const uint64_t start = SDL_GetPerformanceCounter();
+    for(uint32_t step = oldest; step <= newest; ++step) {
+        if(!rewind_seek(&state.rewind, step, &state.rewind_sim) || simulation_checksum(&state.rewind_sim) != checksums[step]) {
+            ++num_mismatched;
+        }
+    }
+    const double seek_us = (double)(SDL_GetPerformanceCounter() - start) * 1e6 / (double)SDL_GetPerformanceFrequency() / (double)(newest - oldest + 1);
+    printf("rewind:       %u of %u retained steps match (mean seek %.1f us)\n", newest - oldest + 1 - num_mismatched, newest - oldest + 1, seek_us);
+
+    // The checksum leaves out what only shapes later steps, such as where entities were a step before, so the oldest
+    // step is also played forward again, which must end up in the same final state. A replay's input cannot be fed in
+    // again from the middle, so only scenarios are played forward.
+    if(state.replay_mode != REPLAY_MODE_PLAYBACK) {
+        rewind_seek(&state.rewind, oldest, &state.rewind_sim);
+        while(state.rewind_sim.step < newest) {
+            simulation_step(&state.rewind_sim, apply_scenario(options, &state.rewind_sim, state.rewind_sim.step));
+        }
+        const bool matched = simulation_checksum(&state.rewind_sim) == checksums[newest];
+        printf("rewind:       replaying from step %u %s\n", oldest, matched ? "reaches the same final state" : "reaches a different final state");
+    }
 }
 
-bool is_contained(const vector_t* const p, const SDL_Rect* const r)
+void report_benchmark(const options_t* const options, const uint32_t num_frames, const uint64_t total_ticks, const uint64_t min_frame_ticks, const uint64_t max_frame_ticks, const uint64_t total_entities)
 {
-    const bool result = p->x >= r->x && p->x <= (r->x + r->w) && p->y >= r->y && p->y <= (r->y + r->h);
-    return result;
+    const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    const double total_ms = (double)total_ticks * ms_per_tick;
+    const double frames = (double)num_frames;
+
+    if(options->replay_filename != NULL) {
+        printf("replay:       %s\n", options->replay_filename);
+    }
+    else {
+        printf("scenario:     %s\n", scenario_names[options->scenario]);
+    }
+    printf("frames:       %u (dt %.3f ms, seed %u)\n", num_frames, fixed_to_float(state.sim.config.time_step_s) * 1000.0F, state.sim.config.seed);
+    printf("collisions:   %s\n", options->collision_mode == COLLISION_MODE_BRUTE_FORCE ? "brute force" : "broadphase");
+    printf("threads:      %zu (parallel from %zu entities)\n", options->num_threads, options->parallel_threshold);
+    printf("update:       %s\n", options->separate_passes ? "separate integrate and cull passes" : "single integrate and cull sweep, unless split between threads");
+    printf("render:       %s\n", !options->headless_render ? "off" : state.cpu_render ? "offscreen, CPU renderer" : "offscreen");
+    printf("entities:     %.1f live per frame\n", (double)total_entities / frames);
+    printf("wall time:    %.3f ms\n", total_ms);
+    printf("frame rate:   %.1f frames/s\n", frames * 1000.0 / total_ms);
+    printf("frame time:   min %.3f ms, mean %.3f ms, max %.3f ms\n", (double)min_frame_ticks * ms_per_tick, total_ms / frames, (double)max_frame_ticks * ms_per_tick);
+    printf("\n");
+    printf("%-12s %12s %16s %8s\n", "phase", "total ms", "mean us/frame", "share");
+    for(int phase = 0; phase < PHASES_TOTAL; ++phase) {
+        const double phase_ms = (double)phase_ticks[phase] * ms_per_tick;
+        printf("%-12s %12.3f %16.3f %7.1f%%\n", phase_names[phase], phase_ms, phase_ms * 1000.0 / frames, phase_ms * 100.0 / total_ms);
+    }
+
+    // How far each pool had to grow, and the memory it holds as a result
+    const char* pool_names[] = { "projectiles", "enemies", "explosions" };
+    const entity_pool_t* pools[] = { &state.sim.projectiles, &state.sim.enemies, &state.sim.explosions };
+    printf("\n");
+    printf("%-12s %12s %16s %8s\n", "pool", "high water", "capacity", "KiB");
+    for(size_t p = 0; p < sizeof(pools) / sizeof(pools[0]); ++p) {
+        printf("%-12s %12zu %16zu %8.1f\n", pool_names[p], pools[p]->high_water, pools[p]->capacity, (double)pools[p]->storage_size / 1024.0);
+    }
+    printf("%-12s %12zu %16zu %8.1f\n", "bullets", state.sim.bullets.high_water, state.sim.bullets.capacity, (double)state.sim.bullets.storage_size / 1024.0);
+
+    // How far back the rewind buffer reaches, and how compactly it holds each step
+    uint32_t oldest;
+    uint32_t newest;
+    if(state.rewind_enabled && rewind_range(&state.rewind, &oldest, &newest)) {
+        const rewind_buffer_t* rewind = &state.rewind;
+        printf("\n");
+        printf("rewind:       steps %u to %u retained in %.1f KiB of %zu MiB\n", oldest, newest, (double)rewind_retained_size(rewind) / 1024.0, options->rewind_budget >> 20);
+        printf("recorded:     %llu steps, %llu keyframes, mean %.1f bytes/step", (unsigned long long)rewind->num_recorded, (unsigned long long)rewind->num_keyframes, (double)rewind->total_recorded_size / (double)rewind->num_recorded);
+        printf(rewind->num_dropped > 0 ? ", %llu too large to keep\n" : "\n", (unsigned long long)rewind->num_dropped);
+    }
 }
 
 // ============================================================================
 // Main entry point
 // ============================================================================
 
-int main()
+int main(int argc, char* argv[])
 {
-    init();
+    options_t options;
+    parse_options(argc, argv, &options);
 
-    bool running = true;
-    SDL_Event event;
+    init(&options);
 
-    while(running) {
-        // Poll for events
-        while(SDL_PollEvent(&event)) {
-            if(event.type == SDL_QUIT) {
-                running = false;
-            }
-            else {
-                handle_event(&event);
+    if(options.headless) {
+        const bool verified = run_benchmark(&options);
+        finish_replay(&options);
+        finish_capture();
+        destroy();
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // The simulation normally runs on its own thread, and publishes a snapshot of every step it completes for this thread
+    // to render. In low-latency mode this thread runs it instead, straight after polling input as late as it can.
+    atomic_store(&simulation_running, true);
+    SDL_Thread* simulation_thread = NULL;
+    if(options.low_latency) {
+        state.last_time = SDL_GetPerformanceCounter();
+    }
+    else {
+        simulation_thread = SDL_CreateThread(run_simulation, "simulation", NULL);
+        if(simulation_thread == NULL) {
+            fprintf(stderr, "SDL simulation thread could not be created: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    const uint64_t step_ticks = frequency / SIMULATION_STEP_RATE_HZ;
+    SDL_DisplayMode display_mode;
+    const int display = SDL_GetWindowDisplayIndex(state.window);
+    const int refresh_rate_hz = display >= 0 && SDL_GetCurrentDisplayMode(display, &display_mode) == 0 && display_mode.refresh_rate > 0 ? display_mode.refresh_rate : DEFAULT_REFRESH_RATE_HZ;
+    const uint64_t refresh_ticks = frequency / (uint64_t)refresh_rate_hz;
+    const uint64_t margin_ticks = (uint64_t)(LOW_LATENCY_MARGIN_S * (double)frequency);
+    // The longest recent time from polling input to presenting, decaying slowly so that one slow frame is not forgotten
+    uint64_t work_ticks = 0;
+    const clock_t cpu_start = clock();
+    const uint64_t wall_start = SDL_GetPerformanceCounter();
+    bool running = true;
+    uint32_t frame = 0;
+
+    while(running && atomic_load(&simulation_running)) {
+        TRACE_BEGIN(frame_start);
+
+        // In low-latency mode, wait until there is only just time left to simulate and render before the next frame is
+        // due, which is either when the pacer schedules it or one refresh after the last
+        if(options.low_latency && state.pacer.mode != FRAME_PACING_UNCAPPED) {
+            const uint64_t next_frame_time = frame_pacer_next_frame_time(&state.pacer);
+            const uint64_t deadline = next_frame_time != 0 ? next_frame_time : state.pacer.last_present_time + refresh_ticks;
+            const uint64_t lead_ticks = work_ticks + margin_ticks;
+            if(deadline > lead_ticks) {
+                poll_events_until(deadline - lead_ticks, &running);
             }
         }
+        const uint64_t work_start = SDL_GetPerformanceCounter();
+
+        running = poll_events() && running;
+        if(options.low_latency) {
+            advance_simulation();
+            running = running && !is_replay_finished();
+        }
 
-        // Update game state
-        update_state();
+        // Render the latest step, blending it with the one before by how far real time has run past it
+        const render_snapshot_t* snapshot = render_snapshot_buffer_read(&state.snapshots);
+        const float alpha = (float)(SDL_GetPerformanceCounter() - snapshot->step_time) / (float)step_ticks;
+        render(snapshot, alpha < 1.0F ? alpha : 1.0F);
 
-        // Render
-        render();
+        // Frames are only ever dropped from the capture, never waited for, so the writer cannot hold up presenting
+        if(state.capturing) {
+            capture_frame(frame, false);
+        }
+        ++frame;
+
+        uint64_t phase_start = SDL_GetPerformanceCounter();
+        const uint64_t frame_work_ticks = phase_start - work_start;
+        work_ticks = frame_work_ticks > work_ticks ? frame_work_ticks : work_ticks - work_ticks / 32;
+        frame_pacer_wait(&state.pacer);
+        SDL_RenderPresent(state.renderer);
+        if(options.low_latency) {
+            sync_presented_frame();
+        }
+        frame_pacer_presented(&state.pacer);
+        end_phase(PHASE_PRESENT, &phase_start);
+
+        record_input_latency(snapshot);
+
+        TRACE_END(frame_start, "frame");
     }
 
+    const double wall_s = (double)(SDL_GetPerformanceCounter() - wall_start) / (double)frequency;
+    const double cpu_s = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    atomic_store(&simulation_running, false);
+    SDL_WaitThread(simulation_thread, NULL);
+
+    report_frame_pacing(cpu_s, wall_s);
+    report_input_latency(&options);
+    finish_replay(&options);
+    finish_capture();
     destroy();
 
     return EXIT_SUCCESS;
@@ -0,0 +1,228 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "asset_pack.h"
+#include "fixed.h"
+#include "rng.h"
+#include "simulation.h"
+#include "simulation_batch.h"
+#include "worker_pool.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define DEFAULT_NUM_INSTANCES 1024
+#define DEFAULT_NUM_STEPS 600
+#define DEFAULT_TIME_STEP_S (1.0F / 60.0F)
+#define DEFAULT_SEED 1
+#define MAX_NUM_THREADS 256
+
+// Each instance's player holds a random combination of buttons for a random number of steps, up to this many
+#define MAX_INPUT_HOLD_STEPS 30
+
+typedef struct {
+    size_t num_instances;
+    uint32_t num_steps;
+    size_t num_threads;
+    float time_delta_s;
+    uint32_t seed;
+    collision_mode_t collision_mode;
+} options_t;
+
+// Stands in for whatever drives the instances, such as an agent being trained
+typedef struct {
+    rng_t* rngs;
+    simulation_input_t* inputs;
+    uint32_t* hold_steps;
+} players_t;
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+void parse_options(int argc, char* argv[], options_t* options);
+void init_players(players_t* players, size_t num_instances, uint32_t seed);
+void destroy_players(players_t* players);
+void update_players(players_t* players, size_t num_instances);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void parse_options(const int argc, char* argv[], options_t* const options)
+{
+    const long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    options->num_instances = DEFAULT_NUM_INSTANCES;
+    options->num_steps = DEFAULT_NUM_STEPS;
+    options->num_threads = num_cpus < 1 ? 1 : num_cpus > MAX_NUM_THREADS ? MAX_NUM_THREADS : (size_t)num_cpus;
+    options->time_delta_s = DEFAULT_TIME_STEP_S;
+    options->seed = DEFAULT_SEED;
+    options->collision_mode = COLLISION_MODE_BROADPHASE;
+
+    bool valid = true;
+    for(int i = 1; i < argc && valid; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        char* end = NULL;
+
+        if(strcmp(arg, "--instances") == 0 && value != NULL) {
+            options->num_instances = strtoul(value, &end, 10);
+            valid = *end == '\0' && options->num_instances > 0;
+            ++i;
+        }
+        else if(strcmp(arg, "--steps") == 0 && value != NULL) {
+            options->num_steps = (uint32_t)strtoul(value, &end, 10);
+            valid = *end == '\0' && options->num_steps > 0;
+            ++i;
+        }
+        else if(strcmp(arg, "--threads") == 0 && value != NULL) {
+            options->num_threads = strtoul(value, &end, 10);
+            valid = *end == '\0' && options->num_threads > 0 && options->num_threads <= MAX_NUM_THREADS;
+            ++i;
+        }
+        else if(strcmp(arg, "--dt") == 0 && value != NULL) {
+            options->time_delta_s = strtof(value, &end);
+            valid = *end == '\0' && options->time_delta_s > 0.0F;
+            ++i;
+        }
+        else if(strcmp(arg, "--seed") == 0 && value != NULL) {
+            options->seed = (uint32_t)strtoul(value, &end, 10);
+            valid = *end == '\0';
+            ++i;
+        }
+        else if(strcmp(arg, "--brute-force-collisions") == 0) {
+            options->collision_mode = COLLISION_MODE_BRUTE_FORCE;
+        }
+        else {
+            valid = false;
+        }
+
+        if(!valid) {
+            fprintf(stderr, "Invalid argument: \"%s\"\n", arg);
+        }
+    }
+
+    if(!valid) {
+        fprintf(stderr, "Usage: %s [--instances N] [--steps N] [--threads N] [--dt SECONDS] [--seed N] [--brute-force-collisions]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void init_players(players_t* const players, const size_t num_instances, const uint32_t seed)
+{
+    players->rngs = malloc(num_instances * sizeof(rng_t));
+    players->inputs = calloc(num_instances, sizeof(simulation_input_t));
+    players->hold_steps = calloc(num_instances, sizeof(uint32_t));
+    if(players->rngs == NULL || players->inputs == NULL || players->hold_steps == NULL) {
+        fprintf(stderr, "Failed to allocate the input for %zu instances\n", num_instances);
+        exit(EXIT_FAILURE);
+    }
+
+    // Every player has its own stream, so that the input each instance gets does not depend on any other
+    rng_t seed_rng;
+    rng_init(&seed_rng, seed);
+    for(size_t i = 0; i < num_instances; ++i) {
+        players->rngs[i] = rng_split(&seed_rng);
+    }
+}
+
+void destroy_players(players_t* const players)
+{
+    free(players->hold_steps);
+    free(players->inputs);
+    free(players->rngs);
+}
+
+void update_players(players_t* const players, const size_t num_instances)
+{
+    const uint32_t all_buttons = SIMULATION_INPUT_UP | SIMULATION_INPUT_DOWN | SIMULATION_INPUT_LEFT | SIMULATION_INPUT_RIGHT | SIMULATION_INPUT_FIRE;
+    for(size_t i = 0; i < num_instances; ++i) {
+        if(players->hold_steps[i] == 0) {
+            players->inputs[i] = rng_bounded(&players->rngs[i], all_buttons + 1);
+            players->hold_steps[i] = (uint32_t)rng_range(&players->rngs[i], 1, MAX_INPUT_HOLD_STEPS);
+        }
+        --players->hold_steps[i];
+    }
+}
+
+// ============================================================================
+// Main entry point
+// ============================================================================
+
+int main(int argc, char* argv[])
+{
+    options_t options;
+    parse_options(argc, argv, &options);
+
+    simulation_sprites_t sprites;
+    simulation_sprites_open(&sprites, ASSET_PACK_FILENAME);
+
+    const simulation_config_t config = {
+        .sprites = &sprites,
+        .seed = options.seed,
+        .time_step_s = fixed_from_float(options.time_delta_s),
+        .collision_mode = options.collision_mode,
+        .invulnerable = false,
+        .workers = NULL,
+        .parallel_threshold = SIZE_MAX,
+        .separate_passes = false,
+        .clock = NULL
+    };
+
+    worker_pool_t workers;
+    worker_pool_init(&workers, options.num_threads);
+    simulation_batch_t batch;
+    simulation_batch_init(&batch, options.num_instances, &config, &workers);
+    players_t players;
+    init_players(&players, options.num_instances, options.seed);
+
+    // Only stepping the batch is timed, since the players stand in for work done elsewhere
+    uint64_t total_ns = 0;
+    uint64_t total_entities = 0;
+    for(uint32_t step = 0; step < options.num_steps; ++step) {
+        update_players(&players, options.num_instances);
+
+        const uint64_t start = simulation_clock_ns();
+        simulation_batch_step(&batch, players.inputs);
+        total_ns += simulation_clock_ns() - start;
+
+        for(size_t i = 0; i < batch.num_instances; ++i) {
+            total_entities += simulation_num_entities(&batch.instances[i]);
+        }
+    }
+
+    // Games are lost either before an instance restarts, or on its final step. The checksum covers every instance in
+    // order, so it only depends on the seed and the options that change the game, never on the thread count.
+    uint64_t num_games = 0;
+    uint64_t num_lost = 0;
+    uint64_t checksum = 14695981039346656037ULL;
+    for(size_t i = 0; i < batch.num_instances; ++i) {
+        num_games += batch.num_games[i];
+        num_lost += batch.num_games[i] - 1 + (batch.instances[i].game_over ? 1 : 0);
+        checksum = (checksum ^ simulation_checksum(&batch.instances[i])) * 1099511628211ULL;
+    }
+
+    const double total_steps = (double)options.num_instances * options.num_steps;
+    const double total_s = (double)total_ns / 1e9;
+    printf("instances:    %zu (dt %.3f ms, seed %u)\n", options.num_instances, fixed_to_float(config.time_step_s) * 1000.0F, options.seed);
+    printf("collisions:   %s\n", options.collision_mode == COLLISION_MODE_BRUTE_FORCE ? "brute force" : "broadphase");
+    printf("threads:      %zu\n", options.num_threads);
+    printf("steps:        %u per instance, %.0f in total\n", options.num_steps, total_steps);
+    printf("games:        %llu started, %llu lost\n", (unsigned long long)num_games, (unsigned long long)num_lost);
+    printf("entities:     %.1f live per instance per step\n", (double)total_entities / total_steps);
+    printf("wall time:    %.3f ms\n", total_s * 1000.0);
+    printf("throughput:   %.0f steps/s (%.0f per thread)\n", total_steps / total_s, total_steps / total_s / (double)options.num_threads);
+    printf("checksum:     %016llx\n", (unsigned long long)checksum);
+
+    destroy_players(&players);
+    simulation_batch_destroy(&batch);
+    worker_pool_destroy(&workers);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,506 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "asset_pack.h"
+#include "collision.h"
+#include "fixed.h"
+#include "rng.h"
+#include "sample_stats.h"
+#include "simulation.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define DEFAULT_MAX_ENTITIES 65536
+#define DEFAULT_NUM_WARMUPS 5
+#define DEFAULT_NUM_REPETITIONS 30
+#define DEFAULT_MAX_REPETITION_MS 20.0
+#define DEFAULT_TIME_STEP_S (1.0F / 60.0F)
+#define DEFAULT_SEED 1
+
+// Clustered entities are all placed within a square of this many pixels around the spaceship
+#define CLUSTER_SIZE 64
+
+// Enemies, projectiles and bullets are placed as if spawned up to this many steps ago, so that they do not all fire
+// or animate in step with each other
+#define MAX_AGE_STEPS 120
+
+typedef enum {
+    DISTRIBUTION_SPREAD,
+    DISTRIBUTION_CLUSTERED,
+    DISTRIBUTIONS_TOTAL
+} distribution_t;
+
+const char* distribution_names[DISTRIBUTIONS_TOTAL] = {
+    "spread",
+    "clustered"
+};
+
+typedef enum {
+    // One phase of a simulation step, timed by the simulation's own clock
+    MEASUREMENT_PHASE,
+    // Spawning the entities into empty pools
+    MEASUREMENT_TOP_UP,
+    // Looking up the animation frame every entity would be drawn with
+    MEASUREMENT_ANIMATIONS,
+    // Spawning entities one at a time into empty pools
+    MEASUREMENT_SPAWN,
+    // One narrow-phase test between each enemy and the projectile at the same index
+    MEASUREMENT_NARROW_PHASE
+} measurement_t;
+
+typedef enum {
+    NARROW_PHASE_IS_CONTAINED,
+    NARROW_PHASE_IS_COLLIDED,
+    NARROW_PHASE_IS_SEGMENT_INTERSECTING
+} narrow_phase_t;
+
+// A hot path of the simulation, and the pools it runs over. Each pool flagged
+// holds the number of entities being benchmarked, and the rest are kept empty.
+typedef struct {
+    const char* name;
+    measurement_t measurement;
+    int phase;
+    collision_mode_t collision_mode;
+    narrow_phase_t narrow_phase;
+    bool enemies;
+    bool projectiles;
+    bool explosions;
+    bool bullets;
+} kernel_t;
+
+const kernel_t kernels[] = {
+    // Integrating and culling enemies and bullets. Projectiles are swept exactly as enemies are, and are left out so
+    // that the collisions the rest of the step checks do not grow with the square of the count.
+    { .name = "positions", .measurement = MEASUREMENT_PHASE, .phase = SIMULATION_PHASE_POSITIONS, .enemies = true, .bullets = true },
+    // Spawning enemies, projectiles and volleys of bullets
+    { .name = "spawning", .measurement = MEASUREMENT_TOP_UP, .enemies = true, .projectiles = true, .bullets = true },
+    // Every enemy deciding whether to fire, and the volleys they fire
+    { .name = "firing", .measurement = MEASUREMENT_PHASE, .phase = SIMULATION_PHASE_SPAWNING, .enemies = true },
+    // Projectiles against enemies through the broadphase, and the spaceship against enemies
+    { .name = "collisions", .measurement = MEASUREMENT_PHASE, .phase = SIMULATION_PHASE_COLLISIONS, .collision_mode = COLLISION_MODE_BROADPHASE, .enemies = true, .projectiles = true },
+    // As above, testing every projectile against every enemy and the spaceship against every enemy
+    { .name = "collisions_brute_force", .measurement = MEASUREMENT_PHASE, .phase = SIMULATION_PHASE_COLLISIONS, .collision_mode = COLLISION_MODE_BRUTE_FORCE, .enemies = true, .projectiles = true },
+    // Scanning every bullet against the spaceship, and testing those near it exactly
+    { .name = "bullet_collisions", .measurement = MEASUREMENT_PHASE, .phase = SIMULATION_PHASE_COLLISIONS, .bullets = true },
+    // Removing explosions that have played through
+    { .name = "expiry", .measurement = MEASUREMENT_PHASE, .phase = SIMULATION_PHASE_EXPIRY, .explosions = true },
+    { .name = "animations", .measurement = MEASUREMENT_ANIMATIONS, .enemies = true, .projectiles = true, .explosions = true, .bullets = true },
+    // Each kind of entity spawned one at a time, as the game spawns them while it plays
+    { .name = "spawn_projectile", .measurement = MEASUREMENT_SPAWN, .projectiles = true },
+    { .name = "spawn_enemy", .measurement = MEASUREMENT_SPAWN, .enemies = true },
+    { .name = "spawn_explosion", .measurement = MEASUREMENT_SPAWN, .explosions = true },
+    // The narrow-phase tests without the broadphase or the rest of the step, each projectile's centre against its
+    // enemy's quad, its quad against the enemy's, and the path it swept over a step against the enemy's quad
+    { .name = "is_contained", .measurement = MEASUREMENT_NARROW_PHASE, .narrow_phase = NARROW_PHASE_IS_CONTAINED, .enemies = true, .projectiles = true },
+    { .name = "is_collided", .measurement = MEASUREMENT_NARROW_PHASE, .narrow_phase = NARROW_PHASE_IS_COLLIDED, .enemies = true, .projectiles = true },
+    { .name = "is_segment_intersecting", .measurement = MEASUREMENT_NARROW_PHASE, .narrow_phase = NARROW_PHASE_IS_SEGMENT_INTERSECTING, .enemies = true, .projectiles = true }
+};
+
+#define NUM_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+typedef struct {
+    size_t max_entities;
+    uint32_t num_warmups;
+    uint32_t num_repetitions;
+    double max_repetition_ms;
+    float time_delta_s;
+    uint32_t seed;
+    // The kernel to run, or NULL for every one
+    const char* kernel;
+} options_t;
+
+// The pairs the narrow-phase tests are timed over, gathered from the pools beforehand, so that only the tests are timed
+typedef struct {
+    SDL_Rect* enemy_quads;
+    SDL_Rect* projectile_quads;
+    SDL_Point* projectile_centres;
+    SDL_Point* projectile_starts;
+} pairs_t;
+
+// Keeps the animation frames and test results that are computed from being optimised away
+volatile int32_t result_sink;
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+void parse_options(int argc, char* argv[], options_t* options);
+void run_kernel(const options_t* options, const simulation_sprites_t* sprites, const kernel_t* kernel, distribution_t distribution);
+void prepare_pools(simulation_t* sim, rng_t* rng, const kernel_t* kernel, distribution_t distribution, size_t count);
+void place_entities(entity_pool_t* pool, rng_t* rng, const SDL_Rect* region, uint32_t step, uint32_t max_age_steps);
+void place_bullets(bullet_pool_t* pool, rng_t* rng, const SDL_Rect* region, uint32_t step);
+void gather_pairs(const simulation_t* sim, pairs_t* pairs);
+uint64_t measure(simulation_t* sim, rng_t* rng, const kernel_t* kernel, distribution_t distribution, size_t count, pairs_t* pairs, size_t* num_entities);
+uint64_t measure_narrow_phase(narrow_phase_t narrow_phase, const pairs_t* pairs, size_t count);
+size_t num_kernel_entities(const simulation_t* sim, const kernel_t* kernel);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void parse_options(const int argc, char* argv[], options_t* const options)
+{
+    options->max_entities = DEFAULT_MAX_ENTITIES;
+    options->num_warmups = DEFAULT_NUM_WARMUPS;
+    options->num_repetitions = DEFAULT_NUM_REPETITIONS;
+    options->max_repetition_ms = DEFAULT_MAX_REPETITION_MS;
+    options->time_delta_s = DEFAULT_TIME_STEP_S;
+    options->seed = DEFAULT_SEED;
+    options->kernel = NULL;
+
+    bool valid = true;
+    for(int i = 1; i < argc && valid; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        char* end = NULL;
+
+        if(strcmp(arg, "--max-entities") == 0 && value != NULL) {
+            options->max_entities = strtoul(value, &end, 10);
+            valid = *end == '\0' && options->max_entities <= ENTITY_POOL_MAX_CAPACITY;
+            ++i;
+        }
+        else if(strcmp(arg, "--warmup") == 0 && value != NULL) {
+            options->num_warmups = (uint32_t)strtoul(value, &end, 10);
+            valid = *end == '\0';
+            ++i;
+        }
+        else if(strcmp(arg, "--repetitions") == 0 && value != NULL) {
+            options->num_repetitions = (uint32_t)strtoul(value, &end, 10);
+            valid = *end == '\0' && options->num_repetitions > 0;
+            ++i;
+        }
+        else if(strcmp(arg, "--max-repetition-ms") == 0 && value != NULL) {
+            options->max_repetition_ms = strtod(value, &end);
+            valid = *end == '\0' && options->max_repetition_ms > 0.0;
+            ++i;
+        }
+        else if(strcmp(arg, "--dt") == 0 && value != NULL) {
+            options->time_delta_s = strtof(value, &end);
+            valid = *end == '\0' && options->time_delta_s > 0.0F;
+            ++i;
+        }
+        else if(strcmp(arg, "--seed") == 0 && value != NULL) {
+            options->seed = (uint32_t)strtoul(value, &end, 10);
+            valid = *end == '\0';
+            ++i;
+        }
+        else if(strcmp(arg, "--kernel") == 0 && value != NULL) {
+            valid = false;
+            for(size_t k = 0; k < NUM_KERNELS; ++k) {
+                if(strcmp(value, kernels[k].name) == 0) {
+                    options->kernel = kernels[k].name;
+                    valid = true;
+                }
+            }
+            ++i;
+        }
+        else {
+            valid = false;
+        }
+
+        if(!valid) {
+            fprintf(stderr, "Invalid argument: \"%s\"\n", arg);
+        }
+    }
+
+    if(!valid) {
+        fprintf(stderr, "Usage: %s [--max-entities N] [--warmup N] [--repetitions N] [--max-repetition-ms MS] [--dt SECONDS] [--seed N]\n", argv[0]);
+        fprintf(stderr, "           [--kernel positions|spawning|firing|collisions|collisions_brute_force|bullet_collisions|expiry|animations\n");
+        fprintf(stderr, "             |spawn_projectile|spawn_enemy|spawn_explosion|is_contained|is_collided|is_segment_intersecting]\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void run_kernel(const options_t* const options, const simulation_sprites_t* const sprites, const kernel_t* const kernel, const distribution_t distribution)
+{
+    // Every series starts from a fresh instance, so that it does not depend on which ran before it
+    const simulation_config_t config = {
+        .sprites = sprites,
+        .seed = options->seed,
+        .time_step_s = fixed_from_float(options->time_delta_s),
+        .collision_mode = kernel->collision_mode,
+        .invulnerable = true,
+        .workers = NULL,
+        .parallel_threshold = SIZE_MAX,
+        .separate_passes = false,
+        .clock = simulation_clock_ns
+    };
+    simulation_t sim;
+    simulation_init(&sim, &config);
+    rng_t rng;
+    rng_init(&rng, options->seed);
+    pairs_t pairs = { 0 };
+    if(kernel->measurement == MEASUREMENT_NARROW_PHASE) {
+        pairs.enemy_quads = malloc(options->max_entities * sizeof(SDL_Rect));
+        pairs.projectile_quads = malloc(options->max_entities * sizeof(SDL_Rect));
+        pairs.projectile_centres = malloc(options->max_entities * sizeof(SDL_Point));
+        pairs.projectile_starts = malloc(options->max_entities * sizeof(SDL_Point));
+        if(options->max_entities > 0 && (pairs.enemy_quads == NULL || pairs.projectile_quads == NULL || pairs.projectile_centres == NULL || pairs.projectile_starts == NULL)) {
+            fprintf(stderr, "Failed to allocate %zu narrow-phase pairs\n", options->max_entities);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Counts double from one up to the maximum, which is always measured too, however far it is from a power of two.
+    // Once a repetition takes longer than the limit, larger counts are skipped. That includes setting the pools up and
+    // every other phase of the step, which can grow faster with the count than the kernel being measured.
+    bool is_last = false;
+    for(size_t count = 0; !is_last; count = count == 0 ? 1 : count * 2 > options->max_entities ? options->max_entities : count * 2) {
+        is_last = count == options->max_entities;
+
+        size_t num_entities = 0;
+        for(uint32_t i = 0; i < options->num_warmups; ++i) {
+            measure(&sim, &rng, kernel, distribution, count, &pairs, &num_entities);
+        }
+
+        sample_stats_t ns;
+        sample_stats_t ns_per_entity;
+        sample_stats_init(&ns, options->num_repetitions);
+        sample_stats_init(&ns_per_entity, options->num_repetitions);
+        uint64_t total_entities = 0;
+        uint64_t max_repetition_ns = 0;
+        for(uint32_t i = 0; i < options->num_repetitions; ++i) {
+            const uint64_t start = simulation_clock_ns();
+            const uint64_t elapsed_ns = measure(&sim, &rng, kernel, distribution, count, &pairs, &num_entities);
+            const uint64_t repetition_ns = simulation_clock_ns() - start;
+            max_repetition_ns = repetition_ns > max_repetition_ns ? repetition_ns : max_repetition_ns;
+            sample_stats_add(&ns, (double)elapsed_ns);
+            if(num_entities > 0) {
+                sample_stats_add(&ns_per_entity, (double)elapsed_ns / (double)num_entities);
+            }
+            total_entities += num_entities;
+        }
+
+        printf("%s,%s,%zu,%.1f,%u,%.0f,%.0f,%.1f,%.1f,%.0f,%.3f,%.3f,%.3f\n",
+            kernel->name,
+            distribution_names[distribution],
+            count,
+            (double)total_entities / options->num_repetitions,
+            options->num_repetitions,
+            sample_stats_percentile(&ns, 0.0),
+            sample_stats_percentile(&ns, 50.0),
+            sample_stats_mean(&ns),
+            sample_stats_stddev(&ns),
+            sample_stats_max(&ns),
+            sample_stats_percentile(&ns_per_entity, 50.0),
+            sample_stats_mean(&ns_per_entity),
+            sample_stats_stddev(&ns_per_entity));
+        fflush(stdout);
+
+        is_last = is_last || (double)max_repetition_ns > options->max_repetition_ms * 1e6;
+        sample_stats_destroy(&ns_per_entity);
+        sample_stats_destroy(&ns);
+    }
+
+    free(pairs.projectile_starts);
+    free(pairs.projectile_centres);
+    free(pairs.projectile_quads);
+    free(pairs.enemy_quads);
+    simulation_destroy(&sim);
+}
+
+void prepare_pools(simulation_t* const sim, rng_t* const rng, const kernel_t* const kernel, const distribution_t distribution, const size_t count)
+{
+    // Pools are topped up to the count, and trimmed back to it from the end, since bullets come a whole volley at a time
+    // and each step spawns and destroys entities of its own
+    const size_t num_enemies = kernel->enemies ? count : 0;
+    const size_t num_projectiles = kernel->projectiles ? count : 0;
+    const size_t num_explosions = kernel->explosions ? count : 0;
+    const size_t num_bullets = kernel->bullets ? count : 0;
+    simulation_top_up(sim, num_enemies, num_projectiles, num_explosions, num_bullets);
+    while(sim->enemies.count > num_enemies) {
+        entity_pool_remove(&sim->enemies, sim->enemies.count - 1);
+    }
+    while(sim->projectiles.count > num_projectiles) {
+        entity_pool_remove(&sim->projectiles, sim->projectiles.count - 1);
+    }
+    while(sim->explosions.count > num_explosions) {
+        entity_pool_remove(&sim->explosions, sim->explosions.count - 1);
+    }
+    while(sim->bullets.count > num_bullets) {
+        bullet_pool_remove(&sim->bullets, sim->bullets.count - 1);
+    }
+
+    // Every entity is placed afresh, so that each repetition measures the same distribution however the last one moved
+    // them. Clusters stay within the screen, so that nothing is culled straight away.
+    SDL_Rect region = { .x = 0, .y = 0, .w = SIMULATION_SCREEN_WIDTH, .h = SIMULATION_SCREEN_HEIGHT };
+    if(distribution == DISTRIBUTION_CLUSTERED) {
+        const int32_t x = fixed_to_int(sim->spaceship.position.x) - CLUSTER_SIZE / 2;
+        const int32_t y = fixed_to_int(sim->spaceship.position.y) - CLUSTER_SIZE / 2;
+        region.x = x < 0 ? 0 : x > SIMULATION_SCREEN_WIDTH - CLUSTER_SIZE ? SIMULATION_SCREEN_WIDTH - CLUSTER_SIZE : x;
+        region.y = y < 0 ? 0 : y > SIMULATION_SCREEN_HEIGHT - CLUSTER_SIZE ? SIMULATION_SCREEN_HEIGHT - CLUSTER_SIZE : y;
+        region.w = CLUSTER_SIZE;
+        region.h = CLUSTER_SIZE;
+    }
+    place_entities(&sim->enemies, rng, &region, sim->step, MAX_AGE_STEPS);
+    place_entities(&sim->projectiles, rng, &region, sim->step, MAX_AGE_STEPS);
+    // Explosions are at most as old as their clip, so that only some of them expire
+    place_entities(&sim->explosions, rng, &region, sim->step, animation_clip_length(&sim->explosion_clip) + 1);
+    place_bullets(&sim->bullets, rng, &region, sim->step);
+}
+
+void place_entities(entity_pool_t* const pool, rng_t* const rng, const SDL_Rect* const region, const uint32_t step, const uint32_t max_age_steps)
+{
+    for(size_t i = 0; i < pool->count; ++i) {
+        pool->x[i] = fixed_from_int(region->x + (int32_t)rng_bounded(rng, (uint32_t)region->w));
+        pool->y[i] = fixed_from_int(region->y + (int32_t)rng_bounded(rng, (uint32_t)region->h));
+        pool->prev_y[i] = pool->y[i];
+        pool->cold[i].spawn_step = step - rng_bounded(rng, max_age_steps);
+    }
+}
+
+void place_bullets(bullet_pool_t* const pool, rng_t* const rng, const SDL_Rect* const region, const uint32_t step)
+{
+    for(size_t i = 0; i < pool->count; ++i) {
+        pool->x[i] = fixed_from_int(region->x + (int32_t)rng_bounded(rng, (uint32_t)region->w));
+        pool->y[i] = fixed_from_int(region->y + (int32_t)rng_bounded(rng, (uint32_t)region->h));
+        pool->prev_x[i] = pool->x[i];
+        pool->prev_y[i] = pool->y[i];
+        pool->spawn_step[i] = step - rng_bounded(rng, MAX_AGE_STEPS);
+    }
+}
+
+void gather_pairs(const simulation_t* const sim, pairs_t* const pairs)
+{
+    // Projectiles sweep from where they were a step ago, as the simulation tests them against enemies that stand still
+    for(size_t i = 0; i < sim->projectiles.count; ++i) {
+        pairs->enemy_quads[i] = entity_pool_render_quad(&sim->enemies, i);
+        pairs->projectile_quads[i] = entity_pool_render_quad(&sim->projectiles, i);
+        pairs->projectile_centres[i].x = fixed_to_int(sim->projectiles.x[i]);
+        pairs->projectile_centres[i].y = fixed_to_int(sim->projectiles.y[i]);
+        pairs->projectile_starts[i].x = fixed_to_int(sim->projectiles.x[i]);
+        pairs->projectile_starts[i].y = fixed_to_int(sim->projectiles.y[i] - sim->projectiles.vy[i]);
+    }
+}
+
+uint64_t measure(simulation_t* const sim, rng_t* const rng, const kernel_t* const kernel, const distribution_t distribution, const size_t count, pairs_t* const pairs, size_t* const num_entities)
+{
+    if(kernel->measurement == MEASUREMENT_TOP_UP) {
+        const kernel_t empty = { .name = kernel->name };
+        prepare_pools(sim, rng, &empty, distribution, 0);
+
+        const uint64_t start = simulation_clock_ns();
+        simulation_top_up(sim, kernel->enemies ? count : 0, kernel->projectiles ? count : 0, kernel->explosions ? count : 0, kernel->bullets ? count : 0);
+        const uint64_t elapsed_ns = simulation_clock_ns() - start;
+        *num_entities = simulation_num_entities(sim);
+        return elapsed_ns;
+    }
+
+    if(kernel->measurement == MEASUREMENT_SPAWN) {
+        const kernel_t empty = { .name = kernel->name };
+        prepare_pools(sim, rng, &empty, distribution, 0);
+
+        const uint64_t start = simulation_clock_ns();
+        for(size_t i = 0; i < count; ++i) {
+            if(kernel->projectiles) {
+                simulation_spawn_projectile(sim);
+            }
+            else if(kernel->enemies) {
+                simulation_spawn_enemy(sim);
+            }
+            else {
+                simulation_spawn_explosion(sim, sim->spaceship.position);
+            }
+        }
+        const uint64_t elapsed_ns = simulation_clock_ns() - start;
+        *num_entities = simulation_num_entities(sim);
+        return elapsed_ns;
+    }
+
+    prepare_pools(sim, rng, kernel, distribution, count);
+    *num_entities = num_kernel_entities(sim, kernel);
+
+    if(kernel->measurement == MEASUREMENT_ANIMATIONS) {
+        // As a snapshot does for every entity it draws
+        int32_t sink = 0;
+        const uint64_t start = simulation_clock_ns();
+        const entity_pool_t* pools[] = { &sim->enemies, &sim->projectiles, &sim->explosions };
+        for(size_t p = 0; p < sizeof(pools) / sizeof(pools[0]); ++p) {
+            const entity_pool_t* pool = pools[p];
+            for(size_t i = 0; i < pool->count; ++i) {
+                sink += animation_clip_frame(pool->cold[i].clip, sim->step - pool->cold[i].spawn_step)->x;
+            }
+        }
+        for(size_t i = 0; i < sim->bullets.count; ++i) {
+            sink += animation_clip_frame(&sim->enemy_bullet_clip, sim->step - sim->bullets.spawn_step[i])->x;
+        }
+        const uint64_t elapsed_ns = simulation_clock_ns() - start;
+        result_sink = sink;
+        return elapsed_ns;
+    }
+
+    if(kernel->measurement == MEASUREMENT_NARROW_PHASE) {
+        gather_pairs(sim, pairs);
+        *num_entities = sim->projectiles.count;
+        return measure_narrow_phase(kernel->narrow_phase, pairs, sim->projectiles.count);
+    }
+
+    simulation_step(sim, 0);
+    return sim->phase_times[kernel->phase + 1] - sim->phase_times[kernel->phase];
+}
+
+uint64_t measure_narrow_phase(const narrow_phase_t narrow_phase, const pairs_t* const pairs, const size_t count)
+{
+    // Each test gets a loop of its own, so that choosing between them is not timed
+    int32_t hits = 0;
+    const uint64_t start = simulation_clock_ns();
+    switch(narrow_phase) {
+    case NARROW_PHASE_IS_CONTAINED:
+        for(size_t i = 0; i < count; ++i) {
+            hits += collision_is_contained(&pairs->projectile_centres[i], &pairs->enemy_quads[i]);
+        }
+        break;
+    case NARROW_PHASE_IS_COLLIDED:
+        for(size_t i = 0; i < count; ++i) {
+            hits += collision_is_collided(&pairs->projectile_quads[i], &pairs->enemy_quads[i]);
+        }
+        break;
+    case NARROW_PHASE_IS_SEGMENT_INTERSECTING:
+        for(size_t i = 0; i < count; ++i) {
+            float t = 0.0F;
+            hits += collision_is_segment_intersecting(&pairs->projectile_starts[i], &pairs->projectile_centres[i], &pairs->enemy_quads[i], &t);
+        }
+        break;
+    }
+    const uint64_t elapsed_ns = simulation_clock_ns() - start;
+    result_sink = hits;
+    return elapsed_ns;
+}
+
+size_t num_kernel_entities(const simulation_t* const sim, const kernel_t* const kernel)
+{
+    return (kernel->enemies ? sim->enemies.count : 0) + (kernel->projectiles ? sim->projectiles.count : 0) + (kernel->explosions ? sim->explosions.count : 0) + (kernel->bullets ? sim->bullets.count : 0);
+}
+
+// ============================================================================
+// Main entry point
+// ============================================================================
+
+int main(int argc, char* argv[])
+{
+    options_t options;
+    parse_options(argc, argv, &options);
+
+    simulation_sprites_t sprites;
+    simulation_sprites_open(&sprites, ASSET_PACK_FILENAME);
+
+    // One row per kernel, distribution and entity count, so that runs from different builds can be diffed. Times are in
+    // nanoseconds, and per-entity times are left at zero for empty pools.
+    printf("kernel,distribution,count,entities,repetitions,min_ns,median_ns,mean_ns,stddev_ns,max_ns,median_ns_per_entity,mean_ns_per_entity,stddev_ns_per_entity\n");
+    for(size_t k = 0; k < NUM_KERNELS; ++k) {
+        if(options.kernel != NULL && strcmp(options.kernel, kernels[k].name) != 0) {
+            continue;
+        }
+        for(int distribution = 0; distribution < DISTRIBUTIONS_TOTAL; ++distribution) {
+            run_kernel(&options, &sprites, &kernels[k], (distribution_t)distribution);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
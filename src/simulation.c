@@ -0,0 +1,787 @@
+#include "simulation.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "collision.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Every animation shows each of its frames for two steps at 60 Hz
+#define ANIMATION_FRAME_DURATION_S (2.0F / 60.0F)
+
+#define SPACESHIP_VELOCITY_PPS 320
+#define SPACESHIP_FIRERATE_PPS 3
+
+#define PROJECTILE_VELOCITY_PPS 640
+
+#define ENEMY_VELOCITY_PPS 160
+#define ENEMY_SPAWN_RATE_EPS 1
+
+// Bullets are small and numerous, so their pool starts out larger than the others
+#define BULLET_POOL_INITIAL_CAPACITY 1024
+
+// Entity pools start at this capacity, and grow as far as they need to
+#define ENTITY_POOL_INITIAL_CAPACITY 64
+
+#define COLLISION_GRID_CELL_SIZE 64
+
+// Entity update passes split across workers are split into chunks of this many entities, which start on a whole number
+// of SIMD lanes
+#define PARALLEL_UPDATE_CHUNK_SIZE 1024
+
+// The background scrolls up by a pixel every this many steps, and wraps round once it reaches the top of its sheet
+#define BACKGROUND_STEPS_PER_SCROLL 4
+#define BACKGROUND_SCROLL_HEIGHT 304
+
+// The patterns enemies fire, taken in turn by each enemy as it is spawned
+static const bullet_pattern_t enemy_bullet_patterns[SIMULATION_NUM_ENEMY_BULLET_PATTERNS] = {
+    { .kind = BULLET_PATTERN_AIMED, .num_bullets = 3, .arc_deg = 30.0F, .spin_deg = 0.0F, .interval_s = 1.5F, .velocity_pps = 200 },
+    { .kind = BULLET_PATTERN_RADIAL, .num_bullets = 12, .arc_deg = 360.0F, .spin_deg = 0.0F, .interval_s = 2.0F, .velocity_pps = 120 },
+    { .kind = BULLET_PATTERN_SPIRAL, .num_bullets = 4, .arc_deg = 360.0F, .spin_deg = 15.0F, .interval_s = 0.25F, .velocity_pps = 140 }
+};
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void init_animation_clips(simulation_t* sim);
+static void init_bullet_patterns(simulation_t* sim);
+static void apply_input(simulation_t* sim, simulation_input_t input);
+static void end_phase(simulation_t* sim, int phase);
+
+static void expire_explosions(simulation_t* sim);
+static void update_background(simulation_t* sim);
+static void update_entity_positions(simulation_t* sim);
+static void hold_positions(simulation_t* sim);
+static void update_entity_pool(simulation_t* sim, entity_pool_t* pool, fixed_t min_y, fixed_t max_y);
+static void update_bullet_pool(simulation_t* sim, bullet_pool_t* pool, fixed_t min_x, fixed_t min_y, fixed_t max_x, fixed_t max_y);
+static bool is_update_split(const simulation_t* sim, size_t count);
+static void run_entity_job(simulation_t* sim, worker_pool_job_t job, void* data, size_t count);
+static void integrate_positions_job(void* data, size_t begin, size_t end);
+static void integrate_bullets_job(void* data, size_t begin, size_t end);
+static void spawn_entities(simulation_t* sim);
+static void fire_enemy_bullets(simulation_t* sim);
+
+static void check_collisions(simulation_t* sim);
+static void check_collisions_brute_force(simulation_t* sim);
+static void check_collisions_broadphase(simulation_t* sim);
+static bool is_spaceship_collided_broadphase(const simulation_t* sim);
+static void check_bullet_collisions(simulation_t* sim);
+static bool is_projectile_hitting_enemy(const simulation_t* sim, size_t projectile, size_t enemy, float* t);
+
+static void scatter_coordinates(simulation_t* sim, fixed_t* coordinates, size_t count, int32_t extent);
+
+static fixed_t velocity_per_step(const simulation_t* sim, int32_t velocity_pps);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void simulation_sprites_load(simulation_sprites_t* const sprites, const asset_pack_t* const assets)
+{
+    asset_pack_copy_quads(assets, ATLAS_SHEET_BACKGROUND, &sprites->background, BACKGROUND_SPRITES_TOTAL);
+    asset_pack_copy_quads(assets, ATLAS_SHEET_SPACESHIP, sprites->spaceship, SPACESHIP_SPRITES_TOTAL);
+    asset_pack_copy_quads(assets, ATLAS_SHEET_PROJECTILE, sprites->projectile, PROJECTILE_SPRITES_TOTAL);
+    asset_pack_copy_quads(assets, ATLAS_SHEET_SMALL_ENEMY, sprites->small_enemy, SMALL_ENEMY_SPRITES_TOTAL);
+    asset_pack_copy_quads(assets, ATLAS_SHEET_EXPLOSION, sprites->explosion, EXPLOSION_TOTAL);
+    sprites->background_sheet_y = assets->sheets[ATLAS_SHEET_BACKGROUND].placement.y;
+}
+
+void simulation_sprites_open(simulation_sprites_t* const sprites, const char* const filename)
+{
+    asset_pack_t assets;
+    asset_pack_open(&assets, filename);
+    simulation_sprites_load(sprites, &assets);
+    asset_pack_close(&assets);
+}
+
+uint64_t simulation_clock_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void simulation_init(simulation_t* const sim, const simulation_config_t* const config)
+{
+    const simulation_sprites_t* sprites = config->sprites;
+
+    sim->config = *config;
+    sim->step = 0;
+    sim->game_over = false;
+    sim->input = 0;
+
+    init_animation_clips(sim);
+    init_bullet_patterns(sim);
+
+    sim->spaceship.sprite_scaling = 2;
+    sim->spaceship.position.x = fixed_from_int(SIMULATION_SCREEN_WIDTH / 2);
+    sim->spaceship.position.y = fixed_from_int(SIMULATION_SCREEN_HEIGHT - 1 - sprites->spaceship[SPACESHIP_STATIONARY_1].h * sim->spaceship.sprite_scaling / 2);
+    sim->spaceship.previous_position = sim->spaceship.position;
+    sim->spaceship.velocity.x = 0;
+    sim->spaceship.velocity.y = 0;
+    sim->spaceship.render_quad.x = 0;
+    sim->spaceship.render_quad.y = 0;
+    sim->spaceship.render_quad.w = sprites->spaceship[SPACESHIP_STATIONARY_1].w * sim->spaceship.sprite_scaling;
+    sim->spaceship.render_quad.h = sprites->spaceship[SPACESHIP_STATIONARY_1].h * sim->spaceship.sprite_scaling;
+    sim->spaceship.is_firing = false;
+    sim->spaceship.time_till_next_shot_s = 0;
+    sim->spaceship.is_invulnerable = config->invulnerable;
+
+    entity_pool_init(&sim->projectiles, ENTITY_POOL_INITIAL_CAPACITY);
+    entity_pool_init(&sim->enemies, ENTITY_POOL_INITIAL_CAPACITY);
+    spatial_grid_init(&sim->enemy_grid, SIMULATION_SCREEN_WIDTH, SIMULATION_SCREEN_HEIGHT, COLLISION_GRID_CELL_SIZE);
+    entity_pool_init(&sim->explosions, ENTITY_POOL_INITIAL_CAPACITY);
+    sim->time_till_next_enemy_spawn_s = 0;
+    sim->num_enemies_spawned = 0;
+    bullet_pool_init(&sim->bullets, BULLET_POOL_INITIAL_CAPACITY);
+
+    sim->background_quad = sprites->background;
+    sim->background_counter = 0;
+
+    rng_t seed_rng;
+    rng_init(&seed_rng, config->seed);
+    sim->spawn_rng = rng_split(&seed_rng);
+    sim->scenario_rng = rng_split(&seed_rng);
+
+    memset(sim->phase_times, 0, sizeof(sim->phase_times));
+}
+
+void simulation_destroy(simulation_t* const sim)
+{
+    bullet_pool_destroy(&sim->bullets);
+    entity_pool_destroy(&sim->explosions);
+    spatial_grid_destroy(&sim->enemy_grid);
+    entity_pool_destroy(&sim->enemies);
+    entity_pool_destroy(&sim->projectiles);
+}
+
+void simulation_step(simulation_t* const sim, const simulation_input_t input)
+{
+    if(sim->config.clock != NULL) {
+        sim->phase_times[0] = sim->config.clock();
+    }
+
+    apply_input(sim, input);
+
+    expire_explosions(sim);
+    end_phase(sim, SIMULATION_PHASE_EXPIRY);
+
+    if(!sim->game_over) {
+        update_background(sim);
+        end_phase(sim, SIMULATION_PHASE_BACKGROUND);
+
+        update_entity_positions(sim);
+        end_phase(sim, SIMULATION_PHASE_POSITIONS);
+
+        spawn_entities(sim);
+        end_phase(sim, SIMULATION_PHASE_SPAWNING);
+
+        check_collisions(sim);
+        end_phase(sim, SIMULATION_PHASE_COLLISIONS);
+    }
+    else {
+        hold_positions(sim);
+        for(int phase = SIMULATION_PHASE_BACKGROUND; phase < SIMULATION_PHASES_TOTAL; ++phase) {
+            sim->phase_times[phase + 1] = sim->phase_times[phase];
+        }
+    }
+
+    ++sim->step;
+}
+
+void simulation_top_up(simulation_t* const sim, const size_t min_enemies, const size_t min_projectiles, const size_t min_explosions, const size_t min_bullets)
+{
+    // Each pool is topped up first, then the new entities' coordinates are drawn in bulk
+    const size_t first_enemy = sim->enemies.count;
+    while(sim->enemies.count < min_enemies) {
+        simulation_spawn_enemy(sim);
+    }
+    const size_t num_enemies = sim->enemies.count - first_enemy;
+    scatter_coordinates(sim, &sim->enemies.y[first_enemy], num_enemies, SIMULATION_SCREEN_HEIGHT);
+    memcpy(&sim->enemies.prev_y[first_enemy], &sim->enemies.y[first_enemy], num_enemies * sizeof(fixed_t));
+
+    const size_t first_projectile = sim->projectiles.count;
+    while(sim->projectiles.count < min_projectiles) {
+        simulation_spawn_projectile(sim);
+    }
+    const size_t num_projectiles = sim->projectiles.count - first_projectile;
+    scatter_coordinates(sim, &sim->projectiles.x[first_projectile], num_projectiles, SIMULATION_SCREEN_WIDTH);
+    scatter_coordinates(sim, &sim->projectiles.y[first_projectile], num_projectiles, SIMULATION_SCREEN_HEIGHT);
+    memcpy(&sim->projectiles.prev_y[first_projectile], &sim->projectiles.y[first_projectile], num_projectiles * sizeof(fixed_t));
+
+    const size_t first_explosion = sim->explosions.count;
+    while(sim->explosions.count < min_explosions) {
+        const vector_t p = { .x = 0, .y = 0 };
+        simulation_spawn_explosion(sim, p);
+    }
+    const size_t num_explosions = sim->explosions.count - first_explosion;
+    scatter_coordinates(sim, &sim->explosions.x[first_explosion], num_explosions, SIMULATION_SCREEN_WIDTH);
+    scatter_coordinates(sim, &sim->explosions.y[first_explosion], num_explosions, SIMULATION_SCREEN_HEIGHT);
+    memcpy(&sim->explosions.prev_y[first_explosion], &sim->explosions.y[first_explosion], num_explosions * sizeof(fixed_t));
+
+    // Each volley is the first of a pattern fired from somewhere on the screen
+    while(sim->bullets.count < min_bullets) {
+        const bullet_pattern_t* pattern = &sim->enemy_bullet_patterns[rng_bounded(&sim->scenario_rng, SIMULATION_NUM_ENEMY_BULLET_PATTERNS)];
+        const fixed_t x = fixed_from_int((int32_t)rng_bounded(&sim->scenario_rng, SIMULATION_SCREEN_WIDTH));
+        const fixed_t y = fixed_from_int((int32_t)rng_bounded(&sim->scenario_rng, SIMULATION_SCREEN_HEIGHT));
+        bullet_pattern_fire(pattern, pattern->steps_per_volley - 1, &sim->bullets, x, y, sim->spaceship.position.x, sim->spaceship.position.y, sim->step);
+    }
+}
+
+uint64_t simulation_checksum(const simulation_t* const sim)
+{
+    // FNV-1a over everything that determines how the simulation continues. The background scroll is taken relative to
+    // its sheet, so that recordings still match after the atlas is repacked.
+    uint64_t hash = 14695981039346656037ULL;
+    const int32_t values[] = {
+        (int32_t)sim->step,
+        sim->game_over ? 1 : 0,
+        sim->spaceship.position.x,
+        sim->spaceship.position.y,
+        sim->spaceship.velocity.x,
+        sim->spaceship.velocity.y,
+        sim->spaceship.time_till_next_shot_s,
+        sim->time_till_next_enemy_spawn_s,
+        (int32_t)sim->num_enemies_spawned,
+        sim->background_quad.y - sim->config.sprites->background_sheet_y
+    };
+    for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        hash = (hash ^ (uint32_t)values[i]) * 1099511628211ULL;
+    }
+    // Both streams, since the next top-up draws from the scenario stream just as spawning draws from the other
+    const rng_t* rngs[] = { &sim->spawn_rng, &sim->scenario_rng };
+    for(size_t r = 0; r < sizeof(rngs) / sizeof(rngs[0]); ++r) {
+        for(size_t i = 0; i < sizeof(rngs[r]->s) / sizeof(rngs[r]->s[0]); ++i) {
+            hash = (hash ^ (uint32_t)rngs[r]->s[i]) * 1099511628211ULL;
+            hash = (hash ^ (uint32_t)(rngs[r]->s[i] >> 32)) * 1099511628211ULL;
+        }
+    }
+
+    const entity_pool_t* pools[] = { &sim->projectiles, &sim->enemies, &sim->explosions };
+    for(size_t p = 0; p < sizeof(pools) / sizeof(pools[0]); ++p) {
+        const entity_pool_t* pool = pools[p];
+        hash = (hash ^ pool->count) * 1099511628211ULL;
+        for(size_t i = 0; i < pool->count; ++i) {
+            hash = (hash ^ (uint32_t)pool->x[i]) * 1099511628211ULL;
+            hash = (hash ^ (uint32_t)pool->y[i]) * 1099511628211ULL;
+            hash = (hash ^ (uint32_t)pool->vy[i]) * 1099511628211ULL;
+            hash = (hash ^ pool->cold[i].spawn_step) * 1099511628211ULL;
+        }
+    }
+
+    const bullet_pool_t* bullets = &sim->bullets;
+    hash = (hash ^ bullets->count) * 1099511628211ULL;
+    for(size_t i = 0; i < bullets->count; ++i) {
+        hash = (hash ^ (uint32_t)bullets->x[i]) * 1099511628211ULL;
+        hash = (hash ^ (uint32_t)bullets->y[i]) * 1099511628211ULL;
+        hash = (hash ^ (uint32_t)bullets->vx[i]) * 1099511628211ULL;
+        hash = (hash ^ (uint32_t)bullets->vy[i]) * 1099511628211ULL;
+        hash = (hash ^ bullets->spawn_step[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+size_t simulation_num_entities(const simulation_t* const sim)
+{
+    return sim->projectiles.count + sim->enemies.count + sim->explosions.count + sim->bullets.count;
+}
+
+static void init_animation_clips(simulation_t* const sim)
+{
+    // Each clip runs through consecutive quads in its sheet. Only the first two explosion frames are used.
+    const simulation_sprites_t* sprites = sim->config.sprites;
+    sim->spaceship_stationary_clip = (animation_clip_t){ .frames = &sprites->spaceship[SPACESHIP_STATIONARY_1], .num_frames = 2, .frame_duration_s = ANIMATION_FRAME_DURATION_S, .loops = true };
+    sim->spaceship_bank_hard_left_clip = (animation_clip_t){ .frames = &sprites->spaceship[SPACESHIP_BANK_HARD_LEFT_1], .num_frames = 2, .frame_duration_s = ANIMATION_FRAME_DURATION_S, .loops = true };
+    sim->spaceship_bank_hard_right_clip = (animation_clip_t){ .frames = &sprites->spaceship[SPACESHIP_BANK_HARD_RIGHT_1], .num_frames = 2, .frame_duration_s = ANIMATION_FRAME_DURATION_S, .loops = true };
+    sim->projectile_clip = (animation_clip_t){ .frames = &sprites->projectile[PROJECTILE_1], .num_frames = 2, .frame_duration_s = ANIMATION_FRAME_DURATION_S, .loops = true };
+    sim->small_enemy_clip = (animation_clip_t){ .frames = &sprites->small_enemy[SMALL_ENEMY_1], .num_frames = 2, .frame_duration_s = ANIMATION_FRAME_DURATION_S, .loops = true };
+    sim->explosion_clip = (animation_clip_t){ .frames = &sprites->explosion[EXPLOSION_1], .num_frames = 2, .frame_duration_s = ANIMATION_FRAME_DURATION_S, .loops = false };
+    sim->enemy_bullet_clip = (animation_clip_t){ .frames = &sprites->projectile[PROJECTILE_ORB_1], .num_frames = 2, .frame_duration_s = ANIMATION_FRAME_DURATION_S, .loops = true };
+
+    animation_clip_t* clips[] = {
+        &sim->spaceship_stationary_clip,
+        &sim->spaceship_bank_hard_left_clip,
+        &sim->spaceship_bank_hard_right_clip,
+        &sim->projectile_clip,
+        &sim->small_enemy_clip,
+        &sim->explosion_clip,
+        &sim->enemy_bullet_clip
+    };
+    for(size_t i = 0; i < sizeof(clips) / sizeof(clips[0]); ++i) {
+        animation_clip_init(clips[i], sim->config.time_step_s);
+    }
+}
+
+static void init_bullet_patterns(simulation_t* const sim)
+{
+    for(size_t i = 0; i < SIMULATION_NUM_ENEMY_BULLET_PATTERNS; ++i) {
+        sim->enemy_bullet_patterns[i] = enemy_bullet_patterns[i];
+        bullet_pattern_init(&sim->enemy_bullet_patterns[i], sim->config.time_step_s);
+    }
+}
+
+static void apply_input(simulation_t* const sim, const simulation_input_t input)
+{
+    // The spaceship moves in the direction of whichever arrows are held, and releasing fire lets it fire again straight
+    // away the next time it is pressed
+    const fixed_t velocity = fixed_from_int(SPACESHIP_VELOCITY_PPS);
+    sim->spaceship.velocity.x = ((input & SIMULATION_INPUT_RIGHT) ? velocity : 0) - ((input & SIMULATION_INPUT_LEFT) ? velocity : 0);
+    sim->spaceship.velocity.y = ((input & SIMULATION_INPUT_DOWN) ? velocity : 0) - ((input & SIMULATION_INPUT_UP) ? velocity : 0);
+
+    const bool is_firing = (input & SIMULATION_INPUT_FIRE) != 0;
+    if(sim->spaceship.is_firing && !is_firing) {
+        sim->spaceship.time_till_next_shot_s = 0;
+    }
+    sim->spaceship.is_firing = is_firing;
+    sim->input = input;
+}
+
+static void end_phase(simulation_t* const sim, const int phase)
+{
+    if(sim->config.clock != NULL) {
+        sim->phase_times[phase + 1] = sim->config.clock();
+    }
+}
+
+static void expire_explosions(simulation_t* const sim)
+{
+    // Explosions play once, and are removed as soon as they have played through
+    const uint32_t lifetime = animation_clip_length(&sim->explosion_clip);
+    for(size_t i = 0; i < sim->explosions.count;) {
+        if(sim->step - sim->explosions.cold[i].spawn_step >= lifetime) {
+            entity_pool_remove(&sim->explosions, i);
+            continue;
+        }
+        ++i;
+    }
+}
+
+static void update_background(simulation_t* const sim)
+{
+    sim->background_counter++;
+    if(sim->background_counter != BACKGROUND_STEPS_PER_SCROLL) {
+        return;
+    }
+    sim->background_counter = 0;
+
+    // The background quad is in atlas coordinates, so scroll it relative to where its sheet was placed
+    const int32_t sheet_y = sim->config.sprites->background_sheet_y;
+    if(sim->background_quad.y != sheet_y) {
+        sim->background_quad.y -= 1;
+    }
+    else {
+        sim->background_quad.y = sheet_y + BACKGROUND_SCROLL_HEIGHT;
+    }
+}
+
+static void update_entity_positions(simulation_t* const sim)
+{
+    // Update the spaceship's position, keeping the last one to interpolate from
+    spaceship_t* spaceship = &sim->spaceship;
+    spaceship->previous_position = spaceship->position;
+    spaceship->position.x += fixed_mul(spaceship->velocity.x, sim->config.time_step_s);
+    spaceship->position.y += fixed_mul(spaceship->velocity.y, sim->config.time_step_s);
+    const fixed_t spaceship_min_x = fixed_from_int(spaceship->render_quad.w / 2);
+    const fixed_t spaceship_max_x = fixed_from_int(SIMULATION_SCREEN_WIDTH - (spaceship->render_quad.w / 2));
+    const fixed_t spaceship_min_y = fixed_from_int(spaceship->render_quad.h / 2);
+    const fixed_t spaceship_max_y = fixed_from_int(SIMULATION_SCREEN_HEIGHT - (spaceship->render_quad.h / 2));
+    spaceship->position.x = spaceship->position.x < spaceship_min_x ? spaceship_min_x : spaceship->position.x;
+    spaceship->position.x = spaceship->position.x >= spaceship_max_x ? (spaceship_max_x - FIXED_ONE) : spaceship->position.x;
+    spaceship->position.y = spaceship->position.y < spaceship_min_y ? spaceship_min_y : spaceship->position.y;
+    spaceship->position.y = spaceship->position.y >= spaceship_max_y ? (spaceship_max_y - FIXED_ONE) : spaceship->position.y;
+    // Update the spaceship's rendering quad origin
+    spaceship->render_quad.x = fixed_to_int(spaceship->position.x) - spaceship->render_quad.w / 2;
+    spaceship->render_quad.y = fixed_to_int(spaceship->position.y) - spaceship->render_quad.h / 2;
+
+    // Update all projectiles' and enemies' positions, and remove those that have exited the screen
+    update_entity_pool(sim, &sim->projectiles, 0, INT32_MAX);
+    update_entity_pool(sim, &sim->enemies, INT32_MIN, fixed_from_int(SIMULATION_SCREEN_HEIGHT));
+
+    // Update all bullets' positions, and remove those that have left the screen entirely, on any side
+    const int32_t bullet_margin = sim->enemy_bullet_clip.frames[0].w * SIMULATION_ENEMY_BULLET_SPRITE_SCALING / 2;
+    update_bullet_pool(sim, &sim->bullets, fixed_from_int(-bullet_margin), fixed_from_int(-bullet_margin), fixed_from_int(SIMULATION_SCREEN_WIDTH + bullet_margin), fixed_from_int(SIMULATION_SCREEN_HEIGHT + bullet_margin));
+}
+
+static void hold_positions(simulation_t* const sim)
+{
+    // Nothing moves once the game is over, so every previous position catches up with the current one, and rendering
+    // stops interpolating between the last two positions each entity had
+    sim->spaceship.previous_position = sim->spaceship.position;
+    entity_pool_t* pools[] = { &sim->projectiles, &sim->enemies, &sim->explosions };
+    for(size_t p = 0; p < sizeof(pools) / sizeof(pools[0]); ++p) {
+        memcpy(pools[p]->prev_y, pools[p]->y, pools[p]->count * sizeof(fixed_t));
+    }
+    memcpy(sim->bullets.prev_x, sim->bullets.x, sim->bullets.count * sizeof(fixed_t));
+    memcpy(sim->bullets.prev_y, sim->bullets.y, sim->bullets.count * sizeof(fixed_t));
+}
+
+static void update_entity_pool(simulation_t* const sim, entity_pool_t* const pool, const fixed_t min_y, const fixed_t max_y)
+{
+    // A single sweep integrates and culls each entity while it is still in cache. Pools large enough to be split between
+    // threads are integrated in parallel instead, and culled serially afterwards, so that the pool's order does not
+    // depend on how the update was split. Both give the same result.
+    if(sim->config.separate_passes || is_update_split(sim, pool->count)) {
+        run_entity_job(sim, integrate_positions_job, pool, pool->count);
+        entity_pool_cull_y_outside(pool, min_y, max_y);
+    }
+    else {
+        entity_pool_integrate_cull_y(pool, min_y, max_y);
+    }
+}
+
+static void update_bullet_pool(simulation_t* const sim, bullet_pool_t* const pool, const fixed_t min_x, const fixed_t min_y, const fixed_t max_x, const fixed_t max_y)
+{
+    // As update_entity_pool()
+    if(sim->config.separate_passes || is_update_split(sim, pool->count)) {
+        run_entity_job(sim, integrate_bullets_job, pool, pool->count);
+        bullet_pool_cull_outside(pool, min_x, min_y, max_x, max_y);
+    }
+    else {
+        bullet_pool_integrate_cull(pool, min_x, min_y, max_x, max_y);
+    }
+}
+
+static bool is_update_split(const simulation_t* const sim, const size_t count)
+{
+    return sim->config.workers != NULL && sim->config.workers->num_threads > 1 && count >= sim->config.parallel_threshold;
+}
+
+static void run_entity_job(simulation_t* const sim, const worker_pool_job_t job, void* const data, const size_t count)
+{
+    if(sim->config.workers != NULL && count >= sim->config.parallel_threshold) {
+        worker_pool_run(sim->config.workers, job, data, count, PARALLEL_UPDATE_CHUNK_SIZE);
+    }
+    else {
+        job(data, 0, count);
+    }
+}
+
+static void integrate_positions_job(void* const data, const size_t begin, const size_t end)
+{
+    entity_pool_integrate_y_range(data, begin, end);
+}
+
+static void integrate_bullets_job(void* const data, const size_t begin, const size_t end)
+{
+    bullet_pool_integrate_range(data, begin, end);
+}
+
+static void spawn_entities(simulation_t* const sim)
+{
+    // If the ship is firing, and is ready to generate a new projectile, then do so now
+    if(sim->spaceship.is_firing) {
+        if(sim->spaceship.time_till_next_shot_s <= 0) {
+            simulation_spawn_projectile(sim);
+            sim->spaceship.time_till_next_shot_s = FIXED_ONE / SPACESHIP_FIRERATE_PPS;
+        }
+        else {
+            sim->spaceship.time_till_next_shot_s -= sim->config.time_step_s;
+        }
+    }
+
+    // If enough time has elapsed, spawn an enemy
+    if(sim->time_till_next_enemy_spawn_s <= 0) {
+        simulation_spawn_enemy(sim);
+        sim->time_till_next_enemy_spawn_s = FIXED_ONE / ENEMY_SPAWN_RATE_EPS;
+    }
+    else {
+        sim->time_till_next_enemy_spawn_s -= sim->config.time_step_s;
+    }
+
+    fire_enemy_bullets(sim);
+}
+
+static void fire_enemy_bullets(simulation_t* const sim)
+{
+    // Every enemy fires from where it is now, in pool order, so that the bullet pool's order is repeatable
+    for(size_t i = 0; i < sim->enemies.count; ++i) {
+        const entity_cold_t* enemy = &sim->enemies.cold[i];
+        const uint32_t age_steps = sim->step - enemy->spawn_step;
+        if(enemy->bullet_pattern != NULL && bullet_pattern_fires(enemy->bullet_pattern, age_steps)) {
+            bullet_pattern_fire(enemy->bullet_pattern, age_steps, &sim->bullets, sim->enemies.x[i], sim->enemies.y[i], sim->spaceship.position.x, sim->spaceship.position.y, sim->step);
+        }
+    }
+}
+
+static void check_collisions(simulation_t* const sim)
+{
+    if(sim->config.collision_mode == COLLISION_MODE_BRUTE_FORCE) {
+        check_collisions_brute_force(sim);
+    }
+    else {
+        check_collisions_broadphase(sim);
+    }
+
+    if(!sim->game_over) {
+        check_bullet_collisions(sim);
+    }
+}
+
+static void check_collisions_brute_force(simulation_t* const sim)
+{
+    // Check enemy and projectile collisions. Each projectile hits the first enemy along its path over the last step, or
+    // of those it reaches at the same moment, the one in the lowest pool slot.
+    for(size_t i = 0; i < sim->projectiles.count;) {
+        size_t hit_slot = sim->enemies.count;
+        float hit_t = 0.0F;
+
+        for(size_t j = 0; j < sim->enemies.count; ++j) {
+            float t = 0.0F;
+            if(is_projectile_hitting_enemy(sim, i, j, &t) && (hit_slot == sim->enemies.count || t < hit_t)) {
+                hit_slot = j;
+                hit_t = t;
+            }
+        }
+
+        if(hit_slot < sim->enemies.count) {
+            const vector_t enemy_position = {
+                .x = sim->enemies.x[hit_slot],
+                .y = sim->enemies.y[hit_slot]
+            };
+            simulation_spawn_explosion(sim, enemy_position);
+            entity_pool_remove(&sim->enemies, hit_slot);
+            entity_pool_remove(&sim->projectiles, i);
+            continue;
+        }
+        ++i;
+    }
+
+    // Check enemy and spaceship collisions
+    for(size_t i = 0; i < sim->enemies.count; ++i) {
+        const SDL_Rect enemy_render_quad = entity_pool_render_quad(&sim->enemies, i);
+        if(collision_is_collided(&sim->spaceship.render_quad, &enemy_render_quad)) {
+            if(!sim->spaceship.is_invulnerable) {
+                simulation_spawn_explosion(sim, sim->spaceship.position);
+                sim->game_over = true;
+            }
+            break;
+        }
+    }
+}
+
+static void check_collisions_broadphase(simulation_t* const sim)
+{
+    spatial_grid_t* grid = &sim->enemy_grid;
+    spatial_grid_build(grid, &sim->enemies);
+
+    // Check enemy and projectile collisions. Any enemy the projectile met over the last step swept through a cell the
+    // projectile swept through too. Of those it hit, the brute-force search picks the first along its path, then the one
+    // in the lowest pool slot, so the same enemy is picked here.
+    for(size_t i = 0; i < sim->projectiles.count;) {
+        size_t hit_slot = sim->enemies.count;
+        float hit_t = 0.0F;
+
+        // The path is padded by a pixel, so that rounding cannot leave a hit just outside the cells searched
+        const int32_t y = fixed_to_int(sim->projectiles.y[i]);
+        const int32_t prev_y = fixed_to_int(sim->projectiles.prev_y[i]);
+        const SDL_Rect projectile_path = {
+            .x = fixed_to_int(sim->projectiles.x[i]) - 1,
+            .y = (y < prev_y ? y : prev_y) - 1,
+            .w = 2,
+            .h = (y < prev_y ? prev_y - y : y - prev_y) + 2
+        };
+        int32_t col_min, col_max, row_min, row_max;
+        spatial_grid_cell_range(grid, &projectile_path, &col_min, &col_max, &row_min, &row_max);
+        for(int32_t row = row_min; row <= row_max; ++row) {
+            for(int32_t col = col_min; col <= col_max; ++col) {
+                size_t num_candidates = 0;
+                const entity_handle_t* candidates = spatial_grid_cell_entries(grid, (size_t)(row * grid->cols + col), &num_candidates);
+                for(size_t k = 0; k < num_candidates; ++k) {
+                    // Enemies destroyed since the grid was built no longer resolve
+                    const size_t slot = entity_pool_resolve(&sim->enemies, candidates[k]);
+                    if(slot == sim->enemies.count) {
+                        continue;
+                    }
+
+                    float t = 0.0F;
+                    if(is_projectile_hitting_enemy(sim, i, slot, &t) && (hit_slot == sim->enemies.count || t < hit_t || (t == hit_t && slot < hit_slot))) {
+                        hit_slot = slot;
+                        hit_t = t;
+                    }
+                }
+            }
+        }
+
+        if(hit_slot < sim->enemies.count) {
+            const vector_t enemy_position = {
+                .x = sim->enemies.x[hit_slot],
+                .y = sim->enemies.y[hit_slot]
+            };
+            simulation_spawn_explosion(sim, enemy_position);
+            entity_pool_remove(&sim->enemies, hit_slot);
+            entity_pool_remove(&sim->projectiles, i);
+            continue;
+        }
+        ++i;
+    }
+
+    // Check enemy and spaceship collisions
+    if(is_spaceship_collided_broadphase(sim) && !sim->spaceship.is_invulnerable) {
+        simulation_spawn_explosion(sim, sim->spaceship.position);
+        sim->game_over = true;
+    }
+}
+
+static bool is_spaceship_collided_broadphase(const simulation_t* const sim)
+{
+    const spatial_grid_t* grid = &sim->enemy_grid;
+
+    int32_t col_min, col_max, row_min, row_max;
+    spatial_grid_cell_range(grid, &sim->spaceship.render_quad, &col_min, &col_max, &row_min, &row_max);
+    for(int32_t row = row_min; row <= row_max; ++row) {
+        for(int32_t col = col_min; col <= col_max; ++col) {
+            size_t num_candidates = 0;
+            const entity_handle_t* candidates = spatial_grid_cell_entries(grid, (size_t)(row * grid->cols + col), &num_candidates);
+            for(size_t k = 0; k < num_candidates; ++k) {
+                const size_t slot = entity_pool_resolve(&sim->enemies, candidates[k]);
+                if(slot == sim->enemies.count) {
+                    continue;
+                }
+
+                const SDL_Rect enemy_render_quad = entity_pool_render_quad(&sim->enemies, slot);
+                if(collision_is_collided(&sim->spaceship.render_quad, &enemy_render_quad)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+static void check_bullet_collisions(simulation_t* const sim)
+{
+    // Bullets are only ever tested against the spaceship, so a SIMD scan over the whole pool takes the place of a
+    // broadphase, and every bullet it finds near the spaceship is tested exactly. As with projectiles and enemies, each
+    // bullet's path is taken relative to the spaceship's movement over the step. An invulnerable spaceship absorbs the
+    // bullets that hit it.
+    const fixed_t dx = sim->spaceship.position.x - sim->spaceship.previous_position.x;
+    const fixed_t dy = sim->spaceship.position.y - sim->spaceship.previous_position.y;
+    bullet_pool_t* bullets = &sim->bullets;
+    size_t i = 0;
+    while((i = bullet_pool_find_first_near(bullets, i, &sim->spaceship.render_quad, dx, dy)) < bullets->count) {
+        const SDL_Point start = {
+            .x = fixed_to_int(bullets->prev_x[i] + dx),
+            .y = fixed_to_int(bullets->prev_y[i] + dy)
+        };
+        const SDL_Point end = {
+            .x = fixed_to_int(bullets->x[i]),
+            .y = fixed_to_int(bullets->y[i])
+        };
+        float t = 0.0F;
+        if(!collision_is_segment_intersecting(&start, &end, &sim->spaceship.render_quad, &t)) {
+            ++i;
+            continue;
+        }
+
+        if(!sim->spaceship.is_invulnerable) {
+            simulation_spawn_explosion(sim, sim->spaceship.position);
+            sim->game_over = true;
+            return;
+        }
+        bullet_pool_remove(bullets, i);
+    }
+}
+
+static bool is_projectile_hitting_enemy(const simulation_t* const sim, const size_t projectile, const size_t enemy, float* const t)
+{
+    // Both move in a straight line over a step, so the test is made from the enemy's point of view, where the enemy stays
+    // at its current position and the projectile moves relative to it. A projectile that has not moved is tested as a
+    // point, exactly as before it was swept.
+    const fixed_t enemy_dy = sim->enemies.y[enemy] - sim->enemies.prev_y[enemy];
+    const SDL_Point start = {
+        .x = fixed_to_int(sim->projectiles.x[projectile]),
+        .y = fixed_to_int(sim->projectiles.prev_y[projectile] + enemy_dy)
+    };
+    const SDL_Point end = {
+        .x = fixed_to_int(sim->projectiles.x[projectile]),
+        .y = fixed_to_int(sim->projectiles.y[projectile])
+    };
+    const SDL_Rect enemy_render_quad = entity_pool_render_quad(&sim->enemies, enemy);
+    return collision_is_segment_intersecting(&start, &end, &enemy_render_quad, t);
+}
+
+void simulation_spawn_projectile(simulation_t* const sim)
+{
+    const size_t i = entity_pool_push(&sim->projectiles);
+    entity_cold_t* projectile = &sim->projectiles.cold[i];
+
+    sim->projectiles.x[i] = sim->spaceship.position.x;
+    sim->projectiles.y[i] = sim->spaceship.position.y + fixed_from_int(sim->spaceship.render_quad.h / 2);
+    sim->projectiles.prev_y[i] = sim->projectiles.y[i];
+
+    sim->projectiles.vy[i] = velocity_per_step(sim, -PROJECTILE_VELOCITY_PPS);
+
+    projectile->clip = &sim->projectile_clip;
+    projectile->bullet_pattern = NULL;
+    projectile->spawn_step = sim->step;
+    projectile->sprite_scaling = 2;
+
+    projectile->render_w = projectile->clip->frames[0].w * projectile->sprite_scaling;
+    projectile->render_h = projectile->clip->frames[0].h * projectile->sprite_scaling;
+}
+
+void simulation_spawn_enemy(simulation_t* const sim)
+{
+    const size_t i = entity_pool_push(&sim->enemies);
+    entity_cold_t* enemy = &sim->enemies.cold[i];
+
+    enemy->clip = &sim->small_enemy_clip;
+    enemy->bullet_pattern = &sim->enemy_bullet_patterns[sim->num_enemies_spawned++ % SIMULATION_NUM_ENEMY_BULLET_PATTERNS];
+    enemy->spawn_step = sim->step;
+    enemy->sprite_scaling = 2;
+
+    enemy->render_w = enemy->clip->frames[0].w * enemy->sprite_scaling;
+    enemy->render_h = enemy->clip->frames[0].h * enemy->sprite_scaling;
+
+    const int32_t min_x = enemy->render_w / 2;
+    const int32_t max_x = SIMULATION_SCREEN_WIDTH - enemy->render_w / 2;
+
+    const int32_t x_pos = rng_range(&sim->spawn_rng, min_x, max_x);
+
+    sim->enemies.x[i] = fixed_from_int(x_pos);
+    sim->enemies.y[i] = 0;
+    sim->enemies.prev_y[i] = 0;
+
+    sim->enemies.vy[i] = velocity_per_step(sim, ENEMY_VELOCITY_PPS);
+}
+
+void simulation_spawn_explosion(simulation_t* const sim, vector_t p)
+{
+    const size_t i = entity_pool_push(&sim->explosions);
+    entity_cold_t* explosion = &sim->explosions.cold[i];
+
+    sim->explosions.x[i] = p.x;
+    sim->explosions.y[i] = p.y;
+    sim->explosions.prev_y[i] = p.y;
+
+    sim->explosions.vy[i] = 0;
+
+    explosion->clip = &sim->explosion_clip;
+    explosion->bullet_pattern = NULL;
+    explosion->spawn_step = sim->step;
+    explosion->sprite_scaling = 2;
+
+    explosion->render_w = explosion->clip->frames[0].w * explosion->sprite_scaling;
+    explosion->render_h = explosion->clip->frames[0].h * explosion->sprite_scaling;
+}
+
+static void scatter_coordinates(simulation_t* const sim, fixed_t* const coordinates, const size_t count, const int32_t extent)
+{
+    // Whole pixels from 0 up to the extent are drawn straight into the array, then converted to fixed-point in place
+    uint32_t* pixels = (uint32_t*)coordinates;
+    rng_fill_bounded(&sim->scenario_rng, pixels, count, (uint32_t)extent);
+    for(size_t i = 0; i < count; ++i) {
+        coordinates[i] = fixed_from_int((int32_t)pixels[i]);
+    }
+}
+
+static fixed_t velocity_per_step(const simulation_t* const sim, const int32_t velocity_pps)
+{
+    // Pooled entities move at a constant velocity, so it is scaled to a single step once, when they are spawned
+    return fixed_mul(fixed_from_int(velocity_pps), sim->config.time_step_s);
+}
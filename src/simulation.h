@@ -0,0 +1,195 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_rect.h>
+
+#include "animation.h"
+#include "asset_pack.h"
+#include "bullet_pattern.h"
+#include "bullet_pool.h"
+#include "entity_pool.h"
+#include "fixed.h"
+#include "rng.h"
+#include "spatial_grid.h"
+#include "sprites.h"
+#include "worker_pool.h"
+
+// ============================================================================
+// Game simulation
+// ============================================================================
+
+// The playing field, in pixels, which is exactly what the screen shows
+#define SIMULATION_SCREEN_WIDTH 600
+#define SIMULATION_SCREEN_HEIGHT 800
+
+#define SIMULATION_NUM_ENEMY_BULLET_PATTERNS 3
+
+// Enemy bullets are drawn at this multiple of their sprites' size
+#define SIMULATION_ENEMY_BULLET_SPRITE_SCALING 2
+
+// The buttons held down during a step, as a bitmask
+typedef uint32_t simulation_input_t;
+
+enum {
+    SIMULATION_INPUT_UP = 1 << 0,
+    SIMULATION_INPUT_DOWN = 1 << 1,
+    SIMULATION_INPUT_LEFT = 1 << 2,
+    SIMULATION_INPUT_RIGHT = 1 << 3,
+    SIMULATION_INPUT_FIRE = 1 << 4
+};
+
+// The phases of a step, in the order they run
+enum {
+    SIMULATION_PHASE_EXPIRY,
+    SIMULATION_PHASE_BACKGROUND,
+    SIMULATION_PHASE_POSITIONS,
+    SIMULATION_PHASE_SPAWNING,
+    SIMULATION_PHASE_COLLISIONS,
+    SIMULATION_PHASES_TOTAL
+};
+
+typedef enum {
+    COLLISION_MODE_BROADPHASE,
+    COLLISION_MODE_BRUTE_FORCE
+} collision_mode_t;
+
+// Every sprite quad the simulation animates, in atlas coordinates, and where
+// the background's sheet was placed in the atlas, since the background scrolls
+// up its sheet
+typedef struct {
+    SDL_Rect spaceship[SPACESHIP_SPRITES_TOTAL];
+    SDL_Rect projectile[PROJECTILE_SPRITES_TOTAL];
+    SDL_Rect small_enemy[SMALL_ENEMY_SPRITES_TOTAL];
+    SDL_Rect explosion[EXPLOSION_TOTAL];
+    SDL_Rect background;
+    int32_t background_sheet_y;
+} simulation_sprites_t;
+
+typedef struct {
+    // Shared by every instance, and must outlive them
+    const simulation_sprites_t* sprites;
+    uint32_t seed;
+    // The simulated time per step, in fixed-point seconds. Velocities, animations and bullet patterns are all scaled to
+    // it once, as the instance is created, so it cannot change between steps.
+    fixed_t time_step_s;
+    collision_mode_t collision_mode;
+    // The spaceship cannot be destroyed, and absorbs whatever hits it
+    bool invulnerable;
+    // Per-entity update passes are split across these workers once a pool holds at least parallel_threshold entities.
+    // Without any, every step runs entirely on the calling thread.
+    worker_pool_t* workers;
+    size_t parallel_threshold;
+    // Entities are integrated and culled in separate passes, even when a single sweep could do both
+    bool separate_passes;
+    // Returns the current time in ticks of any fixed frequency, for timing each phase of a step. Without a clock,
+    // steps are not timed.
+    uint64_t (*clock)();
+} simulation_config_t;
+
+// A position or velocity, in fixed-point pixels or pixels per second
+typedef struct {
+    fixed_t x;
+    fixed_t y;
+} vector_t;
+
+typedef struct {
+    vector_t position;
+    vector_t previous_position;
+    vector_t velocity;
+    int32_t sprite_scaling;
+    SDL_Rect render_quad;
+    bool is_firing;
+    fixed_t time_till_next_shot_s;
+    bool is_invulnerable;
+} spaceship_t;
+
+// A single game, advanced one fixed step at a time by the input held during
+// that step. Its whole state lives here, so any number of games can run side
+// by side, and a game's steps depend only on its configuration and inputs.
+//
+// Entities point at the instance's own animation clips and bullet patterns, so
+// an instance must not be moved once it has been initialised.
+typedef struct {
+    simulation_config_t config;
+
+    uint32_t step;
+    bool game_over;
+    simulation_input_t input;
+
+    spaceship_t spaceship;
+
+    entity_pool_t projectiles;
+
+    entity_pool_t enemies;
+    spatial_grid_t enemy_grid;
+    fixed_t time_till_next_enemy_spawn_s;
+    uint32_t num_enemies_spawned;
+
+    // Fired by the enemies, and only ever collide with the spaceship
+    bullet_pool_t bullets;
+
+    entity_pool_t explosions;
+
+    // The window onto the background's sheet, in atlas coordinates, and the steps since it last scrolled
+    SDL_Rect background_quad;
+    uint32_t background_counter;
+
+    // Random number streams, both split off the seed. Gameplay spawning has its own, so that the benchmark scenarios'
+    // topping up does not change where the enemies spawn.
+    rng_t spawn_rng;
+    rng_t scenario_rng;
+
+    animation_clip_t spaceship_stationary_clip;
+    animation_clip_t spaceship_bank_hard_left_clip;
+    animation_clip_t spaceship_bank_hard_right_clip;
+    animation_clip_t projectile_clip;
+    animation_clip_t small_enemy_clip;
+    animation_clip_t explosion_clip;
+    animation_clip_t enemy_bullet_clip;
+
+    // The patterns enemies fire, scaled to the instance's time step
+    bullet_pattern_t enemy_bullet_patterns[SIMULATION_NUM_ENEMY_BULLET_PATTERNS];
+
+    // With a clock, the time the last step started, followed by the time each of its phases ended. Phases skipped
+    // after the game is over end as soon as they start.
+    uint64_t phase_times[SIMULATION_PHASES_TOTAL + 1];
+} simulation_t;
+
+// Copies every sprite quad the simulation needs out of the asset pack
+void simulation_sprites_load(simulation_sprites_t* sprites, const asset_pack_t* assets);
+// Loads the sprites from the asset pack with the given filename, which is only mapped while they are copied out of it,
+// since only their sizes matter to the simulation
+void simulation_sprites_open(simulation_sprites_t* sprites, const char* filename);
+
+// A monotonic clock in nanoseconds, for timing steps where SDL's is not available
+uint64_t simulation_clock_ns();
+
+void simulation_init(simulation_t* sim, const simulation_config_t* config);
+void simulation_destroy(simulation_t* sim);
+
+// Advances the game by one step, with the given buttons held throughout it. Once the game is over, only explosions
+// keep playing out.
+void simulation_step(simulation_t* sim, simulation_input_t input);
+
+// Tops each pool up to the given number of live entities, scattering the new ones across the screen from the
+// instance's scenario stream. Bullets are topped up a whole volley at a time.
+void simulation_top_up(simulation_t* sim, size_t min_enemies, size_t min_projectiles, size_t min_explosions, size_t min_bullets);
+
+// Spawns a single entity as the game does: a projectile at the spaceship's nose, an enemy at a random point along the
+// top of the screen, drawn from the gameplay stream, or an explosion at the given position
+void simulation_spawn_projectile(simulation_t* sim);
+void simulation_spawn_enemy(simulation_t* sim);
+void simulation_spawn_explosion(simulation_t* sim, vector_t p);
+
+// Returns a hash of everything that determines how the game continues, which two instances only share if they have
+// been simulated identically
+uint64_t simulation_checksum(const simulation_t* sim);
+
+// Returns the number of live entities of every kind
+size_t simulation_num_entities(const simulation_t* sim);
+
+#endif
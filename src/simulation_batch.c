@@ -0,0 +1,82 @@
+#include "simulation_batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// Instances are handed to the workers in chunks of this many, so that a worker claims enough steps at once to outweigh
+// claiming them, while games that run slower than the rest still even out between workers
+#define BATCH_CHUNK_SIZE 16
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void step_instances_job(void* data, size_t begin, size_t end);
+static void start_game(simulation_batch_t* batch, size_t instance);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void simulation_batch_init(simulation_batch_t* const batch, const size_t num_instances, const simulation_config_t* const config, worker_pool_t* const workers)
+{
+    batch->instances = calloc(num_instances, sizeof(simulation_t));
+    batch->num_games = calloc(num_instances, sizeof(uint32_t));
+    if(batch->instances == NULL || batch->num_games == NULL) {
+        fprintf(stderr, "Failed to allocate a batch of %zu simulations\n", num_instances);
+        exit(EXIT_FAILURE);
+    }
+    batch->num_instances = num_instances;
+    batch->config = *config;
+    batch->config.workers = NULL;
+    batch->workers = workers;
+    batch->inputs = NULL;
+
+    for(size_t i = 0; i < num_instances; ++i) {
+        start_game(batch, i);
+    }
+}
+
+void simulation_batch_destroy(simulation_batch_t* const batch)
+{
+    for(size_t i = 0; i < batch->num_instances; ++i) {
+        simulation_destroy(&batch->instances[i]);
+    }
+    free(batch->num_games);
+    free(batch->instances);
+    batch->num_games = NULL;
+    batch->instances = NULL;
+    batch->num_instances = 0;
+}
+
+void simulation_batch_step(simulation_batch_t* const batch, const simulation_input_t* const inputs)
+{
+    batch->inputs = inputs;
+    worker_pool_run(batch->workers, step_instances_job, batch, batch->num_instances, BATCH_CHUNK_SIZE);
+    batch->inputs = NULL;
+}
+
+static void step_instances_job(void* const data, const size_t begin, const size_t end)
+{
+    simulation_batch_t* batch = data;
+    for(size_t i = begin; i < end; ++i) {
+        if(batch->instances[i].game_over) {
+            simulation_destroy(&batch->instances[i]);
+            start_game(batch, i);
+        }
+        simulation_step(&batch->instances[i], batch->inputs[i]);
+    }
+}
+
+static void start_game(simulation_batch_t* const batch, const size_t instance)
+{
+    // Seeds wrap round, as they do when given on the command line
+    simulation_config_t config = batch->config;
+    config.seed = (uint32_t)(config.seed + instance + (uint64_t)batch->num_games[instance] * batch->num_instances);
+    simulation_init(&batch->instances[instance], &config);
+    ++batch->num_games[instance];
+}
@@ -0,0 +1,41 @@
+#ifndef SIMULATION_BATCH_H
+#define SIMULATION_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simulation.h"
+#include "worker_pool.h"
+
+// ============================================================================
+// Batched simulation
+// ============================================================================
+
+// Many independent games, stepped together across a worker pool. Each instance
+// runs its whole step on one thread, so the instances are split between the
+// workers rather than any one game's entities.
+//
+// Instance i's first game is seeded with the configuration's seed plus i, so
+// it plays out exactly as a single game given that seed and the same inputs.
+// Once a game is over, the instance starts a new one on its next step, seeded
+// num_instances further on than its last.
+typedef struct {
+    simulation_t* instances;
+    size_t num_instances;
+    // The number of games each instance has started
+    uint32_t* num_games;
+    simulation_config_t config;
+    worker_pool_t* workers;
+    // The inputs for the step being run, one per instance
+    const simulation_input_t* inputs;
+} simulation_batch_t;
+
+// Creates num_instances instances from the given configuration, whose own workers are ignored, to be stepped on the
+// given pool
+void simulation_batch_init(simulation_batch_t* batch, size_t num_instances, const simulation_config_t* config, worker_pool_t* workers);
+void simulation_batch_destroy(simulation_batch_t* batch);
+
+// Advances every instance by one step, instance i with inputs[i] held, returning once they have all finished
+void simulation_batch_step(simulation_batch_t* batch, const simulation_input_t* inputs);
+
+#endif
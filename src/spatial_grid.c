@@ -0,0 +1,127 @@
+#include "spatial_grid.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static int32_t clamp_cell(int32_t v, int32_t cell_size, int32_t num_cells);
+static void reserve_entries(spatial_grid_t* grid, size_t capacity);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void spatial_grid_init(spatial_grid_t* const grid, const int32_t width, const int32_t height, const int32_t cell_size)
+{
+    grid->cell_size = cell_size;
+    grid->cols = (width + cell_size - 1) / cell_size;
+    grid->rows = (height + cell_size - 1) / cell_size;
+
+    grid->cell_start = calloc((size_t)(grid->cols * grid->rows) + 1, sizeof(uint32_t));
+    if(grid->cell_start == NULL) {
+        fprintf(stderr, "Failed to allocate a spatial grid of %dx%d cells\n", grid->cols, grid->rows);
+        exit(EXIT_FAILURE);
+    }
+
+    grid->entries = NULL;
+    grid->entry_capacity = 0;
+}
+
+void spatial_grid_destroy(spatial_grid_t* const grid)
+{
+    free(grid->entries);
+    grid->entries = NULL;
+    grid->entry_capacity = 0;
+
+    free(grid->cell_start);
+    grid->cell_start = NULL;
+}
+
+void spatial_grid_build(spatial_grid_t* const grid, const entity_pool_t* const pool)
+{
+    const size_t num_cells = (size_t)(grid->cols * grid->rows);
+
+    // Count the entries in each cell, offset by one so that the prefix sum below leaves each cell's start in place
+    memset(grid->cell_start, 0, (num_cells + 1) * sizeof(uint32_t));
+    for(size_t i = 0; i < pool->count; ++i) {
+        const SDL_Rect swept_quad = entity_pool_swept_quad(pool, i);
+        int32_t col_min, col_max, row_min, row_max;
+        spatial_grid_cell_range(grid, &swept_quad, &col_min, &col_max, &row_min, &row_max);
+        for(int32_t row = row_min; row <= row_max; ++row) {
+            for(int32_t col = col_min; col <= col_max; ++col) {
+                grid->cell_start[(size_t)(row * grid->cols + col) + 1]++;
+            }
+        }
+    }
+    for(size_t cell = 0; cell < num_cells; ++cell) {
+        grid->cell_start[cell + 1] += grid->cell_start[cell];
+    }
+
+    // Fill each cell in ascending entity order, using each cell's start as its write cursor
+    reserve_entries(grid, grid->cell_start[num_cells]);
+    for(size_t i = 0; i < pool->count; ++i) {
+        const SDL_Rect swept_quad = entity_pool_swept_quad(pool, i);
+        int32_t col_min, col_max, row_min, row_max;
+        spatial_grid_cell_range(grid, &swept_quad, &col_min, &col_max, &row_min, &row_max);
+        for(int32_t row = row_min; row <= row_max; ++row) {
+            for(int32_t col = col_min; col <= col_max; ++col) {
+                const size_t cell = (size_t)(row * grid->cols + col);
+                grid->entries[grid->cell_start[cell]++] = entity_pool_handle(pool, i);
+            }
+        }
+    }
+    // The fill pass advanced every cell's start onto the start of the next cell, so shift them back
+    for(size_t cell = num_cells; cell > 0; --cell) {
+        grid->cell_start[cell] = grid->cell_start[cell - 1];
+    }
+    grid->cell_start[0] = 0;
+}
+
+size_t spatial_grid_cell(const spatial_grid_t* const grid, const int32_t x, const int32_t y)
+{
+    const int32_t col = clamp_cell(x, grid->cell_size, grid->cols);
+    const int32_t row = clamp_cell(y, grid->cell_size, grid->rows);
+    return (size_t)(row * grid->cols + col);
+}
+
+void spatial_grid_cell_range(const spatial_grid_t* const grid, const SDL_Rect* const r, int32_t* const col_min, int32_t* const col_max, int32_t* const row_min, int32_t* const row_max)
+{
+    *col_min = clamp_cell(r->x, grid->cell_size, grid->cols);
+    *col_max = clamp_cell(r->x + r->w, grid->cell_size, grid->cols);
+    *row_min = clamp_cell(r->y, grid->cell_size, grid->rows);
+    *row_max = clamp_cell(r->y + r->h, grid->cell_size, grid->rows);
+}
+
+const entity_handle_t* spatial_grid_cell_entries(const spatial_grid_t* const grid, const size_t cell, size_t* const count)
+{
+    *count = grid->cell_start[cell + 1] - grid->cell_start[cell];
+    return &grid->entries[grid->cell_start[cell]];
+}
+
+static int32_t clamp_cell(const int32_t v, const int32_t cell_size, const int32_t num_cells)
+{
+    if(v < 0) {
+        return 0;
+    }
+    const int32_t cell = v / cell_size;
+    return cell < num_cells ? cell : num_cells - 1;
+}
+
+static void reserve_entries(spatial_grid_t* const grid, const size_t capacity)
+{
+    if(capacity <= grid->entry_capacity) {
+        return;
+    }
+
+    free(grid->entries);
+    grid->entries = malloc(capacity * sizeof(entity_handle_t));
+    if(grid->entries == NULL) {
+        fprintf(stderr, "Failed to allocate %zu spatial grid entries\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+    grid->entry_capacity = capacity;
+}
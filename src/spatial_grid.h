@@ -0,0 +1,45 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_rect.h>
+
+#include "entity_pool.h"
+
+// ============================================================================
+// Uniform-grid broadphase
+// ============================================================================
+
+// A uniform grid over the screen, rebuilt from an entity pool's swept quads, so
+// that it finds entities anywhere along their last step of movement. Each cell
+// lists, in ascending pool order at build time, a handle to every entity whose
+// swept quad (inclusive of its far edges) overlaps the cell. Points and
+// quads beyond the edges of the grid are clamped into the outermost cells.
+//
+// Entities removed from the pool after the build stay listed, but their
+// handles no longer resolve.
+typedef struct {
+    int32_t cell_size;
+    int32_t cols;
+    int32_t rows;
+    uint32_t* cell_start;
+    entity_handle_t* entries;
+    size_t entry_capacity;
+} spatial_grid_t;
+
+void spatial_grid_init(spatial_grid_t* grid, int32_t width, int32_t height, int32_t cell_size);
+void spatial_grid_destroy(spatial_grid_t* grid);
+
+// Rebuilds the grid from the swept quads of every entity in the pool
+void spatial_grid_build(spatial_grid_t* grid, const entity_pool_t* pool);
+
+// Returns the index of the cell containing the given point
+size_t spatial_grid_cell(const spatial_grid_t* grid, int32_t x, int32_t y);
+// Returns the inclusive range of cell columns and rows overlapped by the given quad
+void spatial_grid_cell_range(const spatial_grid_t* grid, const SDL_Rect* r, int32_t* col_min, int32_t* col_max, int32_t* row_min, int32_t* row_max);
+// Returns the handles of every entity listed in the given cell
+const entity_handle_t* spatial_grid_cell_entries(const spatial_grid_t* grid, size_t cell, size_t* count);
+
+#endif
@@ -0,0 +1,130 @@
+#include "sprite_batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void reserve_quads(sprite_batch_t* batch, size_t quad_capacity);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void sprite_batch_init(sprite_batch_t* const batch, SDL_Renderer* const renderer, const size_t quad_capacity)
+{
+    batch->renderer = renderer;
+    batch->texture = NULL;
+    batch->texture_w = 0.0F;
+    batch->texture_h = 0.0F;
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->quad_count = 0;
+    batch->quad_capacity = 0;
+
+    reserve_quads(batch, quad_capacity);
+}
+
+void sprite_batch_destroy(sprite_batch_t* const batch)
+{
+    free(batch->indices);
+    batch->indices = NULL;
+
+    free(batch->vertices);
+    batch->vertices = NULL;
+
+    batch->quad_count = 0;
+    batch->quad_capacity = 0;
+    batch->texture = NULL;
+    batch->renderer = NULL;
+}
+
+void sprite_batch_add(sprite_batch_t* const batch, SDL_Texture* const texture, const SDL_Rect* const src, const SDL_FRect* const dst)
+{
+    if(texture != batch->texture) {
+        sprite_batch_flush(batch);
+
+        int w = 0;
+        int h = 0;
+        SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+        batch->texture = texture;
+        batch->texture_w = (float)w;
+        batch->texture_h = (float)h;
+    }
+
+    if(batch->quad_count == batch->quad_capacity) {
+        reserve_quads(batch, batch->quad_capacity * 2);
+    }
+
+    const float u0 = (float)src->x / batch->texture_w;
+    const float v0 = (float)src->y / batch->texture_h;
+    const float u1 = (float)(src->x + src->w) / batch->texture_w;
+    const float v1 = (float)(src->y + src->h) / batch->texture_h;
+
+    const float x0 = dst->x;
+    const float y0 = dst->y;
+    const float x1 = dst->x + dst->w;
+    const float y1 = dst->y + dst->h;
+
+    const SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+    SDL_Vertex* v = &batch->vertices[batch->quad_count * 4];
+    v[0].position.x = x0;
+    v[0].position.y = y0;
+    v[0].tex_coord.x = u0;
+    v[0].tex_coord.y = v0;
+    v[1].position.x = x1;
+    v[1].position.y = y0;
+    v[1].tex_coord.x = u1;
+    v[1].tex_coord.y = v0;
+    v[2].position.x = x0;
+    v[2].position.y = y1;
+    v[2].tex_coord.x = u0;
+    v[2].tex_coord.y = v1;
+    v[3].position.x = x1;
+    v[3].position.y = y1;
+    v[3].tex_coord.x = u1;
+    v[3].tex_coord.y = v1;
+    for(size_t i = 0; i < 4; ++i) {
+        v[i].color = white;
+    }
+
+    ++batch->quad_count;
+}
+
+void sprite_batch_flush(sprite_batch_t* const batch)
+{
+    if(batch->quad_count == 0) {
+        return;
+    }
+
+    SDL_RenderGeometry(batch->renderer, batch->texture, batch->vertices, (int)(batch->quad_count * 4), batch->indices, (int)(batch->quad_count * 6));
+    batch->quad_count = 0;
+}
+
+static void reserve_quads(sprite_batch_t* const batch, const size_t quad_capacity)
+{
+    SDL_Vertex* vertices = realloc(batch->vertices, quad_capacity * 4 * sizeof(SDL_Vertex));
+    int* indices = realloc(batch->indices, quad_capacity * 6 * sizeof(int));
+    if(vertices == NULL || indices == NULL) {
+        fprintf(stderr, "Failed to allocate a sprite batch of %zu quads\n", quad_capacity);
+        exit(EXIT_FAILURE);
+    }
+    batch->vertices = vertices;
+    batch->indices = indices;
+
+    // The index buffer is the same two triangles for every quad, so it is only written as the batch grows
+    for(size_t i = batch->quad_capacity; i < quad_capacity; ++i) {
+        const int base = (int)(i * 4);
+        int* quad_indices = &indices[i * 6];
+        quad_indices[0] = base;
+        quad_indices[1] = base + 1;
+        quad_indices[2] = base + 2;
+        quad_indices[3] = base + 2;
+        quad_indices[4] = base + 1;
+        quad_indices[5] = base + 3;
+    }
+    batch->quad_capacity = quad_capacity;
+}
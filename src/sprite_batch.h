@@ -0,0 +1,35 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <stddef.h>
+
+#include <SDL_rect.h>
+#include <SDL_render.h>
+
+// ============================================================================
+// Batched sprite rendering
+// ============================================================================
+
+// Collects textured quads into a single vertex and index buffer, and submits
+// each run of quads that share a texture with one SDL_RenderGeometry() call.
+// Quads are drawn in the order they are added, so layering is preserved.
+typedef struct {
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    float texture_w;
+    float texture_h;
+    SDL_Vertex* vertices;
+    int* indices;
+    size_t quad_count;
+    size_t quad_capacity;
+} sprite_batch_t;
+
+void sprite_batch_init(sprite_batch_t* batch, SDL_Renderer* renderer, size_t quad_capacity);
+void sprite_batch_destroy(sprite_batch_t* batch);
+
+// Queues a quad, submitting the quads queued so far first if they use a different texture
+void sprite_batch_add(sprite_batch_t* batch, SDL_Texture* texture, const SDL_Rect* src, const SDL_FRect* dst);
+// Submits every queued quad
+void sprite_batch_flush(sprite_batch_t* batch);
+
+#endif
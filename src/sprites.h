@@ -0,0 +1,62 @@
+#ifndef SPRITES_H
+#define SPRITES_H
+
+// ============================================================================
+// Sprite sheets and their sprites
+// ============================================================================
+
+// The sheets packed into the asset pack, in the order they are stored
+enum {
+    ATLAS_SHEET_BACKGROUND,
+    ATLAS_SHEET_SPACESHIP,
+    ATLAS_SHEET_PROJECTILE,
+    ATLAS_SHEET_SMALL_ENEMY,
+    ATLAS_SHEET_EXPLOSION,
+    ATLAS_SHEETS_TOTAL
+};
+
+// The sprites within each sheet, in the order their quads are stored
+
+enum {
+    BACKGROUND_1,
+    BACKGROUND_SPRITES_TOTAL
+};
+
+enum {
+    SPACESHIP_STATIONARY_1,
+    SPACESHIP_STATIONARY_2,
+    SPACESHIP_BANK_LEFT_1,
+    SPACESHIP_BANK_LEFT_2,
+    SPACESHIP_BANK_HARD_LEFT_1,
+    SPACESHIP_BANK_HARD_LEFT_2,
+    SPACESHIP_BANK_RIGHT_1,
+    SPACESHIP_BANK_RIGHT_2,
+    SPACESHIP_BANK_HARD_RIGHT_1,
+    SPACESHIP_BANK_HARD_RIGHT_2,
+    SPACESHIP_SPRITES_TOTAL
+};
+
+enum {
+    PROJECTILE_1,
+    PROJECTILE_2,
+    PROJECTILE_ORB_1,
+    PROJECTILE_ORB_2,
+    PROJECTILE_SPRITES_TOTAL
+};
+
+enum {
+    SMALL_ENEMY_1,
+    SMALL_ENEMY_2,
+    SMALL_ENEMY_SPRITES_TOTAL
+};
+
+enum {
+    EXPLOSION_1,
+    EXPLOSION_2,
+    EXPLOSION_3,
+    EXPLOSION_4,
+    EXPLOSION_5,
+    EXPLOSION_TOTAL
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+// The number of events kept, which must be a power of two. Older events are overwritten.
+#define TRACE_CAPACITY (1 << 16)
+
+typedef enum {
+    TRACE_EVENT_SPAN,
+    TRACE_EVENT_COUNTER
+} trace_event_type_t;
+
+typedef struct {
+    // The index the event was written at plus one, published last so that a reader can tell a complete event
+    // from one that is still being written or has since been overwritten
+    atomic_uint_fast64_t sequence;
+    const char* name;
+    trace_event_type_t type;
+    uint64_t thread_id;
+    uint64_t start;
+    uint64_t end;
+    int64_t value;
+} trace_event_t;
+
+typedef struct {
+    trace_event_t* events;
+    atomic_uint_fast64_t next_idx;
+    uint64_t origin;
+    double us_per_tick;
+} trace_t;
+
+trace_t trace;
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static trace_event_t* claim_event(uint64_t* idx);
+static void publish_event(trace_event_t* event, uint64_t idx);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void trace_init()
+{
+    trace.events = calloc(TRACE_CAPACITY, sizeof(trace_event_t));
+    if(trace.events == NULL) {
+        fprintf(stderr, "Failed to allocate a trace buffer of %d events\n", TRACE_CAPACITY);
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < TRACE_CAPACITY; ++i) {
+        atomic_init(&trace.events[i].sequence, 0);
+    }
+    atomic_init(&trace.next_idx, 0);
+    trace.origin = SDL_GetPerformanceCounter();
+    trace.us_per_tick = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void trace_destroy()
+{
+    free(trace.events);
+    trace.events = NULL;
+}
+
+uint64_t trace_now()
+{
+    return SDL_GetPerformanceCounter();
+}
+
+void trace_span(const char* const name, const uint64_t start, const uint64_t end)
+{
+    uint64_t idx;
+    trace_event_t* event = claim_event(&idx);
+    event->name = name;
+    event->type = TRACE_EVENT_SPAN;
+    event->thread_id = SDL_ThreadID();
+    event->start = start;
+    event->end = end;
+    event->value = 0;
+    publish_event(event, idx);
+}
+
+void trace_counter(const char* const name, const int64_t value)
+{
+    uint64_t idx;
+    trace_event_t* event = claim_event(&idx);
+    event->name = name;
+    event->type = TRACE_EVENT_COUNTER;
+    event->thread_id = SDL_ThreadID();
+    event->start = trace_now();
+    event->end = event->start;
+    event->value = value;
+    publish_event(event, idx);
+}
+
+bool trace_write(const char* const filename)
+{
+    FILE* file = fopen(filename, "w");
+    if(file == NULL) {
+        fprintf(stderr, "Failed to open trace file: \"%s\"\n", filename);
+        return false;
+    }
+
+    // Walk the ring from its oldest surviving event, skipping any that are mid-write or were overwritten while reading
+    const uint64_t end_idx = atomic_load_explicit(&trace.next_idx, memory_order_acquire);
+    const uint64_t start_idx = end_idx > TRACE_CAPACITY ? end_idx - TRACE_CAPACITY : 0;
+    size_t num_written = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for(uint64_t idx = start_idx; idx < end_idx; ++idx) {
+        const trace_event_t* slot = &trace.events[idx & (TRACE_CAPACITY - 1)];
+        if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != idx + 1) {
+            continue;
+        }
+        const trace_event_t event = {
+            .name = slot->name,
+            .type = slot->type,
+            .thread_id = slot->thread_id,
+            .start = slot->start,
+            .end = slot->end,
+            .value = slot->value
+        };
+        atomic_thread_fence(memory_order_acquire);
+        if(atomic_load_explicit(&slot->sequence, memory_order_relaxed) != idx + 1) {
+            continue;
+        }
+
+        const double ts = (double)(event.start - trace.origin) * trace.us_per_tick;
+        fprintf(file, "%s", num_written == 0 ? "" : ",\n");
+        if(event.type == TRACE_EVENT_SPAN) {
+            const double dur = (double)(event.end - event.start) * trace.us_per_tick;
+            fprintf(file, "{\"name\":\"%s\",\"cat\":\"shmupsy\",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}", event.name, (unsigned long long)event.thread_id, ts, dur);
+        }
+        else {
+            fprintf(file, "{\"name\":\"%s\",\"cat\":\"shmupsy\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"%s\":%lld}}", event.name, ts, event.name, (long long)event.value);
+        }
+        ++num_written;
+    }
+    fprintf(file, "\n]}\n");
+
+    const bool written = !ferror(file);
+    if(fclose(file) != 0 || !written) {
+        fprintf(stderr, "Failed to write trace file: \"%s\"\n", filename);
+        return false;
+    }
+
+    printf("Wrote %zu trace events to: \"%s\"\n", num_written, filename);
+    return true;
+}
+
+static trace_event_t* claim_event(uint64_t* const idx)
+{
+    // Each writer claims its own slot, so concurrent writers never share one until the ring wraps
+    *idx = atomic_fetch_add_explicit(&trace.next_idx, 1, memory_order_relaxed);
+    trace_event_t* event = &trace.events[*idx & (TRACE_CAPACITY - 1)];
+    atomic_store_explicit(&event->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return event;
+}
+
+static void publish_event(trace_event_t* const event, const uint64_t idx)
+{
+    atomic_store_explicit(&event->sequence, idx + 1, memory_order_release);
+}
@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// Frame tracing
+// ============================================================================
+
+// Timed spans and counter samples are recorded into a fixed size, lock-free
+// ring buffer, which keeps the most recent events and can be written out as a
+// Chrome trace, viewable in chrome://tracing or https://ui.perfetto.dev.
+//
+// Tracing is only compiled in when SHMUPSY_TRACING is defined. Otherwise every
+// TRACE_ macro expands to nothing, and the trace functions are never called.
+
+#if defined(SHMUPSY_TRACING)
+    #define TRACE_INIT() trace_init()
+    #define TRACE_DESTROY() trace_destroy()
+    // Starts a span, storing its start time in a new local variable with the given name
+    #define TRACE_BEGIN(start) const uint64_t start = trace_now()
+    // Ends the span started with TRACE_BEGIN(start), recording it under the given name
+    #define TRACE_END(start, name) trace_span((name), (start), trace_now())
+    #define TRACE_SPAN(name, start, end) trace_span((name), (start), (end))
+    #define TRACE_COUNTER(name, value) trace_counter((name), (value))
+    #define TRACE_WRITE(filename) trace_write(filename)
+#else
+    #define TRACE_INIT()
+    #define TRACE_DESTROY()
+    #define TRACE_BEGIN(start)
+    #define TRACE_END(start, name)
+    #define TRACE_SPAN(name, start, end)
+    #define TRACE_COUNTER(name, value)
+    #define TRACE_WRITE(filename)
+#endif
+
+void trace_init();
+void trace_destroy();
+
+// Returns the current time, in performance counter ticks
+uint64_t trace_now();
+
+// Records a span on the calling thread. Names must outlive the trace, and are usually string literals.
+void trace_span(const char* name, uint64_t start, uint64_t end);
+// Records a sample of the named counter at the current time
+void trace_counter(const char* name, int64_t value);
+
+// Writes every event still held in the ring buffer to a Chrome trace JSON file, returning whether it succeeded
+bool trace_write(const char* filename);
+
+#endif
@@ -0,0 +1,126 @@
+#include "worker_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Forward declarations
+// ============================================================================
+
+static void* run_worker(void* data);
+static void run_chunks(worker_pool_t* pool);
+
+// ============================================================================
+// Function implementations
+// ============================================================================
+
+void worker_pool_init(worker_pool_t* const pool, const size_t num_threads)
+{
+    pool->num_threads = num_threads > 0 ? num_threads : 1;
+    pool->threads = calloc(pool->num_threads, sizeof(pthread_t));
+    if(pool->threads == NULL || pthread_mutex_init(&pool->mutex, NULL) != 0 || pthread_cond_init(&pool->job_ready, NULL) != 0 || pthread_cond_init(&pool->job_done, NULL) != 0) {
+        fprintf(stderr, "Failed to create a worker pool of %zu threads\n", pool->num_threads);
+        exit(EXIT_FAILURE);
+    }
+    pool->generation = 0;
+    pool->num_busy_workers = 0;
+    pool->quit = false;
+    pool->job = NULL;
+    pool->data = NULL;
+    pool->count = 0;
+    pool->chunk_size = 1;
+    atomic_init(&pool->next_chunk, 0);
+
+    // The calling thread is the first of the pool's threads, so only the rest are created
+    for(size_t i = 1; i < pool->num_threads; ++i) {
+        if(pthread_create(&pool->threads[i], NULL, run_worker, pool) != 0) {
+            fprintf(stderr, "Worker thread could not be created\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void worker_pool_destroy(worker_pool_t* const pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->job_ready);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for(size_t i = 1; i < pool->num_threads; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->job_done);
+    pthread_cond_destroy(&pool->job_ready);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    pool->threads = NULL;
+    pool->num_threads = 0;
+}
+
+void worker_pool_run(worker_pool_t* const pool, const worker_pool_job_t job, void* const data, const size_t count, const size_t chunk_size)
+{
+    // Jobs that fit in one chunk are not worth waking the workers for
+    if(pool->num_threads == 1 || count <= chunk_size) {
+        job(data, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->data = data;
+    pool->count = count;
+    pool->chunk_size = chunk_size;
+    atomic_store_explicit(&pool->next_chunk, 0, memory_order_relaxed);
+    pool->num_busy_workers = pool->num_threads - 1;
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->job_ready);
+    pthread_mutex_unlock(&pool->mutex);
+
+    run_chunks(pool);
+
+    pthread_mutex_lock(&pool->mutex);
+    while(pool->num_busy_workers > 0) {
+        pthread_cond_wait(&pool->job_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void* run_worker(void* const data)
+{
+    worker_pool_t* pool = data;
+    uint64_t generation = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    while(!pool->quit) {
+        if(pool->generation == generation) {
+            pthread_cond_wait(&pool->job_ready, &pool->mutex);
+            continue;
+        }
+        generation = pool->generation;
+
+        pthread_mutex_unlock(&pool->mutex);
+        run_chunks(pool);
+        pthread_mutex_lock(&pool->mutex);
+
+        if(--pool->num_busy_workers == 0) {
+            pthread_cond_signal(&pool->job_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static void run_chunks(worker_pool_t* const pool)
+{
+    // Every thread claims chunks until none are left, so a slow thread simply ends up processing fewer of them
+    const size_t num_chunks = (pool->count + pool->chunk_size - 1) / pool->chunk_size;
+    size_t chunk;
+    while((chunk = atomic_fetch_add_explicit(&pool->next_chunk, 1, memory_order_relaxed)) < num_chunks) {
+        const size_t begin = chunk * pool->chunk_size;
+        const size_t end = begin + pool->chunk_size < pool->count ? begin + pool->chunk_size : pool->count;
+        pool->job(pool->data, begin, end);
+    }
+}
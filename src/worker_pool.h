@@ -0,0 +1,47 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pthread.h>
+
+// ============================================================================
+// Worker pool
+// ============================================================================
+
+// Processes the items in [begin, end)
+typedef void (*worker_pool_job_t)(void* data, size_t begin, size_t end);
+
+// A fixed set of worker threads that split a job's items into chunks between
+// them and the calling thread. Only one thread may run jobs on a pool. Workers
+// are plain POSIX threads, so pools can be used without initialising SDL.
+typedef struct {
+    pthread_t* threads;
+    size_t num_threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t job_ready;
+    pthread_cond_t job_done;
+    // Incremented for every job, so that each worker joins each job exactly once
+    uint64_t generation;
+    size_t num_busy_workers;
+    bool quit;
+
+    worker_pool_job_t job;
+    void* data;
+    size_t count;
+    size_t chunk_size;
+    atomic_size_t next_chunk;
+} worker_pool_t;
+
+// Creates a pool that runs jobs on num_threads threads in total, including the calling thread. A pool of one thread runs
+// every job serially on the calling thread.
+void worker_pool_init(worker_pool_t* pool, size_t num_threads);
+void worker_pool_destroy(worker_pool_t* pool);
+
+// Runs the job over count items in chunks of chunk_size, returning once every chunk has been processed
+void worker_pool_run(worker_pool_t* pool, worker_pool_job_t job, void* data, size_t count, size_t chunk_size);
+
+#endif